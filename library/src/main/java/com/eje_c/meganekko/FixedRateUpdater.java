@@ -0,0 +1,311 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import java.util.Queue;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.locks.Condition;
+import java.util.concurrent.locks.ReentrantLock;
+
+/**
+ * Runs {@link MeganekkoApp#update()} at a fixed rate on its own thread. See
+ * {@link MeganekkoApp#setFixedUpdateRate(int)}.
+ * <p>
+ * Updates never run at the same time as the work which stays on the GL thread: actions of
+ * {@link MeganekkoApp#runOnGlThread(Runnable)}, textures and deleting native objects. The GL thread
+ * skips that work while an update is running, so it never waits for one. Key events which come
+ * while an update is running are delivered on the update thread before the next update. After each
+ * update, the GL thread applies recorded {@link SceneCommands}, takes world matrices of all
+ * objects as a tick, and captures what to draw into a render snapshot. Updates can apply commands
+ * themselves with {@link SceneCommands#flush()}, as they hold the same lock. Frames are rendered
+ * from the snapshot between the last two ticks, one tick behind updates, while the next update runs.
+ */
+final class FixedRateUpdater implements Runnable {
+
+    // Don't catch up more than this many ticks after a stall.
+    private static final int MAX_LATE_TICKS = 4;
+
+    private final MeganekkoApp mApp;
+    private final int mRate;
+    private final long mStepNanos;
+    private final float mStepSeconds;
+    private final long mStartNanos;
+    private final double mStartTime;
+    private final Thread mThread;
+    private final ReentrantLock mLock = new ReentrantLock();
+    private final Condition mCommitted = mLock.newCondition();
+    private final TickFrame mFrame = new TickFrame();
+    private final Queue<PendingKeyEvent> mKeyEvents = new ConcurrentLinkedQueue<>();
+    private volatile boolean mRunning = true;
+
+    // Guarded by mLock.
+    private boolean mTicked;
+    private long mTickNanos;
+    private double mTickTime;
+
+    // Used only on the GL thread.
+    private Scene mScene;
+    private long mCommittedNanos;
+
+    FixedRateUpdater(MeganekkoApp app, int rate, Frame vrFrame) {
+        mApp = app;
+        mRate = rate;
+        mStepNanos = TimeUnit.SECONDS.toNanos(1) / rate;
+        mStepSeconds = 1.0f / rate;
+        mStartNanos = System.nanoTime();
+        mStartTime = vrFrame.getPredictedDisplayTimeInSeconds();
+        mThread = new Thread(this, "Meganekko update");
+        SceneCommands.setReplayLock(mLock);
+        mThread.start();
+    }
+
+    int getRate() {
+        return mRate;
+    }
+
+    boolean isUpdateThread() {
+        return Thread.currentThread() == mThread;
+    }
+
+    Frame getFrame() {
+        return mFrame;
+    }
+
+    /**
+     * Called on the GL thread. Delivers the event now if no update is running, or else just before the
+     * next update, after the events before it.
+     *
+     * @return Result of the delivery, or true if it is queued.
+     */
+    boolean onKeyEvent(int type, int keyCode, int repeatCount) {
+        if (mLock.tryLock()) {
+            try {
+                deliverKeyEvents();
+                return mApp.deliverKeyEvent(type, keyCode, repeatCount);
+            } finally {
+                mLock.unlock();
+            }
+        }
+        mKeyEvents.add(new PendingKeyEvent(type, keyCode, repeatCount));
+        return true;
+    }
+
+    // Called with mLock held.
+    private void deliverKeyEvents() {
+        PendingKeyEvent event;
+        while ((event = mKeyEvents.poll()) != null) {
+            mApp.deliverKeyEvent(event.type, event.keyCode, event.repeatCount);
+        }
+    }
+
+    @Override
+    public void run() {
+        long next = mStartNanos;
+        int tick = 0;
+
+        while (mRunning) {
+            final long wait = next - System.nanoTime();
+            if (wait > 0) {
+                try {
+                    TimeUnit.NANOSECONDS.sleep(wait);
+                } catch (InterruptedException e) {
+                    continue;
+                }
+            }
+
+            mLock.lock();
+            try {
+                // Every tick is committed before the next one, so that interpolation sees each of them.
+                while (mTicked && mRunning) {
+                    mCommitted.awaitUninterruptibly();
+                }
+                if (!mRunning) {
+                    break;
+                }
+
+                final double time = mStartTime + (next - mStartNanos) / (double) TimeUnit.SECONDS.toNanos(1);
+                mFrame.beginTick(time, mStepSeconds, tick);
+                deliverKeyEvents();
+                mApp.update();
+
+                mTicked = true;
+                mTickNanos = next;
+                mTickTime = time;
+            } finally {
+                mLock.unlock();
+            }
+
+            tick++;
+            next += mStepNanos;
+            final long now = System.nanoTime();
+            if (now - next > MAX_LATE_TICKS * mStepNanos) {
+                next = now;
+            }
+        }
+    }
+
+    /**
+     * Called on the GL thread in every frame instead of {@link MeganekkoApp#update()}.
+     */
+    void onFrame(Frame vrFrame) {
+        mFrame.accumulate(vrFrame);
+
+        final Scene scene = mApp.getScene();
+        if (scene != mScene) {
+            if (mScene != null) {
+                mScene.setTickInterpolation(false, 1.0f);
+            }
+            mScene = scene;
+        }
+
+        if (mLock.tryLock()) {
+            try {
+                mApp.updateOnGlThread();
+                SceneCommands.flush();
+
+                // Captures a render snapshot too, since objects can't change until the lock is released.
+                scene.commitTick(mTickTime, mTicked);
+                if (mTicked) {
+                    mCommittedNanos = mTickNanos;
+                    mTicked = false;
+                    mCommitted.signal();
+                }
+            } finally {
+                mLock.unlock();
+            }
+        }
+
+        // Even before the first tick, so that rendering never captures objects while an update runs.
+        final float alpha = (System.nanoTime() - mCommittedNanos) / (float) mStepNanos;
+        scene.setTickInterpolation(true, Math.max(0.0f, Math.min(alpha, 1.0f)));
+    }
+
+    /**
+     * Called on the GL thread. Waits for the running update, and renders the latest state from the
+     * next frame.
+     */
+    void stop() {
+        mRunning = false;
+        mLock.lock();
+        try {
+            mCommitted.signal();
+        } finally {
+            mLock.unlock();
+        }
+        mThread.interrupt();
+
+        try {
+            mThread.join();
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
+
+        deliverKeyEvents();
+        SceneCommands.setReplayLock(null);
+        SceneCommands.flush();
+        if (mScene != null) {
+            mScene.setTickInterpolation(false, 1.0f);
+        }
+    }
+
+    private static final class PendingKeyEvent {
+        final int type;
+        final int keyCode;
+        final int repeatCount;
+
+        PendingKeyEvent(int type, int keyCode, int repeatCount) {
+            this.type = type;
+            this.keyCode = keyCode;
+            this.repeatCount = repeatCount;
+        }
+    }
+
+    /**
+     * {@link Frame} of a tick. Button presses and releases in frames since the last tick are merged.
+     */
+    private static final class TickFrame implements Frame {
+
+        private double mTime;
+        private float mDeltaSeconds;
+        private int mNumber;
+        private float mSwipeFraction;
+        private int mButtonState;
+        private int mButtonPressed;
+        private int mButtonReleased;
+
+        // Guarded by this.
+        private float mPendingSwipeFraction;
+        private int mPendingButtonState;
+        private int mPendingButtonPressed;
+        private int mPendingButtonReleased;
+
+        synchronized void accumulate(Frame vrFrame) {
+            mPendingSwipeFraction = vrFrame.getSwipeFraction();
+            mPendingButtonState = vrFrame.getButtonState();
+            mPendingButtonPressed |= vrFrame.getButtonPressed();
+            mPendingButtonReleased |= vrFrame.getButtonReleased();
+        }
+
+        synchronized void beginTick(double time, float deltaSeconds, int number) {
+            mTime = time;
+            mDeltaSeconds = deltaSeconds;
+            mNumber = number;
+            mSwipeFraction = mPendingSwipeFraction;
+            mButtonState = mPendingButtonState;
+            mButtonPressed = mPendingButtonPressed;
+            mButtonReleased = mPendingButtonReleased;
+            mPendingButtonPressed = 0;
+            mPendingButtonReleased = 0;
+        }
+
+        @Override
+        public double getPredictedDisplayTimeInSeconds() {
+            return mTime;
+        }
+
+        @Override
+        public float getDeltaSeconds() {
+            return mDeltaSeconds;
+        }
+
+        @Override
+        public int getFrameNumber() {
+            return mNumber;
+        }
+
+        @Override
+        public float getSwipeFraction() {
+            return mSwipeFraction;
+        }
+
+        @Override
+        public int getButtonState() {
+            return mButtonState;
+        }
+
+        @Override
+        public int getButtonPressed() {
+            return mButtonPressed;
+        }
+
+        @Override
+        public int getButtonReleased() {
+            return mButtonReleased;
+        }
+    }
+}
@@ -54,14 +54,15 @@ public abstract class HybridObject {
      * You must override this method if you use constructor that don't take
      * nativePointer.
      *
-     * @return native pointer
+     * @return native handle
      */
     protected long initNativeInstance() {
         return 0l;
     }
 
     /**
-     * The actual address of the native object.
+     * The handle of the native object. It is not a memory address; native code
+     * resolves it through its handle table, so the native object can be moved.
      * <p/>
      * This is an internal method that may be useful in diagnostic code.
      */
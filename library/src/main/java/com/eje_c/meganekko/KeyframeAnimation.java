@@ -0,0 +1,249 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import android.support.annotation.NonNull;
+import android.util.SparseArray;
+
+import org.joml.Quaternionf;
+import org.joml.Vector3f;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.List;
+
+/**
+ * Keyframe animation of position, rotation, scale and opacity of a {@link SceneObject}, which is
+ * evaluated in native side on every frame. Unlike {@link SceneObject#animate()}, nothing is called
+ * in Java side while it is running; only {@link #onEnd(Runnable)} is called when it finishes.
+ * <pre>
+ * new KeyframeAnimation(obj)
+ *         .position(0, 0, 0, -5)
+ *         .position(1, 0, 1, -5, KeyframeAnimation.Easing.OUT)
+ *         .opacity(0, 0)
+ *         .opacity(0.5f, 1)
+ *         .start();
+ * </pre>
+ * Times are seconds from the start. Rotations are interpolated through the shorter arc.
+ */
+public final class KeyframeAnimation {
+
+    /**
+     * Easing of the segment which ends at a key.
+     */
+    public enum Easing {
+        LINEAR, IN, OUT, IN_OUT
+    }
+
+    // Same as AnimationProperty in native side.
+    private static final int POSITION = 0;
+    private static final int ROTATION = 1;
+    private static final int SCALE = 2;
+    private static final int OPACITY = 3;
+    private static final int PROPERTY_COUNT = 4;
+
+    private static final int FLOATS_PER_KEY = 6;
+    private static final SparseArray<KeyframeAnimation> sRunning = new SparseArray<>();
+    private static final int[] sFinished = new int[64];
+
+    private static final Comparator<float[]> KEY_ORDER = new Comparator<float[]>() {
+        @Override
+        public int compare(float[] lhs, float[] rhs) {
+            return Float.compare(lhs[0], rhs[0]);
+        }
+    };
+
+    private final SceneObject mTarget;
+    private final List<List<float[]>> mTracks = new ArrayList<>(PROPERTY_COUNT);
+    private boolean mLoop;
+    private Runnable mOnEnd;
+    private int mId;
+
+    public KeyframeAnimation(@NonNull SceneObject target) {
+        mTarget = target;
+        for (int i = 0; i < PROPERTY_COUNT; ++i) {
+            mTracks.add(new ArrayList<float[]>());
+        }
+    }
+
+    private static native int start(long sceneObject, int[] tracks, float[] keys, boolean loop);
+
+    private static native void cancel(int id);
+
+    private static native int takeFinished(int[] ids);
+
+    /**
+     * Called from {@link MeganekkoApp#update()} on every frame.
+     */
+    static void processFinished() {
+        int count;
+        do {
+            count = takeFinished(sFinished);
+            for (int i = 0; i < count; ++i) {
+                KeyframeAnimation animation;
+                synchronized (sRunning) {
+                    animation = sRunning.get(sFinished[i]);
+                    sRunning.remove(sFinished[i]);
+                }
+                if (animation != null) {
+                    animation.finish();
+                }
+            }
+        } while (count == sFinished.length);
+    }
+
+    public KeyframeAnimation position(float time, float x, float y, float z) {
+        return position(time, x, y, z, Easing.LINEAR);
+    }
+
+    public KeyframeAnimation position(float time, float x, float y, float z, @NonNull Easing easing) {
+        return key(POSITION, time, x, y, z, 0, easing);
+    }
+
+    public KeyframeAnimation position(float time, @NonNull Vector3f position, @NonNull Easing easing) {
+        return position(time, position.x, position.y, position.z, easing);
+    }
+
+    public KeyframeAnimation rotation(float time, @NonNull Quaternionf rotation) {
+        return rotation(time, rotation, Easing.LINEAR);
+    }
+
+    public KeyframeAnimation rotation(float time, @NonNull Quaternionf rotation, @NonNull Easing easing) {
+        Quaternionf q = new Quaternionf(rotation).normalize();
+        return key(ROTATION, time, q.x, q.y, q.z, q.w, easing);
+    }
+
+    public KeyframeAnimation scale(float time, float x, float y, float z) {
+        return scale(time, x, y, z, Easing.LINEAR);
+    }
+
+    public KeyframeAnimation scale(float time, float x, float y, float z, @NonNull Easing easing) {
+        return key(SCALE, time, x, y, z, 0, easing);
+    }
+
+    public KeyframeAnimation scale(float time, @NonNull Vector3f scale, @NonNull Easing easing) {
+        return scale(time, scale.x, scale.y, scale.z, easing);
+    }
+
+    public KeyframeAnimation opacity(float time, float opacity) {
+        return opacity(time, opacity, Easing.LINEAR);
+    }
+
+    public KeyframeAnimation opacity(float time, float opacity, @NonNull Easing easing) {
+        return key(OPACITY, time, opacity, 0, 0, 0, easing);
+    }
+
+    /**
+     * @param loop If true, the animation repeats until {@link #cancel()} is called.
+     */
+    public KeyframeAnimation loop(boolean loop) {
+        mLoop = loop;
+        return this;
+    }
+
+    /**
+     * @param onEnd Called on the GL thread when the animation finishes. Not called if it is cancelled.
+     */
+    public KeyframeAnimation onEnd(Runnable onEnd) {
+        mOnEnd = onEnd;
+        return this;
+    }
+
+    /**
+     * Start the animation from its first keys. It starts from the next frame.
+     */
+    public KeyframeAnimation start() {
+        cancel();
+
+        int trackCount = 0;
+        int keyCount = 0;
+        for (List<float[]> keys : mTracks) {
+            if (!keys.isEmpty()) {
+                trackCount++;
+                keyCount += keys.size();
+            }
+        }
+        if (trackCount == 0) {
+            return this;
+        }
+
+        int[] tracks = new int[trackCount * 2];
+        float[] keys = new float[keyCount * FLOATS_PER_KEY];
+        int t = 0;
+        int k = 0;
+        for (int property = 0; property < PROPERTY_COUNT; ++property) {
+            List<float[]> track = mTracks.get(property);
+            if (track.isEmpty()) {
+                continue;
+            }
+            Collections.sort(track, KEY_ORDER);
+            tracks[t++] = property;
+            tracks[t++] = track.size();
+            for (float[] key : track) {
+                System.arraycopy(key, 0, keys, k, FLOATS_PER_KEY);
+                k += FLOATS_PER_KEY;
+            }
+        }
+
+        mId = start(mTarget.getNative(), tracks, keys, mLoop);
+        if (mId != 0) {
+            synchronized (sRunning) {
+                sRunning.put(mId, this);
+            }
+        }
+        return this;
+    }
+
+    /**
+     * Stop the animation where it is. Opacity stays where it was, but {@link SceneObject#getOpacity()}
+     * doesn't reflect it until it is set again.
+     */
+    public void cancel() {
+        if (mId == 0) {
+            return;
+        }
+        cancel(mId);
+        synchronized (sRunning) {
+            sRunning.remove(mId);
+        }
+        mId = 0;
+    }
+
+    public boolean isRunning() {
+        return mId != 0;
+    }
+
+    private KeyframeAnimation key(int property, float time, float v0, float v1, float v2, float v3, Easing easing) {
+        mTracks.get(property).add(new float[]{time, v0, v1, v2, v3, easing.ordinal()});
+        return this;
+    }
+
+    private void finish() {
+        mId = 0;
+
+        // Native side sets opacity without going through SceneObject.setOpacity().
+        List<float[]> opacity = mTracks.get(OPACITY);
+        if (!opacity.isEmpty()) {
+            mTarget.setOpacity(opacity.get(opacity.size() - 1)[1]);
+        }
+
+        if (mOnEnd != null) {
+            mOnEnd.run();
+        }
+    }
+}
@@ -92,6 +92,10 @@ public class Material extends HybridObject {
 
     private static native void setSide(long material, int side);
 
+    private static native void setTextureSize(long material, int width, int height);
+
+    private static native float takeScreenPixels(long material);
+
     @Override
     protected native long initNativeInstance();
 
@@ -167,8 +171,12 @@ public class Material extends HybridObject {
     /**
      * Get {@code SurfaceTexture} for direct rendering.
      * Use {@link Material#getTexture()} more simple rendering.
+     * <p/>
+     * {@code SurfaceTexture} needs the GL context, so it is created by the first call on the GL
+     * thread, not with the {@code Material}. Until then, calls from other threads return null.
+     * Use {@link MeganekkoApp#runOnGlThread(Runnable)} to get it from another thread.
      *
-     * @return SurfaceTexture
+     * @return SurfaceTexture, or null if it is not created yet and this is not the GL thread.
      */
     public SurfaceTexture getSurfaceTexture() {
         return getSurfaceTexture(getNative());
@@ -176,6 +184,27 @@ public class Material extends HybridObject {
 
     private native SurfaceTexture getSurfaceTexture(long nativePtr);
 
+    /**
+     * Tell the size of the {@code SurfaceTexture} buffers, for GPU memory accounting.
+     * Set it after {@code SurfaceTexture.setDefaultBufferSize()} if you render to it directly.
+     *
+     * @param width
+     * @param height
+     */
+    public void setTextureSize(int width, int height) {
+        setTextureSize(getNative(), width, height);
+    }
+
+    /**
+     * Must be called on the GL thread.
+     *
+     * @return Largest size in pixels of meshes drawn with this material since the last call, or 0
+     * if it was not drawn. It is the largest extent of the mesh on the eye buffer.
+     */
+    float takeScreenPixels() {
+        return takeScreenPixels(getNative());
+    }
+
     /**
      * Use this to render stereo texture.
      *
@@ -191,7 +220,7 @@ public class Material extends HybridObject {
 
     public Texture texture() {
         if (mTexture == null) {
-            mTexture = new Texture(getSurfaceTexture());
+            mTexture = new Texture(this);
         }
         return mTexture;
     }
@@ -14,7 +14,6 @@ import com.eje_c.meganekko.xml.XmlSceneParserFactory;
 import org.xmlpull.v1.XmlPullParserException;
 
 import java.io.IOException;
-import java.lang.ref.Reference;
 import java.util.Queue;
 import java.util.concurrent.LinkedBlockingQueue;
 
@@ -23,13 +22,24 @@ import java.util.concurrent.LinkedBlockingQueue;
  */
 public abstract class MeganekkoApp {
 
+    // Types of key events for dispatchKeyEvent().
+    public static final int KEY_SHORT_PRESS = 1;
+    public static final int KEY_DOUBLE_TAP = 2;
+    public static final int KEY_LONG_PRESS = 3;
+    public static final int KEY_DOWN = 4;
+    public static final int KEY_UP = 5;
+    public static final int KEY_MAX = 6;
+
     private static final int MAX_EVENTS_PER_FRAME = 16;
+    private static final long NATIVE_DELETE_BUDGET_NANOS = 1000000;
 
     private final Meganekko meganekko;
     private final Queue<Runnable> mRunnables = new LinkedBlockingQueue<>();
     private final Handler handler = new Handler(Looper.getMainLooper());
     private Scene mScene;
     private Frame frame;
+    private volatile int mFixedUpdateRate;
+    private volatile FixedRateUpdater mUpdater;
 
     protected MeganekkoApp(Meganekko meganekko) {
         this.meganekko = meganekko;
@@ -39,24 +49,41 @@ public abstract class MeganekkoApp {
      * Will be called on frame update. Any animations or input handlings will be implemented in it.
      * <p/>
      * You can override this method but you must call {@code super.update(meganekko, frame)} to work properly.
+     * <p/>
+     * With {@link #setFixedUpdateRate(int)}, it is called on the update thread instead of the GL thread.
      */
     public void update() {
 
+        // Otherwise FixedRateUpdater does it on the GL thread between updates.
+        if (mUpdater == null) {
+            updateOnGlThread();
+        }
+    }
+
+    /**
+     * Work which must be done on the GL thread in {@link #update()}.
+     */
+    void updateOnGlThread() {
+
         // runOnGlThread handling
         for (int i = 0; !mRunnables.isEmpty() && i < MAX_EVENTS_PER_FRAME; ++i) {
             Runnable event = mRunnables.poll();
             event.run();
         }
 
+        // Builds loaded models a few nodes at a time
+        ModelLoader.processLoads();
+
         mScene.update(frame);
 
+        // Callbacks of keyframe animations finished in the last frame
+        KeyframeAnimation.processFinished();
+
+        // Commands to objects which are deleted next must be applied before
+        SceneCommands.flush();
+
         // Delete native resources related with Garbage Collected objects
-        Reference<? extends HybridObject> ref;
-        while ((ref = NativeReference.sReferenceQueue.poll()) != null) {
-            if (ref instanceof NativeReference) {
-                ((NativeReference) ref).delete();
-            }
-        }
+        NativeReference.processReferenceQueue(NATIVE_DELETE_BUDGET_NANOS);
     }
 
     /**
@@ -80,6 +107,10 @@ public abstract class MeganekkoApp {
     }
 
     public Frame getFrame() {
+        final FixedRateUpdater updater = mUpdater;
+        if (updater != null && updater.isUpdateThread()) {
+            return updater.getFrame();
+        }
         return frame;
     }
 
@@ -92,6 +123,97 @@ public abstract class MeganekkoApp {
         this.frame = frame;
     }
 
+    /**
+     * Run {@link #update()} at a fixed rate on a separate thread, instead of on the GL thread in every
+     * frame. Rendering doesn't wait for updates, and objects are rendered in between the world matrices
+     * of the last two updates. So an update can take longer than a frame without dropping frames, at
+     * the cost of one update of latency.
+     * <p/>
+     * Actions of {@link #runOnGlThread(Runnable)} and textures are still handled on the GL thread,
+     * but never at the same time as {@link #update()}. Key events are handled on the GL thread too
+     * if no update is running, or else on the update thread just before the next update. Those
+     * are treated as handled, so the system doesn't handle them. Changes of transforms, opacity,
+     * visibility and children are rendered from the next update. Other changes such as materials
+     * take effect immediately.
+     *
+     * @param hz Updates per second, or 0 to update in every frame on the GL thread.
+     */
+    public void setFixedUpdateRate(int hz) {
+        if (hz < 0) {
+            throw new IllegalArgumentException("hz must not be negative.");
+        }
+        mFixedUpdateRate = hz;
+    }
+
+    public int getFixedUpdateRate() {
+        return mFixedUpdateRate;
+    }
+
+    /**
+     * For internal use purpose. Called on the GL thread in every frame.
+     */
+    public void onFrame() {
+        final int rate = mFixedUpdateRate;
+        if (mUpdater != null && mUpdater.getRate() != rate) {
+            stopUpdateThread();
+        }
+        if (mUpdater == null && rate > 0) {
+            mUpdater = new FixedRateUpdater(this, rate, frame);
+        }
+
+        if (mUpdater != null) {
+            mUpdater.onFrame(frame);
+        } else {
+            update();
+            // Changes made in this frame are applied before native side renders it.
+            SceneCommands.flush();
+        }
+    }
+
+    /**
+     * For internal use purpose. Called on the GL thread with a key event, and calls one of
+     * {@code onKey*()} methods with it.
+     *
+     * @param type One of {@code KEY_*}.
+     * @return true if the event is handled, or queued for the update thread.
+     */
+    public boolean dispatchKeyEvent(int type, int keyCode, int repeatCount) {
+        final FixedRateUpdater updater = mUpdater;
+        if (updater != null) {
+            return updater.onKeyEvent(type, keyCode, repeatCount);
+        }
+        return deliverKeyEvent(type, keyCode, repeatCount);
+    }
+
+    boolean deliverKeyEvent(int type, int keyCode, int repeatCount) {
+        switch (type) {
+            case KEY_SHORT_PRESS:
+                return onKeyShortPress(keyCode, repeatCount);
+            case KEY_DOUBLE_TAP:
+                return onKeyDoubleTap(keyCode, repeatCount);
+            case KEY_LONG_PRESS:
+                return onKeyLongPress(keyCode, repeatCount);
+            case KEY_DOWN:
+                return onKeyDown(keyCode, repeatCount);
+            case KEY_UP:
+                return onKeyUp(keyCode, repeatCount);
+            case KEY_MAX:
+                return onKeyMax(keyCode, repeatCount);
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * For internal use purpose. Called on the GL thread.
+     */
+    public void stopUpdateThread() {
+        if (mUpdater != null) {
+            mUpdater.stop();
+            mUpdater = null;
+        }
+    }
+
     /**
      * Enqueues a callback to be run in the GL thread.
      * This is how you take data generated on a background thread (or the main
@@ -15,12 +15,19 @@
 
 package com.eje_c.meganekko;
 
+import android.content.res.AssetManager;
 import android.graphics.Bitmap;
 import android.graphics.RectF;
 import android.graphics.drawable.Drawable;
+import android.opengl.GLES20;
 import android.support.annotation.NonNull;
 import android.view.View;
 
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import java.util.concurrent.atomic.AtomicInteger;
+
 /**
  * This is one of the key Meganekko classes: It holds GL meshes.
  * <p>
@@ -29,6 +36,10 @@ import android.view.View;
 public class Mesh extends HybridObject {
 
     private RectF mQuad;
+    private int mBytesSaved;
+    private boolean mOverdrawOptimization;
+    private int mLodCount = 1;
+    private final AtomicInteger mRenderDataCount = new AtomicInteger();
 
     public Mesh() {
     }
@@ -37,10 +48,26 @@ public class Mesh extends HybridObject {
         super(ptr);
     }
 
-    private static native void build(long renderData, float[] positions, float[] colors, float[] uvs, int[] triangles);
+    private static native int build(long renderData, float[] positions, float[] colors, float[] uvs, int[] triangles, boolean compact,
+                                     boolean optimizeOverdraw, int lodCount);
+
+    private static native boolean buildInterleaved(long mesh, ByteBuffer vertices, int verticesPosition, int vertexCount, int stride,
+                                                   int[] attributes, ByteBuffer indices, int indicesPosition, int indexCount, int indexType);
+
+    private static native boolean isUploaded(long mesh);
+
+    private static native float getAcmr(long mesh, boolean optimized);
+
+    private static native int getLodCount(long mesh);
+
+    private static native boolean loadFile(long mesh, String path);
+
+    private static native boolean loadAsset(long mesh, AssetManager assetManager, String path);
 
     private static native void buildQuad(long renderData, float width, float heigh);
 
+    private static native void updateQuad(long mesh, float width, float height);
+
     private static native void buildTesselatedQuad(long renderData, int horizontal, int vertical, boolean twoSided);
 
     private static native void buildFadedScreenMask(long renderData, float xFraction, float yFraction);
@@ -59,7 +86,31 @@ public class Mesh extends HybridObject {
 
     private static native void buildUnitCubeLines(long renderData);
 
+    /**
+     * Build mesh with the compact vertex layout.
+     *
+     * @see #build(float[], float[], float[], int[], boolean)
+     */
     public void build(float[] positions, float[] colors, float[] uvs, int[] triangles) {
+        build(positions, colors, uvs, triangles, true);
+    }
+
+    /**
+     * Build mesh from arrays. In the compact layout, positions are stored as 16 bit integers in the
+     * bounding box, colors as 8 bit integers or omitted if all vertices have the same color, UVs as
+     * 16 bit integers if they are in [0, 1], and indices as 16 bit integers if possible.
+     * <p/>
+     * Triangles are reordered for the GPU vertex cache and vertices are stored in the order they are used.
+     * Large meshes are reordered on a background thread and uploaded when it is done.
+     * Meshes built from the same data and options share one GPU buffer, which is built only once.
+     *
+     * @param positions Positions. 3 elements per vertex.
+     * @param colors    Colors. 4 elements per vertex.
+     * @param uvs       Texture coordinates. 2 elements per vertex.
+     * @param triangles Indices. 3 elements per triangle.
+     * @param compact   Use the compact layout. Pass false if 16 bit precision of positions is not enough.
+     */
+    public void build(float[] positions, float[] colors, float[] uvs, int[] triangles, boolean compact) {
 
         if (positions.length % 3 != 0) {
             throw new IllegalArgumentException("positions element count must be multiple of 3.");
@@ -81,7 +132,130 @@ public class Mesh extends HybridObject {
             throw new IllegalArgumentException("color elements are " + colorSize + " but uv elements are " + uvSize + ".");
         }
 
-        build(getNative(), positions, colors, uvs, triangles);
+        mBytesSaved = build(getNative(), positions, colors, uvs, triangles, compact, mOverdrawOptimization, mLodCount);
+    }
+
+    /**
+     * @return Bytes saved by the compact layout in the last {@link #build(float[], float[], float[], int[], boolean)},
+     * compared with float attributes and 32 bit indices.
+     */
+    public int getBytesSaved() {
+        return mBytesSaved;
+    }
+
+    /**
+     * Triangles passed to {@link #build(float[], float[], float[], int[], boolean)} are always reordered for the
+     * GPU vertex cache. If enabled, clusters of them facing outwards are also drawn first to reduce overdraw,
+     * which costs a little vertex cache efficiency. Applied from the next build.
+     *
+     * @param enabled Default is false.
+     */
+    public void setOverdrawOptimization(boolean enabled) {
+        mOverdrawOptimization = enabled;
+    }
+
+    /**
+     * Generate simplified levels of detail in {@link #build(float[], float[], float[], int[], boolean)}. Each level
+     * has about half the triangles of the previous one and shares its vertices. The renderer picks a level from
+     * the projected size of the mesh, within the range given by {@link SceneObject#setLODRange(float, float)}.
+     * LODs are generated on a background thread. Applied from the next build.
+     * <p/>
+     * Vertices sharing a position with others, e.g. on UV seams, are not moved, so meshes without shared
+     * vertices are not simplified.
+     *
+     * @param count Count of levels including the original mesh. Default is 1, no LODs.
+     */
+    public void setLodCount(int count) {
+        if (count < 1) {
+            throw new IllegalArgumentException("count must be 1 or greater.");
+        }
+        mLodCount = count;
+    }
+
+    /**
+     * @return Count of levels of detail of the uploaded geometry, including the original.
+     */
+    public int getLodCount() {
+        return getLodCount(getNative());
+    }
+
+    /**
+     * Average cache miss ratio (transformed vertices per triangle) of the uploaded geometry, measured with
+     * a 16 entry FIFO cache. 0 if the geometry was not built from arrays or is not uploaded yet.
+     *
+     * @param optimized false to get the ratio of the triangles as they were passed.
+     * @return Ratio from about 0.5 (best) to 3.0 (worst).
+     */
+    public float getAcmr(boolean optimized) {
+        return getAcmr(getNative(), optimized);
+    }
+
+    /**
+     * Build mesh from direct {@code ByteBuffer}s without copying them in Java or native side.
+     * Vertices are uploaded to GL as they are, and the bounding box is computed from them.
+     * <p/>
+     * Buffers are read on the GL thread later. Don't modify them until {@link #isUploaded()} returns true.
+     *
+     * @param vertices    Interleaved vertices described by {@code layout}, from its position. Must be direct and native order.
+     * @param vertexCount Count of vertices.
+     * @param layout      Layout of a vertex.
+     * @param indices     Triangle indices, from its position. Must be direct and native order.
+     * @param indexCount  Count of indices.
+     * @param indexType   {@link GLES20#GL_UNSIGNED_SHORT} or {@link GLES20#GL_UNSIGNED_INT}.
+     * @throws IllegalArgumentException If the layout or indices don't fit the buffers.
+     */
+    public void build(@NonNull ByteBuffer vertices, int vertexCount, @NonNull VertexLayout layout,
+                      @NonNull ByteBuffer indices, int indexCount, int indexType) {
+
+        if (!vertices.isDirect() || !indices.isDirect()) {
+            throw new IllegalArgumentException("vertices and indices must be direct ByteBuffer.");
+        } else if (indexType != GLES20.GL_UNSIGNED_SHORT && indexType != GLES20.GL_UNSIGNED_INT) {
+            throw new IllegalArgumentException("indexType must be GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.");
+        } else if (indexCount % 3 != 0) {
+            throw new IllegalArgumentException("indexCount must be multiple of 3.");
+        } else if (vertices.remaining() < vertexCount * layout.getStride()) {
+            throw new IllegalArgumentException("vertices has " + vertices.remaining() + " bytes but " + vertexCount * layout.getStride() + " bytes are required.");
+        } else if (indices.remaining() < indexCount * (indexType == GLES20.GL_UNSIGNED_INT ? 4 : 2)) {
+            throw new IllegalArgumentException("indices has " + indices.remaining() + " bytes but " + indexCount * (indexType == GLES20.GL_UNSIGNED_INT ? 4 : 2) + " bytes are required.");
+        }
+
+        if (!buildInterleaved(getNative(), vertices, vertices.position(), vertexCount, layout.getStride(), layout.toArray(),
+                indices, indices.position(), indexCount, indexType)) {
+            throw new IllegalArgumentException("Invalid vertex layout or indices. See log for details.");
+        }
+    }
+
+    /**
+     * Load mesh file converted by {@code tools/meshconv}. The file is memory mapped and uploaded as it is.
+     *
+     * @param path Path of the file, e.g. in the cache dir.
+     * @throws IOException If the file cannot be mapped or is not a valid mesh file.
+     */
+    public void loadFile(@NonNull String path) throws IOException {
+        if (!loadFile(getNative(), path)) {
+            throw new IOException("Cannot load mesh file " + path);
+        }
+    }
+
+    /**
+     * Load mesh file converted by {@code tools/meshconv} from assets.
+     * Asset should be stored uncompressed with {@code aaptOptions { noCompress 'mgnm' }} to be mapped.
+     *
+     * @param assetManager AssetManager.
+     * @param path         Path in assets.
+     * @throws IOException If the asset cannot be opened or is not a valid mesh file.
+     */
+    public void loadAsset(@NonNull AssetManager assetManager, @NonNull String path) throws IOException {
+        if (!loadAsset(getNative(), assetManager, path)) {
+            throw new IOException("Cannot load mesh asset " + path);
+        }
+    }
+
+    /**
+     * @return true if the current geometry has been uploaded to GL.
+     */
+    public boolean isUploaded() {
+        return isUploaded(getNative());
     }
 
     /**
@@ -134,6 +308,50 @@ public class Mesh extends HybridObject {
         mQuad = new RectF(-width * 0.5f, -height * 0.5f, width * 0.5f, height * 0.5f);
     }
 
+    /**
+     * Resize the quad without making new GL buffers, e.g. when its {@code View} is resized.
+     * The vertices are streamed to the GPU through a ring buffer only in frames after they were
+     * resized, so this can be called every frame. Once they stop changing they are drawn from a
+     * buffer of their own again.
+     * <p>
+     * Every {@link RenderData} using this mesh is resized. See {@link #isShared()}.
+     *
+     * @param width
+     * @param height
+     */
+    public void updateQuad(float width, float height) {
+        updateQuad(getNative(), width, height);
+        mQuad = new RectF(-width * 0.5f, -height * 0.5f, width * 0.5f, height * 0.5f);
+    }
+
+    /**
+     * @return true if more than one {@link RenderData} uses this mesh.
+     */
+    public boolean isShared() {
+        return mRenderDataCount.get() > 1;
+    }
+
+    /**
+     * Called from {@link RenderData#setMesh(Mesh)}.
+     */
+    void onAttached() {
+        mRenderDataCount.incrementAndGet();
+    }
+
+    /**
+     * Called from {@link RenderData#setMesh(Mesh)}.
+     */
+    void onDetached() {
+        mRenderDataCount.decrementAndGet();
+    }
+
+    /**
+     * @return true if this is built with {@link #buildQuad(float, float)} or {@link #updateQuad(float, float)}.
+     */
+    public boolean isQuad() {
+        return mQuad != null;
+    }
+
     /**
      * Convert local coordinates XY to texture UV.
      * This only works with mesh created from {@link #createQuad(float, float)}.
@@ -230,4 +448,73 @@ public class Mesh extends HybridObject {
 
     @Override
     protected native long initNativeInstance();
+
+    /**
+     * Describes attributes in an interleaved vertex.
+     * Attributes are packed in the order of {@link #add(int, int, int, boolean)} calls.
+     */
+    public static final class VertexLayout {
+
+        // Same as VERTEX_ATTRIBUTE_LOCATION_* in native side.
+        public static final int POSITION = 0;
+        public static final int NORMAL = 1;
+        public static final int TANGENT = 2;
+        public static final int BINORMAL = 3;
+        public static final int COLOR = 4;
+        public static final int UV0 = 5;
+        public static final int UV1 = 6;
+
+        private int[] mAttributes = new int[0];
+        private int mStride;
+
+        /**
+         * Add an attribute.
+         *
+         * @param location   One of {@link #POSITION}, {@link #COLOR}, {@link #UV0} etc.
+         * @param size       Count of components.
+         * @param type       GL type of components, e.g. {@link GLES20#GL_FLOAT}.
+         * @param normalized Whether integer components are normalized to [0, 1] or [-1, 1].
+         * @return this
+         */
+        public VertexLayout add(int location, int size, int type, boolean normalized) {
+            int offset = mStride;
+            mAttributes = Arrays.copyOf(mAttributes, mAttributes.length + 5);
+            mAttributes[mAttributes.length - 5] = location;
+            mAttributes[mAttributes.length - 4] = size;
+            mAttributes[mAttributes.length - 3] = type;
+            mAttributes[mAttributes.length - 2] = normalized ? 1 : 0;
+            mAttributes[mAttributes.length - 1] = offset;
+
+            // Keep each attribute 4 bytes aligned
+            mStride = (offset + size * sizeOf(type) + 3) & ~3;
+            return this;
+        }
+
+        /**
+         * @return Bytes of a vertex.
+         */
+        public int getStride() {
+            return mStride;
+        }
+
+        int[] toArray() {
+            return mAttributes;
+        }
+
+        private static int sizeOf(int type) {
+            switch (type) {
+                case GLES20.GL_BYTE:
+                case GLES20.GL_UNSIGNED_BYTE:
+                    return 1;
+                case GLES20.GL_SHORT:
+                case GLES20.GL_UNSIGNED_SHORT:
+                    return 2;
+                case GLES20.GL_FLOAT:
+                case GLES20.GL_FIXED:
+                    return 4;
+                default:
+                    throw new IllegalArgumentException("Unsupported type " + type);
+            }
+        }
+    }
 }
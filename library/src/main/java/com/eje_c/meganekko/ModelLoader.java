@@ -0,0 +1,258 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import android.content.res.AssetManager;
+import android.support.annotation.NonNull;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Loads model files such as OBJ, FBX, glTF or Collada without stalling frames.
+ * <p>
+ * The file is parsed and its meshes are optimized on background threads. Then scene objects are
+ * built a few nodes per frame in {@link MeganekkoApp#update()}, and meshes are uploaded to GL
+ * within the upload budget of each frame. The callback is called on the GL thread when all meshes
+ * are uploaded.
+ * <p>
+ * Only colors, opacity and sides of materials are loaded. Textures are not.
+ */
+public class ModelLoader extends HybridObject {
+
+    // Same as ModelData::State in native side.
+    private static final int STATE_LOADING = 0;
+    private static final int STATE_LOADED = 1;
+    private static final int STATE_FAILED = 2;
+
+    private static final int MAX_NODES_PER_FRAME = 16;
+    private static final List<ModelLoader> sLoaders = new ArrayList<>();
+
+    private final Callback mCallback;
+    private final List<SceneObject> mNodes = new ArrayList<>();
+    private final List<Mesh> mMeshes = new ArrayList<>();
+    private Mesh[] mMeshOfPart;
+    private Material[] mMaterials;
+    private Material mDefaultMaterial;
+
+    private ModelLoader(Callback callback) {
+        mCallback = callback;
+    }
+
+    private static native void loadFile(long loader, String path);
+
+    private static native void loadAsset(long loader, AssetManager assetManager, String path);
+
+    private static native int getState(long loader);
+
+    private static native String getError(long loader);
+
+    private static native int getNodeCount(long loader);
+
+    private static native int getNodeParent(long loader, int node);
+
+    private static native String getNodeName(long loader, int node);
+
+    private static native int[] getNodeParts(long loader, int node);
+
+    private static native void setupNode(long loader, int node, long sceneObject);
+
+    private static native int getPartMaterial(long loader, int part);
+
+    private static native void setupMesh(long loader, int part, long mesh);
+
+    private static native void getMaterial(long loader, int material, float[] values);
+
+    private static native void release(long loader);
+
+    @Override
+    protected native long initNativeInstance();
+
+    /**
+     * Start loading a model file.
+     *
+     * @param path     Path of the file.
+     * @param callback Called on the GL thread when the model is ready or failed to load.
+     */
+    public static void load(@NonNull String path, @NonNull Callback callback) {
+        ModelLoader loader = new ModelLoader(callback);
+        loadFile(loader.getNative(), path);
+        add(loader);
+    }
+
+    /**
+     * Start loading a model file from assets.
+     *
+     * @param assetManager AssetManager.
+     * @param path         Path in assets. Its extension tells the format.
+     * @param callback     Called on the GL thread when the model is ready or failed to load.
+     */
+    public static void load(@NonNull AssetManager assetManager, @NonNull String path, @NonNull Callback callback) {
+        ModelLoader loader = new ModelLoader(callback);
+        loadAsset(loader.getNative(), assetManager, path);
+        add(loader);
+    }
+
+    private static void add(ModelLoader loader) {
+        synchronized (sLoaders) {
+            sLoaders.add(loader);
+        }
+    }
+
+    /**
+     * Called from {@link MeganekkoApp#update()} on every frame.
+     */
+    static void processLoads() {
+        ModelLoader[] loaders;
+        synchronized (sLoaders) {
+            if (sLoaders.isEmpty()) {
+                return;
+            }
+            loaders = sLoaders.toArray(new ModelLoader[sLoaders.size()]);
+        }
+
+        for (ModelLoader loader : loaders) {
+            if (loader.process()) {
+                synchronized (sLoaders) {
+                    sLoaders.remove(loader);
+                }
+            }
+        }
+    }
+
+    /**
+     * @return true when finished.
+     */
+    private boolean process() {
+        switch (getState(getNative())) {
+            case STATE_LOADING:
+                return false;
+            case STATE_FAILED:
+                String error = getError(getNative());
+                release(getNative());
+                mCallback.onError(error);
+                return true;
+        }
+
+        final int nodeCount = getNodeCount(getNative());
+        if (mNodes.size() < nodeCount) {
+            for (int i = 0; i < MAX_NODES_PER_FRAME && mNodes.size() < nodeCount; ++i) {
+                createNode(mNodes.size());
+            }
+            return false;
+        }
+
+        for (Mesh mesh : mMeshes) {
+            if (!mesh.isUploaded()) {
+                return false;
+            }
+        }
+
+        release(getNative());
+        mCallback.onLoaded(nodeCount > 0 ? mNodes.get(0) : new SceneObject());
+        return true;
+    }
+
+    private void createNode(int node) {
+        SceneObject sceneObject = new SceneObject();
+        sceneObject.setName(getNodeName(getNative(), node));
+        setupNode(getNative(), node, sceneObject.getNative());
+
+        final int parent = getNodeParent(getNative(), node);
+        if (parent >= 0) {
+            mNodes.get(parent).addChildObject(sceneObject);
+        }
+        mNodes.add(sceneObject);
+
+        // A node with some meshes gets a child for each of them.
+        int[] parts = getNodeParts(getNative(), node);
+        if (parts.length == 1) {
+            attachPart(sceneObject, parts[0]);
+        } else {
+            for (int part : parts) {
+                SceneObject child = new SceneObject();
+                attachPart(child, part);
+                sceneObject.addChildObject(child);
+            }
+        }
+    }
+
+    private void attachPart(SceneObject sceneObject, int part) {
+        RenderData renderData = new RenderData();
+        sceneObject.attachRenderData(renderData);
+        renderData.setMesh(getMesh(part));
+        renderData.setMaterial(getMaterial(getPartMaterial(getNative(), part)));
+    }
+
+    // A part can be used by some nodes, so meshes are shared.
+    private Mesh getMesh(int part) {
+        if (mMeshOfPart == null) {
+            mMeshOfPart = new Mesh[part + 1];
+        } else if (mMeshOfPart.length <= part) {
+            Mesh[] meshes = new Mesh[part + 1];
+            System.arraycopy(mMeshOfPart, 0, meshes, 0, mMeshOfPart.length);
+            mMeshOfPart = meshes;
+        }
+
+        if (mMeshOfPart[part] == null) {
+            Mesh mesh = new Mesh();
+            setupMesh(getNative(), part, mesh.getNative());
+            mMeshOfPart[part] = mesh;
+            mMeshes.add(mesh);
+        }
+        return mMeshOfPart[part];
+    }
+
+    private Material getMaterial(int index) {
+        if (index < 0) {
+            if (mDefaultMaterial == null) {
+                mDefaultMaterial = new Material();
+            }
+            return mDefaultMaterial;
+        }
+
+        if (mMaterials == null) {
+            mMaterials = new Material[index + 1];
+        } else if (mMaterials.length <= index) {
+            Material[] materials = new Material[index + 1];
+            System.arraycopy(mMaterials, 0, materials, 0, mMaterials.length);
+            mMaterials = materials;
+        }
+
+        if (mMaterials[index] == null) {
+            float[] values = new float[6];
+            getMaterial(getNative(), index, values);
+
+            Material material = new Material();
+            material.setColor(values[0], values[1], values[2], values[3]);
+            material.setOpacity(values[4]);
+            material.setSide(values[5] != 0.0f ? Material.Side.DoubleSide : Material.Side.FrontSide);
+            mMaterials[index] = material;
+        }
+        return mMaterials[index];
+    }
+
+    public interface Callback {
+
+        /**
+         * @param model Root of the model. It is not added to any scene yet.
+         */
+        void onLoaded(SceneObject model);
+
+        void onError(String message);
+    }
+}
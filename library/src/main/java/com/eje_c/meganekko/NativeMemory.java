@@ -0,0 +1,122 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import android.content.ComponentCallbacks2;
+
+/**
+ * Statistics of native object pools and GPU memory.
+ * Native {@link SceneObject}, {@link RenderData}, {@link Mesh} and {@link Material} are
+ * allocated from type specific slab pools.
+ * GL objects are deleted a few frames after they are released, when the GPU has finished using them.
+ */
+public final class NativeMemory {
+
+    public static final int SCENE_OBJECT = 0;
+    public static final int RENDER_DATA = 1;
+    public static final int MESH = 2;
+    public static final int MATERIAL = 3;
+
+    public static final int GPU_BUFFER = 0;
+    public static final int GPU_TEXTURE = 1;
+    public static final int GPU_PROGRAM = 2;
+
+    private NativeMemory() {
+    }
+
+    /**
+     * @param type One of {@link #SCENE_OBJECT}, {@link #RENDER_DATA}, {@link #MESH} or {@link #MATERIAL}.
+     * @return Count of live native objects of the type.
+     */
+    public static native int getLiveCount(int type);
+
+    /**
+     * @param type One of {@link #SCENE_OBJECT}, {@link #RENDER_DATA}, {@link #MESH} or {@link #MATERIAL}.
+     * @return Bytes used by live native objects of the type.
+     */
+    public static native long getLiveBytes(int type);
+
+    /**
+     * @param type One of {@link #SCENE_OBJECT}, {@link #RENDER_DATA}, {@link #MESH} or {@link #MATERIAL}.
+     * @return Bytes reserved by slabs of the type, including free slots.
+     */
+    public static native long getReservedBytes(int type);
+
+    /**
+     * Return unused slabs to the system.
+     */
+    public static native void trim();
+
+    /**
+     * @return Count of GL objects which are released but not deleted yet.
+     */
+    public static native int getGlDeletePendingCount();
+
+    /**
+     * @return Known size of GL objects which are released but not deleted yet.
+     */
+    public static native long getGlDeletePendingBytes();
+
+    /**
+     * @return Count of mesh geometry in the cache. Meshes built with the same builder and parameters,
+     * or from the same data, share one.
+     */
+    public static native int getSharedMeshCount();
+
+    /**
+     * @param category One of {@link #GPU_BUFFER}, {@link #GPU_TEXTURE} or {@link #GPU_PROGRAM}.
+     * @return Bytes of live GL objects of the category. Textures are estimated from their size as RGBA.
+     */
+    public static native long getGpuBytes(int category);
+
+    /**
+     * Set the budget of GPU memory. When it is exceeded, meshes which have not been drawn recently
+     * are released from the least recently drawn one, and are built again when they are drawn next.
+     * Only meshes built by {@code Mesh.build*()} procedural builders or loaded from mesh files can be
+     * released.
+     *
+     * @param bytes Budget in bytes. 0 for no limit, which is the default.
+     */
+    public static native void setGpuBudget(long bytes);
+
+    /**
+     * @return Budget in bytes. 0 for no limit.
+     */
+    public static native long getGpuBudget();
+
+    /**
+     * @return Count of meshes released to keep the budget so far.
+     */
+    public static native int getEvictedMeshCount();
+
+    private static native void shrinkGpuBudget(float fraction);
+
+    /**
+     * Shrink the GPU memory budget by memory pressure. Called from {@code onTrimMemory()} of the activity.
+     *
+     * @param level Level passed to {@code ComponentCallbacks2.onTrimMemory()}.
+     */
+    public static void onTrimMemory(int level) {
+        if (level >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE || level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) {
+            shrinkGpuBudget(0.25f);
+        } else if (level >= ComponentCallbacks2.TRIM_MEMORY_MODERATE || level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) {
+            shrinkGpuBudget(0.5f);
+        } else if (level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND || level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE) {
+            shrinkGpuBudget(0.75f);
+        }
+    }
+}
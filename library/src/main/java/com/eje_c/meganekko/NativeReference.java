@@ -1,18 +1,29 @@
 package com.eje_c.meganekko;
 
+import java.lang.ref.Reference;
 import java.lang.ref.ReferenceQueue;
 import java.lang.ref.WeakReference;
-import java.util.HashSet;
-import java.util.Set;
+import java.util.HashMap;
+import java.util.Map;
 
 public class NativeReference extends WeakReference<HybridObject> {
 
     static final ReferenceQueue<HybridObject> sReferenceQueue = new ReferenceQueue<>();
 
-    private static final Set<NativeReference> sNativeReferences = new HashSet<>();
+    private static final Map<Long, NativeReference> sNativeReferences = new HashMap<>();
+
+    // Native objects waiting for deletion. Carried over to next frame if budget runs out.
+    private static long[] sPendingDeletes = new long[256];
+    private static int sPendingDeleteCount;
+
     private long mNativePointer;
 
-    private static native void delete(long nativePointer);
+    /**
+     * Delete native objects from the head of {@code nativePointers} until time budget runs out.
+     *
+     * @return Count of deleted objects. At least one object is deleted if {@code count > 0}.
+     */
+    private static native int deleteBatch(long[] nativePointers, int count, long budgetNanos);
 
     private NativeReference(HybridObject r, long nativePointer, ReferenceQueue<? super HybridObject> q) {
         super(r, q);
@@ -28,27 +39,70 @@ public class NativeReference extends WeakReference<HybridObject> {
      */
     public static NativeReference get(HybridObject hybridObject, long nativePointer) {
 
-        for (NativeReference ref : sNativeReferences) {
-            if (ref.mNativePointer == nativePointer) {
+        synchronized (sNativeReferences) {
+            NativeReference ref = sNativeReferences.get(nativePointer);
+            if (ref != null) {
                 return ref;
             }
+
+            ref = new NativeReference(hybridObject, nativePointer, sReferenceQueue);
+            sNativeReferences.put(nativePointer, ref);
+
+            return ref;
+        }
+    }
+
+    /**
+     * Called from {@link MeganekkoApp#update()}. Deletes native objects related with Garbage Collected
+     * {@link HybridObject}s within {@code budgetNanos}. The rest are deleted in later frames.
+     *
+     * @param budgetNanos Time budget for native deletion in nanoseconds.
+     */
+    static void processReferenceQueue(long budgetNanos) {
+
+        Reference<? extends HybridObject> ref;
+        while ((ref = sReferenceQueue.poll()) != null) {
+            if (ref instanceof NativeReference) {
+                ((NativeReference) ref).enqueueDelete();
+            }
         }
 
-        NativeReference ref = new NativeReference(hybridObject, nativePointer, sReferenceQueue);
-        sNativeReferences.add(ref);
+        synchronized (sNativeReferences) {
+            if (sPendingDeleteCount == 0) {
+                return;
+            }
 
-        return ref;
+            int deleted = deleteBatch(sPendingDeletes, sPendingDeleteCount, budgetNanos);
+            sPendingDeleteCount -= deleted;
+            System.arraycopy(sPendingDeletes, deleted, sPendingDeletes, 0, sPendingDeleteCount);
+        }
     }
 
     /**
-     * Called from {@link MeganekkoApp#update()} when {@link HybridObject} was Garbage Collected.
+     * @return Count of native objects waiting for deletion.
      */
-    synchronized void delete() {
-        if (mNativePointer != 0) {
-            delete(mNativePointer);
+    public static int getPendingDeleteCount() {
+        synchronized (sNativeReferences) {
+            return sPendingDeleteCount;
+        }
+    }
+
+    private void enqueueDelete() {
+        synchronized (sNativeReferences) {
+            if (mNativePointer == 0) {
+                return;
+            }
+
+            if (sPendingDeleteCount == sPendingDeletes.length) {
+                long[] pending = new long[sPendingDeletes.length * 2];
+                System.arraycopy(sPendingDeletes, 0, pending, 0, sPendingDeleteCount);
+                sPendingDeletes = pending;
+            }
+
+            sPendingDeletes[sPendingDeleteCount++] = mNativePointer;
+            sNativeReferences.remove(mNativePointer);
             mNativePointer = 0;
         }
-        sNativeReferences.remove(this);
     }
 
     /**
@@ -57,4 +111,4 @@ public class NativeReference extends WeakReference<HybridObject> {
     public long getNativePointer() {
         return mNativePointer;
     }
-}
\ No newline at end of file
+}
@@ -33,6 +33,9 @@ import static android.opengl.GLES30.GL_TRIANGLE_STRIP;
  * <p/>
  * This includes the {@link Mesh mesh} itself, the mesh's {@link Material
  * material}, camera association, rendering order, and various other parameters.
+ * <p/>
+ * Color, UV rect and stereo mode can be overridden per object, and opacity is multiplied with the
+ * material's. So objects which differ only in them can share one {@link Material} and its texture.
  */
 public class RenderData extends Component {
 
@@ -76,6 +79,20 @@ public class RenderData extends Component {
 
     private static native void setDrawMode(long renderData, int draw_mode);
 
+    private static native void setColor(long renderData, float r, float g, float b, float a);
+
+    private static native void clearColor(long renderData);
+
+    private static native float getOpacity(long renderData);
+
+    private static native void setOpacity(long renderData, float opacity);
+
+    private static native void setUvRect(long renderData, float x, float y, float width, float height);
+
+    private static native void setStereoMode(long renderData, int stereoMode);
+
+    private static native void clearStereoMode(long renderData);
+
     @Override
     protected native long initNativeInstance();
 
@@ -93,6 +110,12 @@ public class RenderData extends Component {
      */
     public void setMesh(Mesh mesh) {
         synchronized (this) {
+            if (mMesh != mesh) {
+                if (mMesh != null) {
+                    mMesh.onDetached();
+                }
+                mesh.onAttached();
+            }
             mMesh = mesh;
         }
         setMesh(getNative(), mesh.getNative());
@@ -286,6 +309,70 @@ public class RenderData extends Component {
         setDrawMode(getNative(), drawMode);
     }
 
+    /**
+     * Override the color of the {@link Material} for this object.
+     *
+     * @param r Red
+     * @param g Green
+     * @param b Blue
+     * @param a Alpha
+     */
+    public void setColor(float r, float g, float b, float a) {
+        setColor(getNative(), r, g, b, a);
+    }
+
+    /**
+     * Use the color of the {@link Material} again.
+     */
+    public void clearColor() {
+        clearColor(getNative());
+    }
+
+    /**
+     * @return Opacity of this object. It is multiplied with the opacity of the {@link Material}.
+     */
+    public float getOpacity() {
+        return getOpacity(getNative());
+    }
+
+    /**
+     * Set opacity of this object. It is also multiplied with the opacity of the owner
+     * {@link SceneObject} and its parents.
+     *
+     * @param opacity Multiplied with the opacity of the {@link Material}.
+     */
+    public void setOpacity(float opacity) {
+        setOpacity(getNative(), opacity);
+    }
+
+    /**
+     * Map a part of the texture on the mesh, e.g. a cell of an atlas.
+     *
+     * @param x      Left in texture coordinates.
+     * @param y      Top in texture coordinates.
+     * @param width  Width in texture coordinates.
+     * @param height Height in texture coordinates.
+     */
+    public void setUvRect(float x, float y, float width, float height) {
+        setUvRect(getNative(), x, y, width, height);
+    }
+
+    /**
+     * Override the stereo mode of the {@link Material} for this object.
+     *
+     * @param stereoMode Stereo mode.
+     */
+    public void setStereoMode(Material.StereoMode stereoMode) {
+        setStereoMode(getNative(), stereoMode.ordinal());
+    }
+
+    /**
+     * Use the stereo mode of the {@link Material} again.
+     */
+    public void clearStereoMode() {
+        clearStereoMode(getNative());
+    }
+
     /**
      * Rendering hints.
      * <p/>
@@ -41,6 +41,10 @@ public class Scene extends SceneObject {
 
     private static native void getLookingPoint(long scene, long sceneObject, boolean axisInWorld, float[] val);
 
+    private static native void commitTick(long scene, double time, boolean advance);
+
+    private static native void setTickInterpolation(long scene, boolean enabled, float alpha);
+
     private static native void setViewMatrix(long scene, float[] m);
 
     private static native void setProjectionMatrix(long scene, float[] m);
@@ -110,16 +114,37 @@ public class Scene extends SceneObject {
         // cannot look at target has no mesh
         if (target.mesh() == null) return false;
 
+        SceneCommands.flush();
         return isLookingAt(getNative(), target.getNative());
     }
 
     public Vector3f getLookingPoint(SceneObject target, boolean axisInWorld) {
+        SceneCommands.flush();
         synchronized (sTempValuesForJni) {
             getLookingPoint(getNative(), target.getNative(), axisInWorld, sTempValuesForJni);
             return new Vector3f(sTempValuesForJni[0], sTempValuesForJni[1], sTempValuesForJni[2]);
         }
     }
 
+    /**
+     * Takes world matrices of objects as a tick of fixed rate updates, and captures a render snapshot.
+     * See {@link FixedRateUpdater}.
+     *
+     * @param time    Time of the tick, which advances keyframe animations.
+     * @param advance If false, only objects which have not been in a tick yet are taken.
+     */
+    void commitTick(double time, boolean advance) {
+        commitTick(getNative(), time, advance);
+    }
+
+    /**
+     * @param enabled If true, objects are rendered between the last two ticks.
+     * @param alpha   0 for the previous tick, 1 for the last tick.
+     */
+    void setTickInterpolation(boolean enabled, float alpha) {
+        setTickInterpolation(getNative(), enabled, alpha);
+    }
+
     public void setViewMatrix(float[] viewM) {
         setViewMatrix(getNative(), viewM);
     }
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import org.joml.Matrix4f;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.concurrent.locks.Lock;
+
+/**
+ * Records changes of scene objects into a direct {@code ByteBuffer}, and applies them to native
+ * objects with one JNI call in {@link #flush()}. It is flushed after each frame of Java side, and
+ * before anything reads native state of scene objects, so that reads see the latest writes.
+ * <p>
+ * A command is (opcode, payload size, handle, payload) in native byte order. Commands to objects
+ * which are deleted before the flush are skipped. Position, rotation and scale don't need commands,
+ * because they are written to native memory directly. See {@link SceneObject#getTransformBuffer()}.
+ */
+public final class SceneCommands {
+
+    // Same as SceneCommand in native side.
+    static final int SET_MATRIX = 1;
+    static final int SET_OPACITY = 2;
+    static final int SET_VISIBLE = 3;
+    static final int ATTACH_RENDER_DATA = 4;
+    static final int DETACH_RENDER_DATA = 5;
+    static final int ADD_CHILD = 6;
+    static final int REMOVE_CHILD = 7;
+
+    private static final int HEADER_SIZE = 16;
+    private static final int INITIAL_CAPACITY = 16 * 1024;
+
+    private static ByteBuffer sBuffer = ByteBuffer.allocateDirect(INITIAL_CAPACITY).order(ByteOrder.nativeOrder());
+    private static volatile Lock sReplayLock;
+
+    private SceneCommands() {
+    }
+
+    private static native void replay(ByteBuffer buffer, int length);
+
+    // Same order as SceneObject.setMatrix() passed to native side. SceneObject.matrix(Matrix4f) writes
+    // the transform directly instead, so that it is in order with the other transform writes.
+    static void setMatrix(long sceneObject, Matrix4f m) {
+        synchronized (SceneCommands.class) {
+            begin(SET_MATRIX, sceneObject, 64);
+            sBuffer.putFloat(m.m00).putFloat(m.m01).putFloat(m.m02).putFloat(m.m03)
+                    .putFloat(m.m10).putFloat(m.m11).putFloat(m.m12).putFloat(m.m13)
+                    .putFloat(m.m20).putFloat(m.m21).putFloat(m.m22).putFloat(m.m23)
+                    .putFloat(m.m30).putFloat(m.m31).putFloat(m.m32).putFloat(m.m33);
+        }
+    }
+
+    static void setOpacity(long sceneObject, float opacity) {
+        synchronized (SceneCommands.class) {
+            begin(SET_OPACITY, sceneObject, 4);
+            sBuffer.putFloat(opacity);
+        }
+    }
+
+    static void setVisible(long sceneObject, boolean visible) {
+        synchronized (SceneCommands.class) {
+            begin(SET_VISIBLE, sceneObject, 4);
+            sBuffer.putInt(visible ? 1 : 0);
+        }
+    }
+
+    static void attachRenderData(long sceneObject, long renderData) {
+        synchronized (SceneCommands.class) {
+            begin(ATTACH_RENDER_DATA, sceneObject, 8);
+            sBuffer.putLong(renderData);
+        }
+    }
+
+    static void detachRenderData(long sceneObject) {
+        synchronized (SceneCommands.class) {
+            begin(DETACH_RENDER_DATA, sceneObject, 0);
+        }
+    }
+
+    static void addChild(long sceneObject, long child) {
+        synchronized (SceneCommands.class) {
+            begin(ADD_CHILD, sceneObject, 8);
+            sBuffer.putLong(child);
+        }
+    }
+
+    static void removeChild(long sceneObject, long child) {
+        synchronized (SceneCommands.class) {
+            begin(REMOVE_CHILD, sceneObject, 8);
+            sBuffer.putLong(child);
+        }
+    }
+
+    /**
+     * Apply recorded commands to native objects. Called from {@code MeganekkoActivity} after
+     * {@link MeganekkoApp#update()}, and before reading native state of scene objects.
+     * <p>
+     * While updates run on their own thread, commands are applied while holding the update lock, as
+     * the GL thread reads native scene objects only while holding it. So a call from outside of
+     * {@link MeganekkoApp#update()} waits for the running update.
+     */
+    public static void flush() {
+        final Lock lock = sReplayLock;
+        if (lock == null) {
+            replayRecorded();
+            return;
+        }
+        lock.lock();
+        try {
+            replayRecorded();
+        } finally {
+            lock.unlock();
+        }
+    }
+
+    /**
+     * @param lock Held while applying commands, or null to apply them without a lock.
+     */
+    static void setReplayLock(Lock lock) {
+        sReplayLock = lock;
+    }
+
+    private static synchronized void replayRecorded() {
+        if (sBuffer.position() == 0) {
+            return;
+        }
+        replay(sBuffer, sBuffer.position());
+        sBuffer.clear();
+    }
+
+    private static void begin(int opcode, long handle, int payloadSize) {
+        final int size = HEADER_SIZE + payloadSize;
+        if (sBuffer.remaining() < size) {
+            ByteBuffer buffer = ByteBuffer.allocateDirect(Math.max(sBuffer.capacity() * 2, sBuffer.position() + size))
+                    .order(ByteOrder.nativeOrder());
+            sBuffer.flip();
+            buffer.put(sBuffer);
+            sBuffer = buffer;
+        }
+        sBuffer.putInt(opcode).putInt(payloadSize).putLong(handle);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.eje_c.meganekko;
+
+import com.eje_c.meganekko.utility.Log;
+
+import org.joml.Matrix4f;
+
+/**
+ * Compares applying changes of scene objects through {@link SceneCommands} with one JNI call per
+ * change, which is how they were applied before. Each round sets opacity and matrix of every object,
+ * like an app animating a scene in a frame. The batched path flushes once per round.
+ * <p>
+ * Run it on the GL thread of a device, e.g. from {@link MeganekkoApp#init()}. Results are logged with
+ * tag {@code SceneCommandsBenchmark}.
+ */
+public final class SceneCommandsBenchmark {
+
+    private static final String TAG = "SceneCommandsBenchmark";
+
+    /**
+     * Times of one run.
+     */
+    public static final class Result {
+        public final int mutations;
+        public final long perCallNanos;
+        public final long batchedNanos;
+
+        Result(int mutations, long perCallNanos, long batchedNanos) {
+            this.mutations = mutations;
+            this.perCallNanos = perCallNanos;
+            this.batchedNanos = batchedNanos;
+        }
+
+        @Override
+        public String toString() {
+            return String.format("%d mutations: per-call JNI %.3f ms (%.0f ns each), command buffer %.3f ms (%.0f ns each)",
+                    mutations,
+                    perCallNanos / 1e6, (double) perCallNanos / mutations,
+                    batchedNanos / 1e6, (double) batchedNanos / mutations);
+        }
+    }
+
+    private SceneCommandsBenchmark() {
+    }
+
+    // Same as the setters SceneObject had before SceneCommands.
+    private static native void setOpacity(long sceneObject, float opacity);
+
+    private static native void setMatrix(long sceneObject,
+                                         float m11, float m12, float m13, float m14,
+                                         float m21, float m22, float m23, float m24,
+                                         float m31, float m32, float m33, float m34,
+                                         float m41, float m42, float m43, float m44);
+
+    /**
+     * Must be called on the GL thread.
+     *
+     * @param objectCount Count of scene objects changed in a round.
+     * @param rounds      Count of rounds. One more round is run first for warm up.
+     * @return Times of both paths.
+     */
+    public static Result run(int objectCount, int rounds) {
+        final long[] objects = new long[objectCount];
+        final SceneObject[] sceneObjects = new SceneObject[objectCount];
+        for (int i = 0; i < objectCount; ++i) {
+            sceneObjects[i] = new SceneObject();
+            objects[i] = sceneObjects[i].getNative();
+        }
+
+        final Matrix4f matrix = new Matrix4f();
+
+        // Apply anything recorded before, so that only the benchmark is timed.
+        SceneCommands.flush();
+
+        runPerCall(objects, 1, matrix);
+        final long perCallStart = System.nanoTime();
+        runPerCall(objects, rounds, matrix);
+        final long perCallNanos = System.nanoTime() - perCallStart;
+
+        runBatched(objects, 1, matrix);
+        final long batchedStart = System.nanoTime();
+        runBatched(objects, rounds, matrix);
+        final long batchedNanos = System.nanoTime() - batchedStart;
+
+        // Also keeps the scene objects reachable until here.
+        final Result result = new Result(sceneObjects.length * rounds * 2, perCallNanos, batchedNanos);
+        Log.i(TAG, "%s", result);
+        return result;
+    }
+
+    private static void runPerCall(long[] objects, int rounds, Matrix4f m) {
+        for (int round = 0; round < rounds; ++round) {
+            for (int i = 0; i < objects.length; ++i) {
+                m.translation(i, round, 0.0f);
+                setOpacity(objects[i], 0.5f);
+                setMatrix(objects[i],
+                        m.m00, m.m01, m.m02, m.m03,
+                        m.m10, m.m11, m.m12, m.m13,
+                        m.m20, m.m21, m.m22, m.m23,
+                        m.m30, m.m31, m.m32, m.m33);
+            }
+        }
+    }
+
+    private static void runBatched(long[] objects, int rounds, Matrix4f m) {
+        for (int round = 0; round < rounds; ++round) {
+            for (int i = 0; i < objects.length; ++i) {
+                m.translation(i, round, 0.0f);
+                SceneCommands.setOpacity(objects[i], 0.5f);
+                SceneCommands.setMatrix(objects[i], m);
+            }
+            SceneCommands.flush();
+        }
+    }
+}
@@ -47,6 +47,9 @@ import org.joml.Vector3f;
 import org.xmlpull.v1.XmlPullParserException;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
 import java.util.ArrayList;
 import java.util.Collections;
 import java.util.HashSet;
@@ -73,6 +76,22 @@ public class SceneObject extends HybridObject {
     // synchronized (sTempValuesForJni) { ... } block to prevent
     protected static final float[] sTempValuesForJni = new float[16];
 
+    /*
+     * Layout of a transform in the buffer of getTransformBuffer(), in floats from getTransformOffset().
+     * Same as TransformSlot in native side.
+     */
+    public static final int TRANSFORM_POSITION = 0;
+    public static final int TRANSFORM_ROTATION = 4;
+    public static final int TRANSFORM_SCALE = 8;
+    public static final int TRANSFORM_DIRTY = 11;
+    public static final int TRANSFORM_MATRIX_WORLD = 16;
+    public static final int TRANSFORM_STRIDE = 32;
+
+    // Same as TransformStore in native side.
+    private static final int TRANSFORM_CHUNK_SHIFT = 8;
+    private static final int TRANSFORM_CHUNK_SIZE = 1 << TRANSFORM_CHUNK_SHIFT;
+    private static final FloatBuffer[] sTransformChunks = new FloatBuffer[1024];
+
     private static final String TAG = SceneObject.class.getSimpleName();
     private final List<SceneObject> mChildren = new ArrayList<>();
     private final Set<KeyEventListener> mKeyEventListeners = new HashSet<>();
@@ -82,6 +101,8 @@ public class SceneObject extends HybridObject {
     private SceneObject mParent;
     private float mOpacity = 1.0f;
     private boolean mVisible = true;
+    private FloatBuffer mTransform;
+    private int mTransformOffset;
 
     /**
      * Constructs an empty scene object with a default transform.
@@ -165,15 +186,11 @@ public class SceneObject extends HybridObject {
         return parser.parse(context.getResources().getXml(xmlRes));
     }
 
-    private static native void attachRenderData(long sceneObject, long renderData);
-
-    private static native void detachRenderData(long sceneObject);
-
-    private static native void addChildObject(long sceneObject, long child);
+    private static native boolean isColliding(long sceneObject, long otherObject);
 
-    private static native void removeChildObject(long sceneObject, long child);
+    private static native int getTransformId(long sceneObject);
 
-    private static native boolean isColliding(long sceneObject, long otherObject);
+    private static native ByteBuffer getTransformChunk(int chunk);
 
     private static native void setLODRange(long sceneObject, float minRange, float maxRange);
 
@@ -181,24 +198,6 @@ public class SceneObject extends HybridObject {
 
     private static native float getLODMaxRange(long sceneObject);
 
-    private static native void setPosition(long sceneObject, float x, float y, float z);
-
-    private static native void setScale(long sceneObject, float x, float y, float z);
-
-    private static native void setRotation(long sceneObject, float x, float y, float z, float w);
-
-    private static native void getPosition(long sceneObject, float[] val);
-
-    private static native void getScale(long sceneObject, float[] val);
-
-    private static native void getRotation(long sceneObject, float[] val);
-
-    private static native void setMatrix(long sceneObject,
-                                         float m11, float m12, float m13, float m14,
-                                         float m21, float m22, float m23, float m24,
-                                         float m31, float m32, float m33, float m34,
-                                         float m41, float m42, float m43, float m44);
-
     private static native void getMatrixWorld(long sceneObject, float[] val);
 
     private static native void getMatrix(long sceneObject, float[] val);
@@ -261,7 +260,7 @@ public class SceneObject extends HybridObject {
     public void attachRenderData(RenderData renderData) {
         mRenderData = renderData;
         renderData.setOwnerObject(this);
-        attachRenderData(getNative(), renderData.getNative());
+        SceneCommands.attachRenderData(getNative(), renderData.getNative());
     }
 
     /**
@@ -274,7 +273,7 @@ public class SceneObject extends HybridObject {
             mRenderData.setOwnerObject(null);
         }
         mRenderData = null;
-        detachRenderData(getNative());
+        SceneCommands.detachRenderData(getNative());
     }
 
     /**
@@ -308,8 +307,7 @@ public class SceneObject extends HybridObject {
     public void addChildObject(SceneObject child) {
         mChildren.add(child);
         child.mParent = this;
-        child.updateOpacity();
-        addChildObject(getNative(), child.getNative());
+        SceneCommands.addChild(getNative(), child.getNative());
     }
 
     /**
@@ -321,7 +319,7 @@ public class SceneObject extends HybridObject {
     public void removeChildObject(SceneObject child) {
         mChildren.remove(child);
         child.mParent = null;
-        removeChildObject(getNative(), child.getNative());
+        SceneCommands.removeChild(getNative(), child.getNative());
     }
 
     /**
@@ -332,12 +330,14 @@ public class SceneObject extends HybridObject {
      * @return {@code true) if objects collide, {@code false} otherwise
      */
     public boolean isColliding(SceneObject otherObject) {
+        SceneCommands.flush();
         return isColliding(getNative(), otherObject.getNative());
     }
 
     /**
      * Sets the range of distances from the camera where this object will be
-     * shown.
+     * shown. Within the range, a level of detail of the mesh is picked from its
+     * projected size if the mesh has LODs. See {@link Mesh#setLodCount(int)}.
      *
      * @param minRange The closest distance to the camera in which this object should
      *                 be shown. This should be a positive number between 0 and
@@ -426,7 +426,7 @@ public class SceneObject extends HybridObject {
      */
     public void setVisible(boolean visible) {
         this.mVisible = visible;
-        updateVisibility();
+        SceneCommands.setVisible(getNative(), visible);
     }
 
     /**
@@ -446,18 +446,6 @@ public class SceneObject extends HybridObject {
         return mVisible && getParent().isShown();
     }
 
-    private void updateVisibility() {
-        RenderData renderData = getRenderData();
-        if (renderData != null) {
-            boolean visible = isShown();
-            renderData.setVisible(visible);
-        }
-
-        for (SceneObject child : mChildren) {
-            child.updateVisibility();
-        }
-    }
-
     /**
      * Get opacity set by {@link SceneObject#setOpacity(float) setOpacity()}.
      *
@@ -475,27 +463,7 @@ public class SceneObject extends HybridObject {
      */
     public void setOpacity(float opacity) {
         this.mOpacity = opacity;
-        updateOpacity();
-    }
-
-    private float getInternalOpacity() {
-        float parentOpacity = getParent() != null ? getParent().getInternalOpacity() : 1.0f;
-        return mOpacity * parentOpacity;
-    }
-
-    private void updateOpacity() {
-        RenderData renderData = getRenderData();
-        if (renderData != null) {
-            Material material = renderData.getMaterial();
-            if (material != null) {
-                float opacity = getInternalOpacity();
-                material.setOpacity(opacity);
-            }
-        }
-
-        for (SceneObject child : mChildren) {
-            child.updateOpacity();
-        }
+        SceneCommands.setOpacity(getNative(), opacity);
     }
 
     public SceneObject findObjectById(int id) {
@@ -682,35 +650,130 @@ public class SceneObject extends HybridObject {
      */
 
     public void position(Vector3f position) {
-        setPosition(getNative(), position.x, position.y, position.z);
+        setPosition(position.x, position.y, position.z);
     }
 
     public Vector3f position() {
-        synchronized (sTempValuesForJni) {
-            getPosition(getNative(), sTempValuesForJni);
-            return new Vector3f(sTempValuesForJni[0], sTempValuesForJni[1], sTempValuesForJni[2]);
-        }
+        return getPosition(new Vector3f());
     }
 
     public void scale(Vector3f scale) {
-        setScale(getNative(), scale.x, scale.y, scale.z);
+        setScale(scale.x, scale.y, scale.z);
     }
 
     public Vector3f scale() {
-        synchronized (sTempValuesForJni) {
-            getScale(getNative(), sTempValuesForJni);
-            return new Vector3f(sTempValuesForJni[0], sTempValuesForJni[1], sTempValuesForJni[2]);
-        }
+        return getScale(new Vector3f());
     }
 
     public void rotation(Quaternionf rotation) {
-        setRotation(getNative(), rotation.x, rotation.y, rotation.z, rotation.w);
+        setRotation(rotation.x, rotation.y, rotation.z, rotation.w);
     }
 
     public Quaternionf rotation() {
-        synchronized (sTempValuesForJni) {
-            getRotation(getNative(), sTempValuesForJni);
-            return new Quaternionf(sTempValuesForJni[0], sTempValuesForJni[1], sTempValuesForJni[2], sTempValuesForJni[3]);
+        return getRotation(new Quaternionf());
+    }
+
+    /*
+     * Transforms without JNI calls nor allocation. Position, rotation and scale are read and written
+     * in native memory directly. See also getTransformBuffer().
+     */
+
+    public void setPosition(float x, float y, float z) {
+        final FloatBuffer t = getTransformBuffer();
+        t.put(mTransformOffset + TRANSFORM_POSITION, x);
+        t.put(mTransformOffset + TRANSFORM_POSITION + 1, y);
+        t.put(mTransformOffset + TRANSFORM_POSITION + 2, z);
+        t.put(mTransformOffset + TRANSFORM_DIRTY, 1.0f);
+    }
+
+    public void setScale(float x, float y, float z) {
+        final FloatBuffer t = getTransformBuffer();
+        t.put(mTransformOffset + TRANSFORM_SCALE, x);
+        t.put(mTransformOffset + TRANSFORM_SCALE + 1, y);
+        t.put(mTransformOffset + TRANSFORM_SCALE + 2, z);
+        t.put(mTransformOffset + TRANSFORM_DIRTY, 1.0f);
+    }
+
+    public void setRotation(float x, float y, float z, float w) {
+        final FloatBuffer t = getTransformBuffer();
+        t.put(mTransformOffset + TRANSFORM_ROTATION, x);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 1, y);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 2, z);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 3, w);
+        t.put(mTransformOffset + TRANSFORM_DIRTY, 1.0f);
+    }
+
+    public Vector3f getPosition(Vector3f dest) {
+        final FloatBuffer t = getTransformBuffer();
+        return dest.set(t.get(mTransformOffset + TRANSFORM_POSITION),
+                t.get(mTransformOffset + TRANSFORM_POSITION + 1),
+                t.get(mTransformOffset + TRANSFORM_POSITION + 2));
+    }
+
+    public Vector3f getScale(Vector3f dest) {
+        final FloatBuffer t = getTransformBuffer();
+        return dest.set(t.get(mTransformOffset + TRANSFORM_SCALE),
+                t.get(mTransformOffset + TRANSFORM_SCALE + 1),
+                t.get(mTransformOffset + TRANSFORM_SCALE + 2));
+    }
+
+    public Quaternionf getRotation(Quaternionf dest) {
+        final FloatBuffer t = getTransformBuffer();
+        return dest.set(t.get(mTransformOffset + TRANSFORM_ROTATION),
+                t.get(mTransformOffset + TRANSFORM_ROTATION + 1),
+                t.get(mTransformOffset + TRANSFORM_ROTATION + 2),
+                t.get(mTransformOffset + TRANSFORM_ROTATION + 3));
+    }
+
+    /**
+     * World matrix as of the last rendered frame, in the same order as {@link #matrixWorld()}.
+     * Objects not rendered in the frame keep older values. Use {@link #matrixWorld()} for the
+     * current one.
+     *
+     * @param dest Will hold the result.
+     * @return dest
+     */
+    public Matrix4f getMatrixWorld(Matrix4f dest) {
+        final FloatBuffer t = getTransformBuffer();
+        final int o = mTransformOffset + TRANSFORM_MATRIX_WORLD;
+        return dest.set(
+                t.get(o), t.get(o + 1), t.get(o + 2), t.get(o + 3),
+                t.get(o + 4), t.get(o + 5), t.get(o + 6), t.get(o + 7),
+                t.get(o + 8), t.get(o + 9), t.get(o + 10), t.get(o + 11),
+                t.get(o + 12), t.get(o + 13), t.get(o + 14), t.get(o + 15));
+    }
+
+    /**
+     * Native transforms of scene objects in a direct buffer shared by many objects. The transform
+     * of this object starts at {@link #getTransformOffset()}, and its layout is given by
+     * {@code TRANSFORM_*}. After writing position, rotation or scale, set {@code TRANSFORM_DIRTY}
+     * to non-zero so that matrices are updated. The world matrix is updated when rendering.
+     *
+     * @return Buffer in native byte order. Its position and limit must not be changed.
+     */
+    public FloatBuffer getTransformBuffer() {
+        if (mTransform == null) {
+            final int id = getTransformId(getNative());
+            mTransformOffset = (id & (TRANSFORM_CHUNK_SIZE - 1)) * TRANSFORM_STRIDE;
+            mTransform = getTransformChunkBuffer(id >>> TRANSFORM_CHUNK_SHIFT);
+        }
+        return mTransform;
+    }
+
+    /**
+     * @return Offset of the transform of this object in {@link #getTransformBuffer()} in floats.
+     */
+    public int getTransformOffset() {
+        getTransformBuffer();
+        return mTransformOffset;
+    }
+
+    private static FloatBuffer getTransformChunkBuffer(int chunk) {
+        synchronized (sTransformChunks) {
+            if (sTransformChunks[chunk] == null) {
+                sTransformChunks[chunk] = getTransformChunk(chunk).order(ByteOrder.nativeOrder()).asFloatBuffer();
+            }
+            return sTransformChunks[chunk];
         }
     }
 
@@ -719,13 +782,67 @@ public class SceneObject extends HybridObject {
         matrix(m);
     }
 
+    /**
+     * Set position, rotation and scale from a matrix. Decomposed in the same way as
+     * {@code SceneObject::SetMatrixLocal()} in native side, and written to the transform directly,
+     * so that they are in order with the other transform writes and reads.
+     */
     public void matrix(Matrix4f m) {
-        setMatrix(getNative(),
-                m.m00, m.m01, m.m02, m.m03,
-                m.m10, m.m11, m.m12, m.m13,
-                m.m20, m.m21, m.m22, m.m23,
-                m.m30, m.m31, m.m32, m.m33
-        );
+        final float xs = sign(m.m00 * m.m10 * m.m20 * m.m30);
+        final float ys = sign(m.m01 * m.m11 * m.m21 * m.m31);
+        final float zs = sign(m.m02 * m.m12 * m.m22 * m.m32);
+        final float sx = xs * (float) Math.sqrt(m.m00 * m.m00 + m.m10 * m.m10 + m.m20 * m.m20);
+        final float sy = ys * (float) Math.sqrt(m.m01 * m.m01 + m.m11 * m.m11 + m.m21 * m.m21);
+        final float sz = zs * (float) Math.sqrt(m.m02 * m.m02 + m.m12 * m.m12 + m.m22 * m.m22);
+
+        // Rotation matrix r{row}{column}, converted to a quaternion like OVR::Quat(Matrix3).
+        final float r00 = m.m00 / sx, r01 = m.m01 / sy, r02 = m.m02 / sz;
+        final float r10 = m.m10 / sx, r11 = m.m11 / sy, r12 = m.m12 / sz;
+        final float r20 = m.m20 / sx, r21 = m.m21 / sy, r22 = m.m22 / sz;
+        final float trace = r00 + r11 + r22;
+        final float x, y, z, w;
+        if (trace > 0.0f) {
+            final float s = (float) Math.sqrt(trace + 1.0f) * 2.0f;
+            w = 0.25f * s;
+            x = (r21 - r12) / s;
+            y = (r02 - r20) / s;
+            z = (r10 - r01) / s;
+        } else if (r00 > r11 && r00 > r22) {
+            final float s = (float) Math.sqrt(1.0f + r00 - r11 - r22) * 2.0f;
+            w = (r21 - r12) / s;
+            x = 0.25f * s;
+            y = (r01 + r10) / s;
+            z = (r20 + r02) / s;
+        } else if (r11 > r22) {
+            final float s = (float) Math.sqrt(1.0f + r11 - r00 - r22) * 2.0f;
+            w = (r02 - r20) / s;
+            x = (r01 + r10) / s;
+            y = 0.25f * s;
+            z = (r12 + r21) / s;
+        } else {
+            final float s = (float) Math.sqrt(1.0f + r22 - r00 - r11) * 2.0f;
+            w = (r10 - r01) / s;
+            x = (r02 + r20) / s;
+            y = (r12 + r21) / s;
+            z = 0.25f * s;
+        }
+
+        final FloatBuffer t = getTransformBuffer();
+        t.put(mTransformOffset + TRANSFORM_POSITION, m.m03);
+        t.put(mTransformOffset + TRANSFORM_POSITION + 1, m.m13);
+        t.put(mTransformOffset + TRANSFORM_POSITION + 2, m.m23);
+        t.put(mTransformOffset + TRANSFORM_ROTATION, x);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 1, y);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 2, z);
+        t.put(mTransformOffset + TRANSFORM_ROTATION + 3, w);
+        t.put(mTransformOffset + TRANSFORM_SCALE, sx);
+        t.put(mTransformOffset + TRANSFORM_SCALE + 1, sy);
+        t.put(mTransformOffset + TRANSFORM_SCALE + 2, sz);
+        t.put(mTransformOffset + TRANSFORM_DIRTY, 1.0f);
+    }
+
+    private static float sign(float a) {
+        return a >= 0 ? 1.0f : -1.0f;
     }
 
     @Deprecated
@@ -734,6 +851,7 @@ public class SceneObject extends HybridObject {
     }
 
     public Matrix4f matrixWorld() {
+        SceneCommands.flush();
         synchronized (sTempValuesForJni) {
             getMatrixWorld(getNative(), sTempValuesForJni);
             return new Matrix4f(
@@ -832,7 +950,9 @@ public class SceneObject extends HybridObject {
     /**
      * Call this when you update {@code View} size after rendered.
      *
-     * @param updateMeshToView Update mesh to new View size.
+     * @param updateMeshToView Update mesh to new View size. A quad mesh used only by this object is
+     *                         resized in place. Otherwise a new quad is made, so others using the
+     *                         mesh keep their size.
      */
     public void updateViewLayout(boolean updateMeshToView) {
         View view = view();
@@ -842,7 +962,13 @@ public class SceneObject extends HybridObject {
         view.layout(0, 0, view.getMeasuredWidth(), view.getMeasuredHeight());
 
         if (updateMeshToView) {
-            mesh(Mesh.from(view));
+            Mesh mesh = mesh();
+            if (mesh != null && mesh.isQuad() && !mesh.isShared()) {
+                float scaleFactor = Mesh.getDefaultScaleFactor();
+                mesh.updateQuad(scaleFactor * view.getMeasuredWidth(), scaleFactor * view.getMeasuredHeight());
+            } else {
+                mesh(Mesh.from(view));
+            }
         }
     }
 
@@ -28,18 +28,35 @@ import android.view.Surface;
 import android.view.View;
 import android.view.ViewGroup;
 
+/**
+ * Texture of a {@link Material}. The {@code SurfaceTexture} needs the GL context, so it is created
+ * in the first {@link #update(Frame)} on the GL thread. Sources can be set from any thread.
+ * <p>
+ * Canvas sources are rendered at a level of resolution picked from how large the material is drawn:
+ * level n is 1/2^n of the renderer size. A level finer than needed is kept, so coming closer doesn't
+ * show blur, and the level changes only when the needed one moves out of that range.
+ */
 public class Texture {
 
-    private final SurfaceTexture mSurfaceTexture;
-    private CanvasRenderer mRenderer;
-    private boolean mContinuesUpdate;
+    private static final int MAX_LEVEL = 4;
+
+    private final Material mMaterial;
+    private SurfaceTexture mSurfaceTexture;
+    private volatile CanvasRenderer mRenderer;
+    private volatile boolean mContinuesUpdate;
+    private volatile MediaPlayer mPendingMediaPlayer;
+    private int mWidth;
+    private int mHeight;
+    private int mLevel;
 
-    Texture(SurfaceTexture surfaceTexture) {
-        this.mSurfaceTexture = surfaceTexture;
+    Texture(Material material) {
+        this.mMaterial = material;
     }
 
     void release() {
-        mSurfaceTexture.release();
+        if (mSurfaceTexture != null) {
+            mSurfaceTexture.release();
+        }
     }
 
     /**
@@ -85,11 +102,8 @@ public class Texture {
      * @param mediaPlayer
      */
     public void set(MediaPlayer mediaPlayer) {
+        this.mPendingMediaPlayer = mediaPlayer;
         this.mContinuesUpdate = true;
-
-        Surface surface = new Surface(mSurfaceTexture);
-        mediaPlayer.setSurface(surface);
-        surface.release();
     }
 
     /**
@@ -107,17 +121,47 @@ public class Texture {
      * @param vrFrame
      */
     public void update(Frame vrFrame) {
-        if (mRenderer != null) {
+        final CanvasRenderer renderer = mRenderer;
+        final MediaPlayer mediaPlayer = mPendingMediaPlayer;
+
+        if (mSurfaceTexture == null) {
+            if (renderer == null && mediaPlayer == null) {
+                return;
+            }
+            mSurfaceTexture = mMaterial.getSurfaceTexture();
+        }
 
-            if (mRenderer.isDirty()) {
+        if (mediaPlayer != null) {
+            mPendingMediaPlayer = null;
 
-                mSurfaceTexture.setDefaultBufferSize(mRenderer.getWidth(), mRenderer.getHeight());
+            Surface surface = new Surface(mSurfaceTexture);
+            mediaPlayer.setSurface(surface);
+            surface.release();
+        }
+
+        if (renderer != null) {
+
+            final int level = selectLevel(renderer, mMaterial.takeScreenPixels());
+
+            if (renderer.isDirty() || level != mLevel) {
+
+                mLevel = level;
+                final int width = Math.max(1, renderer.getWidth() >> level);
+                final int height = Math.max(1, renderer.getHeight() >> level);
+                mSurfaceTexture.setDefaultBufferSize(width, height);
+                if (width != mWidth || height != mHeight) {
+                    mWidth = width;
+                    mHeight = height;
+                    mMaterial.setTextureSize(width, height);
+                }
 
                 Surface surface = new Surface(mSurfaceTexture);
 
                 try {
                     Canvas canvas = surface.lockCanvas(null);
-                    mRenderer.render(canvas, vrFrame);
+                    final float scale = 1.0f / (1 << level);
+                    canvas.scale(scale, scale);
+                    renderer.render(canvas, vrFrame);
                     surface.unlockCanvasAndPost(canvas);
                 } finally {
                     surface.release();
@@ -131,6 +175,34 @@ public class Texture {
         }
     }
 
+    /**
+     * @return Level of resolution the canvas source is rendered at. 0 is full size.
+     */
+    public int getLevel() {
+        return mLevel;
+    }
+
+    private int selectLevel(CanvasRenderer renderer, float screenPixels) {
+
+        // Keep the level while not drawn.
+        if (screenPixels <= 0.0f) {
+            return mLevel;
+        }
+
+        // The coarsest level which still has a texel per pixel.
+        final int size = Math.max(renderer.getWidth(), renderer.getHeight());
+        int needed = 0;
+        while (needed < MAX_LEVEL && (size >> (needed + 1)) >= screenPixels) {
+            needed++;
+        }
+
+        // One level finer than needed is resident.
+        if (needed < mLevel || needed > mLevel + 1) {
+            return Math.max(0, needed - 1);
+        }
+        return mLevel;
+    }
+
     /**
      * Interface for custom texture rendering.
      */
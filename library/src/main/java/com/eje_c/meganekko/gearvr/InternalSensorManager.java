@@ -31,7 +31,7 @@ class InternalSensorManager {
 
         @Override
         public void onSensorChanged(SensorEvent event) {
-            setSensorValues(mAppPtr, event.values[0], event.values[1], event.values[2], event.values[3]);
+            setSensorValues(mAppPtr, event.values[0], event.values[1], event.values[2], event.values[3], event.timestamp);
         }
 
         @Override
@@ -49,7 +49,7 @@ class InternalSensorManager {
         mSensor = mSensorManager.getDefaultSensor(Sensor.TYPE_GAME_ROTATION_VECTOR);
     }
 
-    private static native void setSensorValues(long appPtr, float x, float y, float z, float w);
+    private static native void setSensorValues(long appPtr, float x, float y, float z, float w, long timestamp);
 
     public void start() {
         mSensorManager.registerListener(mSensorEventListener, mSensor, SensorManager.SENSOR_DELAY_FASTEST);
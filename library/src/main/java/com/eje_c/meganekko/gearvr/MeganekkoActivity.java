@@ -26,6 +26,7 @@ import android.view.KeyEvent;
 import com.eje_c.meganekko.Frame;
 import com.eje_c.meganekko.Meganekko;
 import com.eje_c.meganekko.MeganekkoApp;
+import com.eje_c.meganekko.NativeMemory;
 import com.eje_c.meganekko.utility.DockEventReceiver;
 import com.oculus.vrappframework.VrActivity;
 
@@ -72,6 +73,8 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
 
     private static native void recenterPose(long appPtr);
 
+    private static native float getPoseLatency(long appPtr, boolean latched);
+
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
@@ -109,6 +112,12 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
         }
     }
 
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+        NativeMemory.onTrimMemory(level);
+    }
+
     /**
      * Called from native AppInterface::oneTimeInit().
      */
@@ -133,7 +142,7 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
             meganekkoApp.setFrame(vrFrame);
         }
 
-        meganekkoApp.update();
+        meganekkoApp.onFrame();
     }
 
     /**
@@ -141,6 +150,7 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
      */
     private void oneTimeShutDown() {
 
+        meganekkoApp.stopUpdateThread();
         meganekkoApp.shutdown();
 
         if (!mDocked) {
@@ -175,27 +185,27 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
     }
 
     public boolean onKeyShortPress(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyShortPress(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_SHORT_PRESS, keyCode, repeatCount);
     }
 
     public boolean onKeyDoubleTap(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyDoubleTap(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_DOUBLE_TAP, keyCode, repeatCount);
     }
 
     public boolean onKeyLongPress(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyLongPress(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_LONG_PRESS, keyCode, repeatCount);
     }
 
     public boolean onKeyDown(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyDown(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_DOWN, keyCode, repeatCount);
     }
 
     public boolean onKeyUp(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyUp(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_UP, keyCode, repeatCount);
     }
 
     public boolean onKeyMax(int keyCode, int repeatCount) {
-        return meganekkoApp.onKeyMax(keyCode, repeatCount);
+        return meganekkoApp.dispatchKeyEvent(MeganekkoApp.KEY_MAX, keyCode, repeatCount);
     }
 
     @Deprecated
@@ -221,6 +231,18 @@ public abstract class MeganekkoActivity extends VrActivity implements Meganekko
         recenterPose(getAppPtr());
     }
 
+    /**
+     * Get seconds from sampling the head pose which eye views are rendered with, to submitting them.
+     * Averaged over recent frames.
+     *
+     * @param latched If true, from sampling the pose again just before rendering. If false, from the
+     *                start of the frame, where the pose would be sampled without late latching.
+     * @return Pose latency in seconds.
+     */
+    public float getPoseLatency(boolean latched) {
+        return getPoseLatency(getAppPtr(), latched);
+    }
+
     public App getApp() {
         return mApp;
     }
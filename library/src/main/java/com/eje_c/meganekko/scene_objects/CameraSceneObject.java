@@ -42,11 +42,16 @@ public class CameraSceneObject extends SceneObject {
      *               calls {@link Camera#setPreviewTexture(SurfaceTexture)} so you
      *               should be sure to call it before you call
      *               {@link Camera#startPreview()}.
+     *               <p/>
+     *               Must be called on the GL thread, because the {@code SurfaceTexture} is created there.
      */
     public CameraSceneObject(Mesh mesh, Camera camera) {
         super(mesh);
 
         mSurfaceTexture = getRenderData().getMaterial().getSurfaceTexture();
+        if (mSurfaceTexture == null) {
+            throw new IllegalStateException("CameraSceneObject must be created on the GL thread.");
+        }
 
         try {
             camera.setPreviewTexture(mSurfaceTexture);
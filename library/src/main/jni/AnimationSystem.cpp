@@ -0,0 +1,377 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "AnimationSystem.h"
+#include "SceneObject.h"
+#include "util/HandleTable.h"
+#include "util/TransformStore.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ANIMATION_NEON
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ANIMATION_SSE
+#endif
+
+namespace mgn {
+
+AnimationSystem animation_system;
+
+/*
+ * 4 lane operations used by the kernels.
+ */
+#if defined(ANIMATION_NEON)
+typedef float32x4_t Lanes;
+
+static inline Lanes Load(const float * p) { return vld1q_f32(p); }
+static inline void Store(float * p, Lanes a) { vst1q_f32(p, a); }
+static inline Lanes Splat(float f) { return vdupq_n_f32(f); }
+static inline Lanes Add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+static inline Lanes Sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+static inline Lanes Abs(Lanes a) { return vabsq_f32(a); }
+
+static inline Lanes Sign(Lanes a) {
+    return vbslq_f32(vcltq_f32(a, vdupq_n_f32(0.0f)), vdupq_n_f32(-1.0f), vdupq_n_f32(1.0f));
+}
+
+// The estimate has 8 bits, and each Newton-Raphson step doubles them.
+static inline Lanes Rsqrt(Lanes a) {
+    Lanes e = vrsqrteq_f32(a);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+    return e;
+}
+#elif defined(ANIMATION_SSE)
+typedef __m128 Lanes;
+
+static inline Lanes Load(const float * p) { return _mm_loadu_ps(p); }
+static inline void Store(float * p, Lanes a) { _mm_storeu_ps(p, a); }
+static inline Lanes Splat(float f) { return _mm_set1_ps(f); }
+static inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes Abs(Lanes a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+static inline Lanes Sign(Lanes a) {
+    const Lanes negative = _mm_cmplt_ps(a, _mm_setzero_ps());
+    return _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-1.0f)), _mm_andnot_ps(negative, _mm_set1_ps(1.0f)));
+}
+
+// The estimate has 12 bits, and a Newton-Raphson step doubles them.
+static inline Lanes Rsqrt(Lanes a) {
+    const Lanes e = _mm_rsqrt_ps(a);
+    return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), e),
+            _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(a, e), e)));
+}
+#else
+struct Lanes {
+    float v[4];
+};
+
+static inline Lanes Load(const float * p) { Lanes r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+static inline void Store(float * p, Lanes a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+static inline Lanes Splat(float f) { Lanes r; for (int i = 0; i < 4; ++i) r.v[i] = f; return r; }
+static inline Lanes Add(Lanes a, Lanes b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline Lanes Sub(Lanes a, Lanes b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+static inline Lanes Mul(Lanes a, Lanes b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static inline Lanes Abs(Lanes a) { for (int i = 0; i < 4; ++i) a.v[i] = fabsf(a.v[i]); return a; }
+static inline Lanes Sign(Lanes a) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] < 0.0f ? -1.0f : 1.0f; return a; }
+static inline Lanes Rsqrt(Lanes a) { for (int i = 0; i < 4; ++i) a.v[i] = 1.0f / sqrtf(a.v[i]); return a; }
+#endif
+
+// from = from + (to - from) * t, for each component.
+static void LerpLanes(float * const from[4], const float * const to[4], const float * t, int components, size_t count) {
+    for (size_t i = 0; i < count; i += 4) {
+        const Lanes lt = Load(t + i);
+        for (int c = 0; c < components; ++c) {
+            const Lanes a = Load(from[c] + i);
+            Store(from[c] + i, Add(a, Mul(Sub(Load(to[c] + i), a), lt)));
+        }
+    }
+}
+
+// from = slerp(from, to, t) of unit quaternions, through the shorter arc. Lerp with a corrected t
+// and a normalization, which stays within 1e-3 of slerp without acos nor sin.
+static void SlerpLanes(float * const from[4], const float * const to[4], const float * t, size_t count) {
+    const Lanes one = Splat(1.0f);
+    const Lanes half = Splat(0.5f);
+
+    for (size_t i = 0; i < count; i += 4) {
+        const Lanes ax = Load(from[0] + i), ay = Load(from[1] + i), az = Load(from[2] + i), aw = Load(from[3] + i);
+        const Lanes bx = Load(to[0] + i), by = Load(to[1] + i), bz = Load(to[2] + i), bw = Load(to[3] + i);
+        const Lanes lt = Load(t + i);
+
+        const Lanes dot = Add(Add(Mul(ax, bx), Mul(ay, by)), Add(Mul(az, bz), Mul(aw, bw)));
+        const Lanes d = Abs(dot);
+
+        // Fitted to slerp over the range of d.
+        const Lanes ka = Add(Splat(1.0904f), Mul(d, Add(Splat(-3.2452f), Mul(d, Sub(Splat(3.55645f), Mul(d, Splat(1.43519f)))))));
+        const Lanes kb = Add(Splat(0.848013f), Mul(d, Add(Splat(-1.06021f), Mul(d, Splat(0.215638f)))));
+        const Lanes h = Sub(lt, half);
+        const Lanes k = Add(Mul(Mul(ka, h), h), kb);
+        const Lanes ot = Add(lt, Mul(Mul(Mul(lt, h), Sub(lt, one)), k));
+
+        const Lanes wa = Sub(one, ot);
+        const Lanes wb = Mul(ot, Sign(dot));
+        const Lanes rx = Add(Mul(ax, wa), Mul(bx, wb));
+        const Lanes ry = Add(Mul(ay, wa), Mul(by, wb));
+        const Lanes rz = Add(Mul(az, wa), Mul(bz, wb));
+        const Lanes rw = Add(Mul(aw, wa), Mul(bw, wb));
+        const Lanes n = Rsqrt(Add(Add(Mul(rx, rx), Mul(ry, ry)), Add(Mul(rz, rz), Mul(rw, rw))));
+
+        Store(from[0] + i, Mul(rx, n));
+        Store(from[1] + i, Mul(ry, n));
+        Store(from[2] + i, Mul(rz, n));
+        Store(from[3] + i, Mul(rw, n));
+    }
+}
+
+static float Ease(float t, int easing) {
+    switch (easing) {
+    case EASING_IN:
+        return t * t;
+    case EASING_OUT:
+        return t * (2.0f - t);
+    case EASING_IN_OUT:
+        return t * t * (3.0f - 2.0f * t);
+    case EASING_LINEAR:
+    default:
+        return t;
+    }
+}
+
+void AnimationSystem::Batch::Clear() {
+    count = 0;
+    for (int c = 0; c < 4; ++c) {
+        from[c].clear();
+        to[c].clear();
+    }
+    t.clear();
+    dest.clear();
+    dirty.clear();
+}
+
+void AnimationSystem::Batch::Add(const float * a, const float * b, float t, float * dest, float * dirty) {
+    for (int c = 0; c < components; ++c) {
+        from[c].push_back(a[c]);
+        to[c].push_back(b[c]);
+    }
+    this->t.push_back(t);
+    this->dest.push_back(dest);
+    this->dirty.push_back(dirty);
+    count++;
+}
+
+void AnimationSystem::Batch::Pad() {
+    // Identity quaternions, so that the normalization of padding lanes doesn't divide by 0.
+    static const float identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    while (count % 4 != 0) {
+        Add(identity, identity, 0.0f, nullptr, nullptr);
+    }
+}
+
+void AnimationSystem::Batch::Scatter() const {
+    for (size_t i = 0; i < count; ++i) {
+        if (dest[i] == nullptr) {
+            continue;
+        }
+        for (int c = 0; c < components; ++c) {
+            dest[i][c] = from[c][i];
+        }
+        *dirty[i] = 1.0f;
+    }
+}
+
+AnimationSystem::AnimationSystem() :
+        nextId(1) {
+    pthread_mutex_init(&mutex, nullptr);
+    vectors.components = 3;
+    vectors.count = 0;
+    rotations.components = 4;
+    rotations.count = 0;
+}
+
+AnimationSystem::~AnimationSystem() {
+    pthread_mutex_destroy(&mutex);
+}
+
+int AnimationSystem::Start(jlong sceneObject, const std::vector<AnimationTrack> & tracks,
+        const std::vector<Keyframe> & keys, bool loop) {
+
+    Animation animation;
+    animation.target = sceneObject;
+    animation.startTime = -1.0;
+    animation.duration = 0.0f;
+    animation.loop = loop;
+    animation.tracks = tracks;
+    animation.keys = keys;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        animation.duration = std::max(animation.duration, it->time);
+    }
+
+    lock();
+    animation.id = nextId++;
+    pending.push_back(animation);
+    unlock();
+
+    return animation.id;
+}
+
+void AnimationSystem::Cancel(int id) {
+    lock();
+    cancelled.push_back(id);
+    unlock();
+}
+
+void AnimationSystem::Update(double now) {
+    lock();
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        active.push_back(std::move(*it));
+    }
+    pending.clear();
+    for (auto it = cancelled.begin(); it != cancelled.end(); ++it) {
+        const int id = *it;
+        active.erase(std::remove_if(active.begin(), active.end(), [id](const Animation & animation) {
+            return animation.id == id;
+        }), active.end());
+    }
+    cancelled.clear();
+    unlock();
+
+    if (active.empty()) {
+        return;
+    }
+
+    vectors.Clear();
+    rotations.Clear();
+    std::vector<int> ended;
+
+    // Find the segment and the eased t of each track. Opacity is a single float, so it is set here.
+    size_t kept = 0;
+    for (size_t i = 0; i < active.size(); ++i) {
+        Animation & animation = active[i];
+
+        if (!native_handles.IsValid(animation.target)) {
+            ended.push_back(animation.id);
+            continue;
+        }
+        SceneObject * object = FromHandle<SceneObject>(animation.target);
+        TransformSlot * slot = transform_store.Get(object->GetTransformId());
+
+        if (animation.startTime < 0.0) {
+            animation.startTime = now;
+        }
+        float time = static_cast<float>(now - animation.startTime);
+        bool end = false;
+        if (time >= animation.duration) {
+            if (animation.loop && animation.duration > 0.0f) {
+                time = fmodf(time, animation.duration);
+            } else {
+                time = animation.duration;
+                end = true;
+            }
+        }
+
+        for (auto it = animation.tracks.begin(); it != animation.tracks.end(); ++it) {
+            const AnimationTrack & track = *it;
+            const Keyframe * keys = &animation.keys[track.firstKey];
+            const Keyframe * a = keys;
+            const Keyframe * b = keys;
+            float t = 0.0f;
+
+            if (track.keyCount > 1) {
+                uint32_t k = 1;
+                while (k + 1 < track.keyCount && keys[k].time <= time) {
+                    ++k;
+                }
+                a = &keys[k - 1];
+                b = &keys[k];
+                const float span = b->time - a->time;
+                t = span > 0.0f ? std::min(std::max((time - a->time) / span, 0.0f), 1.0f) : 1.0f;
+                t = Ease(t, b->easing);
+            }
+
+            switch (track.property) {
+            case ANIMATION_POSITION:
+                vectors.Add(a->value, b->value, t, &slot->position.x, &slot->dirty);
+                break;
+            case ANIMATION_SCALE:
+                vectors.Add(a->value, b->value, t, &slot->scale.x, &slot->dirty);
+                break;
+            case ANIMATION_ROTATION:
+                rotations.Add(a->value, b->value, t, &slot->rotation.x, &slot->dirty);
+                break;
+            case ANIMATION_OPACITY:
+                object->SetOpacity(a->value[0] + (b->value[0] - a->value[0]) * t);
+                break;
+            }
+        }
+
+        if (end) {
+            ended.push_back(animation.id);
+        } else {
+            if (kept != i) {
+                active[kept] = std::move(animation);
+            }
+            kept++;
+        }
+    }
+    active.erase(active.begin() + kept, active.end());
+
+    // Slots never move, so the destinations are still valid after active was compacted.
+    vectors.Pad();
+    float * vectorFrom[4] = { nullptr, nullptr, nullptr, nullptr };
+    const float * vectorTo[4] = { nullptr, nullptr, nullptr, nullptr };
+    for (int c = 0; c < 3; ++c) {
+        vectorFrom[c] = vectors.from[c].data();
+        vectorTo[c] = vectors.to[c].data();
+    }
+    LerpLanes(vectorFrom, vectorTo, vectors.t.data(), 3, vectors.count);
+    vectors.Scatter();
+
+    rotations.Pad();
+    float * rotationFrom[4];
+    const float * rotationTo[4];
+    for (int c = 0; c < 4; ++c) {
+        rotationFrom[c] = rotations.from[c].data();
+        rotationTo[c] = rotations.to[c].data();
+    }
+    SlerpLanes(rotationFrom, rotationTo, rotations.t.data(), rotations.count);
+    rotations.Scatter();
+
+    if (!ended.empty()) {
+        lock();
+        finished.insert(finished.end(), ended.begin(), ended.end());
+        unlock();
+    }
+}
+
+int AnimationSystem::TakeFinished(int * ids, int maxCount) {
+    lock();
+    const int count = std::min(static_cast<int>(finished.size()), maxCount);
+    std::copy(finished.begin(), finished.begin() + count, ids);
+    finished.erase(finished.begin(), finished.begin() + count);
+    unlock();
+    return count;
+}
+
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Keyframe animations of scene objects, evaluated natively.
+ ***************************************************************************/
+
+#ifndef ANIMATION_SYSTEM_H_
+#define ANIMATION_SYSTEM_H_
+
+#include <pthread.h>
+#include <vector>
+
+namespace mgn {
+
+// Same values as KeyframeAnimation.* in Java side.
+enum AnimationProperty {
+    ANIMATION_POSITION = 0,
+    ANIMATION_ROTATION,
+    ANIMATION_SCALE,
+    ANIMATION_OPACITY
+};
+
+enum AnimationEasing {
+    EASING_LINEAR = 0,
+    EASING_IN,
+    EASING_OUT,
+    EASING_IN_OUT
+};
+
+struct Keyframe {
+    float time;     // Seconds from the start of the animation.
+    float value[4]; // xyz, xyzw or opacity.
+    int   easing;   // Of the segment which ends at this key.
+};
+
+struct AnimationTrack {
+    int      property;
+    uint32_t firstKey;
+    uint32_t keyCount;
+};
+
+/**
+ * Animations are added from any thread, and evaluated once per frame on the
+ * GL thread. Segments of all tracks are interpolated in batches: positions and
+ * scales with lerp, rotations with an approximated slerp, 4 lanes at a time
+ * with NEON or SSE. Results are written into transform_store, and only ids of
+ * finished animations go back to Java.
+ */
+class AnimationSystem {
+public:
+    AnimationSystem();
+    ~AnimationSystem();
+
+    // Keys of a track are sorted by time. Returns the id of the animation.
+    int Start(jlong sceneObject, const std::vector<AnimationTrack> & tracks, const std::vector<Keyframe> & keys,
+            bool loop);
+
+    // The animation stops where it is. Its id is not reported as finished.
+    void Cancel(int id);
+
+    // Must be called on the GL thread once per frame.
+    void Update(double now);
+
+    // Moves ids of animations finished since the last call into ids. Returns the count.
+    int TakeFinished(int * ids, int maxCount);
+
+    size_t GetActiveCount() const {
+        return active.size();
+    }
+
+private:
+    AnimationSystem(const AnimationSystem& system);
+    AnimationSystem& operator=(const AnimationSystem& system);
+
+    struct Animation {
+        int id;
+        jlong target;
+        double startTime; // Negative until the first update.
+        float duration;
+        bool loop;
+        std::vector<AnimationTrack> tracks;
+        std::vector<Keyframe> keys;
+    };
+
+    // Structure of arrays for batched interpolation. Lanes are padded to a multiple of 4.
+    struct Batch {
+        int components;
+        size_t count;
+        std::vector<float> from[4];
+        std::vector<float> to[4];
+        std::vector<float> t;
+        std::vector<float *> dest;
+        std::vector<float *> dirty;
+
+        void Clear();
+        void Add(const float * a, const float * b, float t, float * dest, float * dirty);
+        void Pad();
+        void Scatter() const;
+    };
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    int nextId;
+    std::vector<Animation> pending;   // Guarded by mutex.
+    std::vector<int> cancelled;       // Guarded by mutex.
+    std::vector<int> finished;        // Guarded by mutex.
+
+    // Owned by the GL thread.
+    std::vector<Animation> active;
+    Batch vectors;
+    Batch rotations;
+};
+
+extern AnimationSystem animation_system;
+}
+
+#endif
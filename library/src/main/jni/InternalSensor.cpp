@@ -0,0 +1,109 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "InternalSensor.h"
+
+namespace mgn {
+
+// Longer gaps between samples don't give a meaningful velocity.
+static const double MAX_SAMPLE_INTERVAL = 0.1;
+
+// Extrapolating further than this amplifies noise more than it hides latency.
+static const double MAX_PREDICTION = 0.05;
+
+// Weight of a new velocity estimate. Finite differences of the rotation vector sensor are noisy.
+static const float VELOCITY_SMOOTHING = 0.5f;
+
+// A clock offset larger than the smallest seen by this much means the clocks were reset.
+static const double CLOCK_RESYNC = 1.0;
+
+static Vector3f ToRotationVector(const Quatf & q) {
+    // Shortest arc.
+    const float sign = q.w < 0.0f ? -1.0f : 1.0f;
+    const float s = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z);
+    const float factor = s < 1e-6f ? 2.0f * sign : sign * 2.0f * atan2f(s, sign * q.w) / s;
+    return Vector3f(q.x * factor, q.y * factor, q.z * factor);
+}
+
+static Quatf FromRotationVector(const Vector3f & v) {
+    const float angle = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    if (angle < 1e-6f) {
+        return Quatf(v.x * 0.5f, v.y * 0.5f, v.z * 0.5f, 1.0f).Normalized();
+    }
+    const float s = sinf(angle * 0.5f) / angle;
+    return Quatf(v.x * s, v.y * s, v.z * s, cosf(angle * 0.5f));
+}
+
+InternalSensor::InternalSensor() :
+        hasPrevious(false),
+        previousTimestamp(0),
+        clockOffset(0.0),
+        angularVelocity(0.0f, 0.0f, 0.0f) {
+}
+
+void InternalSensor::Push(const Quatf & orientation, int64_t timestamp) {
+
+    // Sensor timestamps are not in the same clock on all devices. The smallest difference seen is
+    // the offset between clocks plus the shortest delivery delay.
+    const double offset = vrapi_GetTimeInSeconds() - timestamp * 1e-9;
+    if (!hasPrevious || offset < clockOffset || offset - clockOffset > CLOCK_RESYNC) {
+        clockOffset = offset;
+    }
+
+    if (hasPrevious) {
+        const double interval = (timestamp - previousTimestamp) * 1e-9;
+        if (interval > 0.0 && interval < MAX_SAMPLE_INTERVAL) {
+            const Vector3f delta = ToRotationVector(previousOrientation.Inverted() * orientation);
+            const float inverse = static_cast<float>(1.0 / interval);
+            angularVelocity.x += (delta.x * inverse - angularVelocity.x) * VELOCITY_SMOOTHING;
+            angularVelocity.y += (delta.y * inverse - angularVelocity.y) * VELOCITY_SMOOTHING;
+            angularVelocity.z += (delta.z * inverse - angularVelocity.z) * VELOCITY_SMOOTHING;
+        } else {
+            angularVelocity = Vector3f(0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    hasPrevious = true;
+    previousOrientation = orientation;
+    previousTimestamp = timestamp;
+
+    SensorSample sample;
+    sample.time = timestamp * 1e-9 + clockOffset;
+    sample.orientation = orientation;
+    sample.angularVelocity = angularVelocity;
+    latest.Write(sample);
+}
+
+Quatf InternalSensor::Predict(double time) const {
+    SensorSample sample;
+    if (!latest.Read(sample)) {
+        return Quatf();
+    }
+
+    double ahead = time - sample.time;
+    if (ahead < 0.0) {
+        ahead = 0.0;
+    } else if (ahead > MAX_PREDICTION) {
+        ahead = MAX_PREDICTION;
+    }
+
+    const float t = static_cast<float>(ahead);
+    const Vector3f rotation(sample.angularVelocity.x * t, sample.angularVelocity.y * t, sample.angularVelocity.z * t);
+    return sample.orientation * FromRotationVector(rotation);
+}
+
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Head orientation from the phone's own rotation sensor, used while the
+ * phone is not docked into the headset.
+ ***************************************************************************/
+
+#ifndef INTERNAL_SENSOR_H_
+#define INTERNAL_SENSOR_H_
+
+#include "util/SeqLock.h"
+
+namespace mgn {
+
+struct SensorSample {
+    double   time;            // Seconds in vrapi_GetTimeInSeconds() clock.
+    Quatf    orientation;
+    Vector3f angularVelocity; // Radians per second, in local coordinates of orientation.
+};
+
+/**
+ * Samples are pushed from the Android sensor thread and read on the VR thread
+ * through a SeqLock. Angular velocity is estimated from consecutive samples and
+ * orientation is extrapolated with it to the display time.
+ */
+class InternalSensor {
+public:
+    InternalSensor();
+
+    // Sensor thread only. timestamp is SensorEvent.timestamp in nanoseconds.
+    void Push(const Quatf & orientation, int64_t timestamp);
+
+    // Orientation predicted for time in vrapi_GetTimeInSeconds() clock. Identity until the first sample.
+    Quatf Predict(double time) const;
+
+private:
+    InternalSensor(const InternalSensor& sensor);
+    InternalSensor& operator=(const InternalSensor& sensor);
+
+    SeqLock<SensorSample> latest;
+
+    // Owned by the sensor thread.
+    bool     hasPrevious;
+    Quatf    previousOrientation;
+    int64_t  previousTimestamp;
+    double   clockOffset;
+    Vector3f angularVelocity;
+};
+}
+
+#endif
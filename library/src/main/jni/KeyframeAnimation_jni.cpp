@@ -0,0 +1,83 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "AnimationSystem.h"
+
+namespace mgn {
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// tracks are (property, key count) pairs, and keys are (time, 4 values, easing) in the order of tracks.
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_KeyframeAnimation_start(JNIEnv * env, jclass clazz, jlong sceneObject,
+        jintArray jtracks, jfloatArray jkeys, jboolean loop) {
+
+    const jsize trackCount = env->GetArrayLength(jtracks) / 2;
+    const jsize keyCount = env->GetArrayLength(jkeys) / 6;
+
+    std::vector<AnimationTrack> tracks(trackCount);
+    std::vector<Keyframe> keys(keyCount);
+
+    jint * t = env->GetIntArrayElements(jtracks, nullptr);
+    uint32_t firstKey = 0;
+    for (jsize i = 0; i < trackCount; ++i) {
+        tracks[i].property = t[i * 2];
+        tracks[i].firstKey = firstKey;
+        tracks[i].keyCount = static_cast<uint32_t>(t[i * 2 + 1]);
+        firstKey += tracks[i].keyCount;
+    }
+    env->ReleaseIntArrayElements(jtracks, t, JNI_ABORT);
+
+    if (firstKey != static_cast<uint32_t>(keyCount)) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "KeyframeAnimation: %u keys in tracks, %d given", firstKey, keyCount);
+        return 0;
+    }
+
+    jfloat * k = env->GetFloatArrayElements(jkeys, nullptr);
+    for (jsize i = 0; i < keyCount; ++i) {
+        const jfloat * key = k + i * 6;
+        keys[i].time = key[0];
+        keys[i].value[0] = key[1];
+        keys[i].value[1] = key[2];
+        keys[i].value[2] = key[3];
+        keys[i].value[3] = key[4];
+        keys[i].easing = static_cast<int>(key[5]);
+    }
+    env->ReleaseFloatArrayElements(jkeys, k, JNI_ABORT);
+
+    return animation_system.Start(sceneObject, tracks, keys, loop);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_KeyframeAnimation_cancel(JNIEnv * env, jclass clazz, jint id) {
+    animation_system.Cancel(id);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_KeyframeAnimation_takeFinished(JNIEnv * env, jclass clazz, jintArray jids) {
+    const jsize length = env->GetArrayLength(jids);
+    jint * ids = env->GetIntArrayElements(jids, nullptr);
+    const int count = animation_system.TakeFinished(ids, length);
+    env->ReleaseIntArrayElements(jids, ids, 0);
+    return count;
+}
+
+#ifdef __cplusplus
+} // extern C
+#endif
+} // namespace mgn
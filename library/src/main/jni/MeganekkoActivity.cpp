@@ -17,15 +17,31 @@
 
 #include "includes.h"
 #include "MeganekkoActivity.h"
+#include "AnimationSystem.h"
 #include "Scene.h"
 #include "SceneObject.h"
+#include "util/GlRingBuffer.h"
+#include "util/GlUpload.h"
+#include "util/GpuMemory.h"
 
 namespace mgn
 {
 
+// Time spent for uploading queued mesh geometries in each frame.
+static const double GL_UPLOAD_BUDGET_SECONDS = 0.002;
+
+// Weight of a new frame in averaged pose latencies.
+static const float POSE_LATENCY_SMOOTHING = 0.05f;
+
 MeganekkoActivity::MeganekkoActivity() :
       GuiSys( OvrGuiSys::Create() ),
       Locale( nullptr ),
+      predictedDisplayTime(0.0),
+      frameStartTime(0.0),
+      poseSampleTime(0.0),
+      docked(false),
+      poseLatency(0.0f),
+      framePoseLatency(0.0f),
       HmdMounted(false)
 {
 }
@@ -95,6 +111,12 @@ void MeganekkoActivity::LeavingVrMode()
 Matrix4f MeganekkoActivity::DrawEyeView(const int eye, const float fovDegreesX, const float fovDegreesY, ovrFrameParms & frameParms)
 {
     Scene* scene = GetScene();
+
+    // Java update and PrepareForRendering are done by now, so the pose is sampled again for both eyes.
+    if (eye == 0) {
+        LatchPose(scene, frameParms);
+    }
+
     ovrMatrix4f centerViewMatrix = scene->GetCenterViewMatrix();
     const Matrix4f eyeViewMatrix = vrapi_GetEyeViewMatrix( &app->GetHeadModelParms(), &centerViewMatrix, eye );
 	const Matrix4f eyeProjectionMatrix = ovrMatrix4f_CreateProjectionFov( fovDegreesX, fovDegreesY, 0.0f, 0.0f, 1.0f, 0.0f );
@@ -105,6 +127,13 @@ Matrix4f MeganekkoActivity::DrawEyeView(const int eye, const float fovDegreesX,
 
     GuiSys->RenderEyeView(centerViewMatrix, eyeViewMatrix, eyeProjectionMatrix);
 
+    // The eye buffers are submitted after the last eye.
+    if (eye == VRAPI_FRAME_LAYER_EYE_MAX - 1) {
+        const double submitTime = vrapi_GetTimeInSeconds();
+        poseLatency += (static_cast<float>(submitTime - poseSampleTime) - poseLatency) * POSE_LATENCY_SMOOTHING;
+        framePoseLatency += (static_cast<float>(submitTime - frameStartTime) - framePoseLatency) * POSE_LATENCY_SMOOTHING;
+    }
+
     return eyeViewProjection;
 
 }
@@ -114,6 +143,10 @@ Matrix4f MeganekkoActivity::Frame( const VrFrame & vrFrame )
     Scene * scene = GetScene();
     JNIEnv * jni = app->GetJava()->Env;
 
+    frameStartTime = vrapi_GetTimeInSeconds();
+    predictedDisplayTime = vrFrame.PredictedDisplayTimeInSeconds;
+    docked = vrFrame.DeviceStatus.DeviceIsDocked;
+
     jni->CallVoidMethod(app->GetJava()->ActivityObject, frameMethodId, (jlong)(intptr_t)&vrFrame);
 
     const bool headsetIsMounted = vrFrame.DeviceStatus.HeadsetIsMounted;
@@ -124,11 +157,7 @@ Matrix4f MeganekkoActivity::Frame( const VrFrame & vrFrame )
     }
     HmdMounted = headsetIsMounted;
 
-    // Apply Camera movement to centerViewMatrix
-    ovrMatrix4f input = vrFrame.DeviceStatus.DeviceIsDocked
-            ? Matrix4f::Translation(scene->GetViewPosition())
-            : Matrix4f::Translation(scene->GetViewPosition()) * Matrix4f(internalSensorRotation);
-    Matrix4f centerViewMatrix = vrapi_GetCenterEyeViewMatrix( &app->GetHeadModelParms(), &vrFrame.Tracking, &input );
+    Matrix4f centerViewMatrix = CenterViewMatrix(scene, vrFrame.Tracking, docked);
 
     scene->SetCenterViewMatrix(centerViewMatrix);
 
@@ -136,12 +165,43 @@ Matrix4f MeganekkoActivity::Frame( const VrFrame & vrFrame )
     GuiSys->Frame( vrFrame, centerViewMatrix);
 
     gl_delete.processQueues();
+    gl_ring.BeginFrame();
+    gl_upload.processQueues(GL_UPLOAD_BUDGET_SECONDS);
+    gpu_memory.BeginFrame();
+    if (!scene->IsTickInterpolated()) {
+        // Otherwise animations advance with fixed rate ticks. See Scene.commitTick().
+        animation_system.Update(vrFrame.PredictedDisplayTimeInSeconds);
+    }
     scene->PrepareForRendering();
 
 
     return centerViewMatrix;
 }
 
+Matrix4f MeganekkoActivity::CenterViewMatrix(Scene * scene, const ovrTracking & tracking, bool docked)
+{
+    // Apply Camera movement to centerViewMatrix
+    ovrMatrix4f input = docked
+            ? Matrix4f::Translation(scene->GetViewPosition())
+            : Matrix4f::Translation(scene->GetViewPosition()) * Matrix4f(internalSensor.Predict(predictedDisplayTime));
+    return vrapi_GetCenterEyeViewMatrix( &app->GetHeadModelParms(), &tracking, &input );
+}
+
+void MeganekkoActivity::LatchPose(Scene * scene, ovrFrameParms & frameParms)
+{
+    // Predicted for the same display time as the frame, but from newer sensor samples.
+    const ovrTracking tracking = vrapi_GetPredictedTracking(app->GetOvrMobile(), predictedDisplayTime);
+    poseSampleTime = vrapi_GetTimeInSeconds();
+
+    // Culling runs per eye in Scene::Render() with these matrices, so it stays valid without a margin.
+    scene->SetCenterViewMatrix(CenterViewMatrix(scene, tracking, docked));
+
+    // Timewarp reprojects from the pose the eye buffers are rendered with.
+    for (int eye = 0; eye < VRAPI_FRAME_LAYER_EYE_MAX; ++eye) {
+        frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].Textures[eye].HeadPose = tracking.HeadPose;
+    }
+}
+
 bool MeganekkoActivity::OnKeyEvent(const int keyCode, const int repeatCount, const KeyEventType eventType)
 {
     bool handled = false;
@@ -21,7 +21,9 @@
 #define ACTIVITY_JNI_H
 
 #include "Scene.h"
+#include "InternalSensor.h"
 #include "OESShader.h"
+#include "util/HandleTable.h"
 
 using namespace OVR;
 
@@ -52,11 +54,18 @@ public:
     }
 
     Scene * GetScene(JNIEnv * jni) {
-        return reinterpret_cast<Scene*>(jni->CallLongMethod(app->GetJava()->ActivityObject, getNativeSceneMethodId));
+        return FromHandle<Scene>(jni->CallLongMethod(app->GetJava()->ActivityObject, getNativeSceneMethodId));
     }
 
-    void SetInternalSensorRotation(const Quatf & q) {
-        internalSensorRotation = q;
+    InternalSensor & GetInternalSensor() {
+        return internalSensor;
+    }
+
+    // Seconds from sampling the head pose which eye views are rendered with, to submitting them. Averaged
+    // over recent frames. If latched is false, it is measured from the start of Frame() instead, which is
+    // where the pose was sampled without late latching.
+    float GetPoseLatency(bool latched) const {
+        return latched ? poseLatency : framePoseLatency;
     }
 
 private:
@@ -64,7 +73,18 @@ private:
     OvrGuiSys::SoundEffectPlayer * SoundEffectPlayer;
     ovrLocale *                    Locale;
 
-    Quatf internalSensorRotation;
+    InternalSensor internalSensor;
+
+    // Late latching. See DrawEyeView().
+    Matrix4f CenterViewMatrix(Scene * scene, const ovrTracking & tracking, bool docked);
+    void     LatchPose(Scene * scene, ovrFrameParms & frameParms);
+
+    double predictedDisplayTime;
+    double frameStartTime;
+    double poseSampleTime;
+    bool   docked;
+    float  poseLatency;
+    float  framePoseLatency;
 
     bool                HmdMounted; // true if the HMT was mounted on the previous frame
 
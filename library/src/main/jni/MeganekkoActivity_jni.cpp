@@ -18,6 +18,7 @@
 #include "includes.h"
 #include "MeganekkoActivity.h"
 #include "RenderData.h"
+#include "util/Worker.h"
 
 namespace mgn {
 #ifdef __cplusplus
@@ -29,6 +30,10 @@ long Java_com_eje_1c_meganekko_gearvr_MeganekkoActivity_nativeSetAppInterface(
         jstring fromPackageName, jstring commandString,
         jstring uriString)
 {
+    JavaVM * vm = nullptr;
+    jni->GetJavaVM(&vm);
+    Worker::SetJavaVM(vm);
+
     return (new MeganekkoActivity())->SetActivity( jni, clazz, activity, fromPackageName, commandString, uriString );
 }
 
@@ -55,6 +60,12 @@ void Java_com_eje_1c_meganekko_gearvr_MeganekkoActivity_recenterPose(JNIEnv * jn
     vrapi_RecenterPose(mobile);
 }
 
+jfloat Java_com_eje_1c_meganekko_gearvr_MeganekkoActivity_getPoseLatency(JNIEnv * jni, jclass clazz, jlong appPtr, jboolean latched)
+{
+    MeganekkoActivity* activity = (MeganekkoActivity*)((App *)appPtr)->GetAppInterface();
+    return activity->GetPoseLatency(latched);
+}
+
 #ifdef __cplusplus 
 } // extern C
 #endif
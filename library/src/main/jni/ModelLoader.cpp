@@ -0,0 +1,258 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "ModelLoader.h"
+#include "util/Worker.h"
+
+#include <assimp/cimport.h>
+#include <assimp/config.h>
+#include <assimp/material.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+namespace mgn {
+
+// Parsing can take seconds, so it has its own thread. Triangles are optimized on worker meanwhile.
+static Worker model_worker("mgn-model");
+
+// Meshes are split so that indices fit in 16 bits, and so that one upload stays within about 1 ms.
+static const int MAX_PART_VERTICES = 65535;
+static const int MAX_PART_TRIANGLES = 65536;
+
+// UVs are flipped so that v = 0 is the top of the texture, same as Mesh.buildQuad().
+static const unsigned int IMPORT_FLAGS = aiProcess_Triangulate
+        | aiProcess_JoinIdenticalVertices
+        | aiProcess_SortByPType
+        | aiProcess_SplitLargeMeshes
+        | aiProcess_FlipUVs;
+
+static aiPropertyStore * CreateImportProperties() {
+    aiPropertyStore * properties = aiCreatePropertyStore();
+    aiSetImportPropertyInteger(properties, AI_CONFIG_PP_SLM_VERTEX_LIMIT, MAX_PART_VERTICES);
+    aiSetImportPropertyInteger(properties, AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, MAX_PART_TRIANGLES);
+
+    // Points and lines can't be drawn by Mesh.
+    aiSetImportPropertyInteger(properties, AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+    return properties;
+}
+
+static std::shared_ptr<PackedVertices> PackPart(const aiMesh * mesh) {
+    const int vertexCount = static_cast<int>(mesh->mNumVertices);
+    std::vector<float> positions(vertexCount * 3);
+    std::vector<float> colors(vertexCount * 4, 1.0f);
+    std::vector<float> uvs(vertexCount * 2, 0.0f);
+    std::vector<int32_t> indices;
+    indices.reserve(mesh->mNumFaces * 3);
+
+    for (int i = 0; i < vertexCount; ++i) {
+        positions[i * 3] = mesh->mVertices[i].x;
+        positions[i * 3 + 1] = mesh->mVertices[i].y;
+        positions[i * 3 + 2] = mesh->mVertices[i].z;
+        if (mesh->HasVertexColors(0)) {
+            const aiColor4D & c = mesh->mColors[0][i];
+            colors[i * 4] = c.r;
+            colors[i * 4 + 1] = c.g;
+            colors[i * 4 + 2] = c.b;
+            colors[i * 4 + 3] = c.a;
+        }
+        if (mesh->HasTextureCoords(0)) {
+            uvs[i * 2] = mesh->mTextureCoords[0][i].x;
+            uvs[i * 2 + 1] = mesh->mTextureCoords[0][i].y;
+        }
+    }
+
+    for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
+        const aiFace & face = mesh->mFaces[f];
+        if (face.mNumIndices == 3) {
+            indices.push_back(face.mIndices[0]);
+            indices.push_back(face.mIndices[1]);
+            indices.push_back(face.mIndices[2]);
+        }
+    }
+
+    std::shared_ptr<PackedVertices> packed(new PackedVertices());
+    PackVertices(positions.data(), colors.data(), uvs.data(), vertexCount,
+            indices.data(), static_cast<int>(indices.size()), true, *packed);
+    return packed;
+}
+
+static void ConvertMaterial(const aiMaterial * material, ModelData::Material & out) {
+    aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+    out.color = Vector4f(diffuse.r, diffuse.g, diffuse.b, diffuse.a);
+
+    float opacity = 1.0f;
+    aiGetMaterialFloat(material, AI_MATKEY_OPACITY, &opacity);
+    out.opacity = opacity;
+
+    int twoSided = 0;
+    aiGetMaterialInteger(material, AI_MATKEY_TWOSIDED, &twoSided);
+    out.twoSided = twoSided != 0;
+}
+
+static void ConvertNode(const aiNode * node, int parent, const std::vector<int> & partOfMesh, ModelData & out) {
+    const int index = static_cast<int>(out.nodes.size());
+    out.nodes.push_back(ModelData::Node());
+    ModelData::Node & converted = out.nodes.back();
+
+    converted.name = node->mName.C_Str();
+    converted.parent = parent;
+
+    // Both are row major.
+    const aiMatrix4x4 & m = node->mTransformation;
+    converted.matrix = Matrix4f(
+            m.a1, m.a2, m.a3, m.a4,
+            m.b1, m.b2, m.b3, m.b4,
+            m.c1, m.c2, m.c3, m.c4,
+            m.d1, m.d2, m.d3, m.d4);
+
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
+        const int part = partOfMesh[node->mMeshes[i]];
+        if (part >= 0) {
+            converted.parts.push_back(part);
+        }
+    }
+
+    // converted is invalidated from here.
+    for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+        ConvertNode(node->mChildren[i], index, partOfMesh, out);
+    }
+}
+
+// Runs on model_worker. Takes the scene.
+static void Convert(const aiScene * scene, ModelData & out) {
+    if (scene == nullptr || scene->mRootNode == nullptr) {
+        out.error = scene == nullptr ? aiGetErrorString() : "The file has no nodes";
+        out.state.store(ModelData::FAILED, std::memory_order_release);
+        aiReleaseImport(scene);
+        return;
+    }
+
+    out.materials.resize(scene->mNumMaterials);
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i) {
+        ConvertMaterial(scene->mMaterials[i], out.materials[i]);
+    }
+
+    std::vector<int> partOfMesh(scene->mNumMeshes, -1);
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+        const aiMesh * mesh = scene->mMeshes[i];
+        if ((mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0 || mesh->mNumFaces == 0) {
+            continue;
+        }
+
+        ModelData::Part part;
+        part.packed = PackPart(mesh);
+        part.material = mesh->mMaterialIndex < scene->mNumMaterials ? static_cast<int>(mesh->mMaterialIndex) : -1;
+
+        std::shared_ptr<PackedVertices> packed = part.packed;
+        worker.Post([packed]() {
+            OptimizePackedVertices(*packed, false, 1);
+        });
+
+        partOfMesh[i] = static_cast<int>(out.parts.size());
+        out.parts.push_back(part);
+    }
+
+    ConvertNode(scene->mRootNode, -1, partOfMesh, out);
+    aiReleaseImport(scene);
+
+    out.state.store(ModelData::LOADED, std::memory_order_release);
+}
+
+void ModelLoader::LoadFile(const std::string & path) {
+    std::shared_ptr<ModelData> result = data;
+    model_worker.Post([result, path]() {
+        aiPropertyStore * properties = CreateImportProperties();
+        const aiScene * scene = aiImportFileExWithProperties(path.c_str(), IMPORT_FLAGS, nullptr, properties);
+        aiReleasePropertyStore(properties);
+        Convert(scene, *result);
+    });
+}
+
+static void ReadAsset(AAssetManager * assets, const std::string & path, ModelData & result) {
+    AAsset * asset = AAssetManager_open(assets, path.c_str(), AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        result.error = "Can't open asset " + path;
+        result.state.store(ModelData::FAILED, std::memory_order_release);
+        return;
+    }
+
+    const void * buffer = AAsset_getBuffer(asset);
+    if (buffer == nullptr) {
+        AAsset_close(asset);
+        result.error = "Can't read asset " + path;
+        result.state.store(ModelData::FAILED, std::memory_order_release);
+        return;
+    }
+
+    // The extension tells assimp the format.
+    const size_t dot = path.rfind('.');
+    const std::string hint = dot != std::string::npos ? path.substr(dot + 1) : std::string();
+
+    aiPropertyStore * properties = CreateImportProperties();
+    const aiScene * scene = aiImportFileFromMemoryWithProperties(
+            static_cast<const char*>(buffer), static_cast<unsigned int>(AAsset_getLength(asset)),
+            IMPORT_FLAGS, hint.c_str(), properties);
+    aiReleasePropertyStore(properties);
+    AAsset_close(asset);
+    Convert(scene, result);
+}
+
+void ModelLoader::LoadAsset(JNIEnv * env, jobject assetManager, const std::string & path) {
+    std::shared_ptr<ModelData> result = data;
+
+    // The AAssetManager is valid only while the Java AssetManager is reachable.
+    JavaVM * vm = nullptr;
+    env->GetJavaVM(&vm);
+    const jobject assetManagerRef = env->NewGlobalRef(assetManager);
+    AAssetManager * assets = AAssetManager_fromJava(env, assetManagerRef);
+
+    model_worker.Post([result, vm, assetManagerRef, assets, path]() {
+        ReadAsset(assets, path, *result);
+
+        // Workers are attached to the JavaVM.
+        JNIEnv * env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+            env->DeleteGlobalRef(assetManagerRef);
+        } else {
+            __android_log_print(ANDROID_LOG_ERROR, "mgn", "ModelLoader::LoadAsset() : released on a detached thread");
+        }
+    });
+}
+
+void ModelLoader::SetupMesh(int part, Mesh * mesh) {
+    if (GetState() != ModelData::LOADED || part < 0 || part >= static_cast<int>(data->parts.size())) {
+        return;
+    }
+
+    std::shared_ptr<PackedVertices> packed;
+    packed.swap(data->parts[part].packed);
+    if (packed) {
+        mesh->QueuePackedVertices(packed);
+    }
+}
+
+void ModelLoader::Release() {
+    if (GetState() == ModelData::LOADING) {
+        return;
+    }
+    std::vector<ModelData::Node>().swap(data->nodes);
+    std::vector<ModelData::Part>().swap(data->parts);
+    std::vector<ModelData::Material>().swap(data->materials);
+}
+
+}
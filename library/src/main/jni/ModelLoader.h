@@ -0,0 +1,115 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Loads model files with assimp in the background.
+ ***************************************************************************/
+
+#ifndef MODEL_LOADER_H_
+#define MODEL_LOADER_H_
+
+#include <atomic>
+
+#include "HybridObject.h"
+#include "Mesh.h"
+
+namespace mgn {
+
+/**
+ * What a model file turns into. Filled on the model worker, then only read.
+ * Nodes are in depth first order, so a parent comes before its children.
+ * Shared with the job, so the loader can be deleted while it runs.
+ */
+struct ModelData {
+    // Same as ModelLoader.STATE_* in Java side.
+    enum State {
+        LOADING = 0, LOADED, FAILED
+    };
+
+    ModelData() :
+            state(LOADING) {
+    }
+
+    struct Node {
+        std::string name;
+        Matrix4f matrix;
+        int parent; // -1 for the root
+        std::vector<int> parts;
+    };
+
+    // A mesh of the file. Triangles are optimized on the worker, after parsing.
+    struct Part {
+        std::shared_ptr<PackedVertices> packed;
+        int material; // -1 if the file has none
+    };
+
+    struct Material {
+        Vector4f color;
+        float opacity;
+        bool twoSided;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Part> parts;
+    std::vector<Material> materials;
+    std::string error;
+    std::atomic<int> state;
+};
+
+/**
+ * Parses a model file and prepares vertices off the GL thread. Java builds
+ * scene objects from the result a few nodes per frame; meshes are uploaded by
+ * gl_upload under its frame budget. Large meshes are split on import, so one
+ * upload never takes long.
+ */
+class ModelLoader: public HybridObject {
+public:
+    ModelLoader() :
+            data(new ModelData()) {
+    }
+
+    // Can be called on any thread. The file is read on the model worker.
+    void LoadFile(const std::string & path);
+
+    // Same as LoadFile(). A global reference to the AssetManager is held until the asset is read.
+    void LoadAsset(JNIEnv * env, jobject assetManager, const std::string & path);
+
+    ModelData::State GetState() const {
+        return static_cast<ModelData::State>(data->state.load(std::memory_order_acquire));
+    }
+
+    // Valid once the state is LOADED or FAILED.
+    const ModelData & GetData() const {
+        return *data;
+    }
+
+    // Queues upload of a part to the mesh. The vertices are released after upload.
+    void SetupMesh(int part, Mesh * mesh);
+
+    // Releases parsed data which was not taken by meshes.
+    void Release();
+
+private:
+    ModelLoader(const ModelLoader& loader);
+    ModelLoader& operator=(const ModelLoader& loader);
+
+    std::shared_ptr<ModelData> data;
+};
+
+}
+#endif
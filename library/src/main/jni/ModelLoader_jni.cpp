@@ -0,0 +1,130 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "ModelLoader.h"
+#include "SceneObject.h"
+#include "util/HandleTable.h"
+
+namespace mgn {
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_initNativeInstance(JNIEnv * env, jobject obj) {
+    return NewHandle(new ModelLoader());
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_loadFile(JNIEnv * env, jobject obj, jlong jloader, jstring jpath) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    const char * path = env->GetStringUTFChars(jpath, 0);
+    loader->LoadFile(path);
+    env->ReleaseStringUTFChars(jpath, path);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_loadAsset(JNIEnv * env, jobject obj, jlong jloader, jobject jassetManager,
+        jstring jpath) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    const char * path = env->GetStringUTFChars(jpath, 0);
+    loader->LoadAsset(env, jassetManager, path);
+    env->ReleaseStringUTFChars(jpath, path);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getState(JNIEnv * env, jobject obj, jlong jloader) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return loader->GetState();
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getError(JNIEnv * env, jobject obj, jlong jloader) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return env->NewStringUTF(loader->GetData().error.c_str());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getNodeCount(JNIEnv * env, jobject obj, jlong jloader) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return static_cast<jint>(loader->GetData().nodes.size());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getNodeParent(JNIEnv * env, jobject obj, jlong jloader, jint node) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return loader->GetData().nodes[node].parent;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getNodeName(JNIEnv * env, jobject obj, jlong jloader, jint node) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return env->NewStringUTF(loader->GetData().nodes[node].name.c_str());
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getNodeParts(JNIEnv * env, jobject obj, jlong jloader, jint node) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    const std::vector<int> & parts = loader->GetData().nodes[node].parts;
+    jintArray jparts = env->NewIntArray(static_cast<jsize>(parts.size()));
+    if (!parts.empty()) {
+        env->SetIntArrayRegion(jparts, 0, static_cast<jsize>(parts.size()), reinterpret_cast<const jint*>(parts.data()));
+    }
+    return jparts;
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_setupNode(JNIEnv * env, jobject obj, jlong jloader, jint node,
+        jlong jsceneObject) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
+    sceneObject->SetMatrixLocal(loader->GetData().nodes[node].matrix);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getPartMaterial(JNIEnv * env, jobject obj, jlong jloader, jint part) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    return loader->GetData().parts[part].material;
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_setupMesh(JNIEnv * env, jobject obj, jlong jloader, jint part, jlong jmesh) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    loader->SetupMesh(part, mesh);
+}
+
+// values: r, g, b, a, opacity, two sided (0 or 1).
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_getMaterial(JNIEnv * env, jobject obj, jlong jloader, jint material,
+        jfloatArray jvalues) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    const ModelData::Material & m = loader->GetData().materials[material];
+    const jfloat values[] = { m.color.x, m.color.y, m.color.z, m.color.w, m.opacity, m.twoSided ? 1.0f : 0.0f };
+    env->SetFloatArrayRegion(jvalues, 0, 6, values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_ModelLoader_release(JNIEnv * env, jobject obj, jlong jloader) {
+    ModelLoader* loader = FromHandle<ModelLoader>(jloader);
+    loader->Release();
+}
+
+#ifdef __cplusplus
+}
+#endif
+}
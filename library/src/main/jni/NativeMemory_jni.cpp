@@ -0,0 +1,102 @@
+/* 
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "util/GlDelete.h"
+#include "util/GpuMemory.h"
+#include "util/MeshCache.h"
+#include "util/ObjectPool.h"
+
+namespace mgn {
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getLiveCount(JNIEnv * env, jclass clazz, jint type) {
+    ObjectPool * pool = ObjectPool::Get(static_cast<PoolType>(type));
+    return pool != nullptr ? static_cast<jint>(pool->GetLiveCount()) : 0;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getLiveBytes(JNIEnv * env, jclass clazz, jint type) {
+    ObjectPool * pool = ObjectPool::Get(static_cast<PoolType>(type));
+    return pool != nullptr ? static_cast<jlong>(pool->GetLiveBytes()) : 0;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getReservedBytes(JNIEnv * env, jclass clazz, jint type) {
+    ObjectPool * pool = ObjectPool::Get(static_cast<PoolType>(type));
+    return pool != nullptr ? static_cast<jlong>(pool->GetReservedBytes()) : 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_trim(JNIEnv * env, jclass clazz) {
+    for (int type = 0; type < POOL_TYPE_COUNT; ++type) {
+        ObjectPool * pool = ObjectPool::Get(static_cast<PoolType>(type));
+        if (pool != nullptr) {
+            pool->Trim();
+        }
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getGlDeletePendingCount(JNIEnv * env, jclass clazz) {
+    return static_cast<jint>(gl_delete.getPendingCount());
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getGlDeletePendingBytes(JNIEnv * env, jclass clazz) {
+    return static_cast<jlong>(gl_delete.getPendingBytes());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getSharedMeshCount(JNIEnv * env, jclass clazz) {
+    return static_cast<jint>(mesh_cache.GetCount());
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getGpuBytes(JNIEnv * env, jclass clazz, jint category) {
+    if (category < 0 || category >= GPU_MEMORY_CATEGORY_COUNT) {
+        return 0;
+    }
+    return static_cast<jlong>(gpu_memory.GetBytes(static_cast<GpuMemoryCategory>(category)));
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_setGpuBudget(JNIEnv * env, jclass clazz, jlong bytes) {
+    gpu_memory.SetBudget(bytes > 0 ? static_cast<size_t>(bytes) : 0);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getGpuBudget(JNIEnv * env, jclass clazz) {
+    return static_cast<jlong>(gpu_memory.GetBudget());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_getEvictedMeshCount(JNIEnv * env, jclass clazz) {
+    return static_cast<jint>(gpu_memory.GetEvictedCount());
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_NativeMemory_shrinkGpuBudget(JNIEnv * env, jclass clazz, jfloat fraction) {
+    gpu_memory.ShrinkBudget(fraction);
+}
+
+#ifdef __cplusplus 
+} // extern C
+#endif
+} // namespace mgn
@@ -16,15 +16,41 @@
 
 #include "includes.h"
 #include "HybridObject.h"
+#include "util/HandleTable.h"
 
 namespace mgn {
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_NativeReference_delete(JNIEnv * env, jobject obj, jlong nativePointer) {
-    delete reinterpret_cast<HybridObject*>(nativePointer);
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_NativeReference_deleteBatch(JNIEnv * env, jclass clazz, jlongArray jnativePointers, jint count, jlong budgetNanos) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    // Destructors may call JNI (e.g. SurfaceTexture), so copy handles out instead of
+    // holding a critical region.
+    const jint BATCH = 64;
+    jlong nativePointers[BATCH];
+
+    const double deadline = vrapi_GetTimeInSeconds() + budgetNanos * 1e-9;
+    jint deleted = 0;
+
+    // Always delete at least one so that deletion makes progress.
+    do {
+        const jint batchCount = std::min(BATCH, count - deleted);
+        env->GetLongArrayRegion(jnativePointers, deleted, batchCount, nativePointers);
+
+        jint i = 0;
+        do {
+            delete native_handles.Remove(nativePointers[i++]);
+        } while (i < batchCount && vrapi_GetTimeInSeconds() < deadline);
+
+        deleted += i;
+    } while (deleted < count && vrapi_GetTimeInSeconds() < deadline);
+
+    return deleted;
 }
 
 #ifdef __cplusplus 
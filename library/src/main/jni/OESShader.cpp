@@ -24,7 +24,8 @@
 #include "OESShader.h"
 #include "Material.h"
 #include "mesh.h"
-#include "RenderData.h"
+#include "RenderSnapshot.h"
+#include "util/GpuMemory.h"
 
 namespace mgn {
 
@@ -33,10 +34,12 @@ static const char VERTEX_SHADER[] =
         "attribute vec2 TexCoord;\n"
         "uniform highp mat4 Mvpm;\n"
         "uniform highp mat4 Texm;\n"
+        "uniform highp vec3 PositionScale;\n"
+        "uniform highp vec3 PositionBias;\n"
         "varying highp vec2 oTexCoord;\n"
         "void main() {\n"
         "  oTexCoord = vec2(Texm * vec4(TexCoord, 0, 1));\n"
-        "  gl_Position = Mvpm * Position;\n"
+        "  gl_Position = Mvpm * vec4(PositionBias + Position.xyz * PositionScale, 1.0);\n"
         "}\n";
 
 static const char FRAGMENT_SHADER[] =
@@ -56,26 +59,50 @@ static const char FRAGMENT_SHADER[] =
 OESShader::OESShader() {
     program = BuildProgram(VERTEX_SHADER, FRAGMENT_SHADER);
     opacity = glGetUniformLocation(program.program, "Opacity");
+    positionScale = glGetUniformLocation(program.program, "PositionScale");
+    positionBias = glGetUniformLocation(program.program, "PositionBias");
+
+    // The binary is the closest to what the driver keeps.
+    GLint binaryLength = 0;
+    glGetProgramiv(program.program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    programBytes = binaryLength;
+    gpu_memory.Allocate(GPU_MEMORY_PROGRAM, programBytes);
 }
 
 OESShader::~OESShader() {
+    gpu_memory.Free(GPU_MEMORY_PROGRAM, programBytes);
     DeleteProgram(program);
 }
 
-void OESShader::Render(const Matrix4f & mvpMatrix, const GlGeometry & geometry, const Material * material, const int eye) {
+void OESShader::Render(const Matrix4f & mvpMatrix, const DrawItem & item, const int eye) {
 
-    Vector4f color = material->GetColor();
+    const Mesh * mesh = item.mesh;
+    const Vector4f & color = item.color;
+
+    // The UV rect picks a part of the picture, and then the stereo mode picks the eye's half of it.
+    const Matrix4f & stereoM = TexmForVideo(item.stereoMode, eye);
+    const Vector4f & uvRect = item.uvRect;
+    const Matrix4f uvM(
+            uvRect.z, 0, 0, uvRect.x,
+            0, uvRect.w, 0, uvRect.y,
+            0, 0, 1, 0,
+            0, 0, 0, 1);
 
     GL(glUseProgram(program.program));
 
     GL(glUniformMatrix4fv(program.uMvp, 1, GL_TRUE, mvpMatrix.M[0]));
-    GL(glUniformMatrix4fv(program.uTexm, 1, GL_TRUE, TexmForVideo(material->GetStereoMode(), eye).M[ 0 ] ));
+    GL(glUniformMatrix4fv(program.uTexm, 1, GL_TRUE, (stereoM * uvM).M[ 0 ] ));
     GL(glActiveTexture (GL_TEXTURE0));
-    GL(glBindTexture(GL_TEXTURE_EXTERNAL_OES, material->GetTextureId()));
+    GL(glBindTexture(GL_TEXTURE_EXTERNAL_OES, item.textureId));
     GL(glUniform4f(program.uColor, color.x, color.y, color.z, color.w));
-    GL(glUniform1f(opacity, material->GetOpacity()));
+    GL(glUniform1f(opacity, item.opacity));
+
+    const Vector3f & scale = mesh->GetPositionScale();
+    const Vector3f & bias = mesh->GetPositionBias();
+    GL(glUniform3f(positionScale, scale.x, scale.y, scale.z));
+    GL(glUniform3f(positionBias, bias.x, bias.y, bias.z));
 
-    geometry.Draw();
+    mesh->Draw(item.lod);
 
     GL(glBindTexture( GL_TEXTURE_EXTERNAL_OES, 0 ));
 }
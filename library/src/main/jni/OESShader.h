@@ -30,13 +30,14 @@
 using namespace OVR;
 
 namespace mgn {
-class RenderData;
+class Mesh;
+struct DrawItem;
 
     class OESShader {
 public:
     OESShader();
     ~OESShader();
-    void Render(const Matrix4f & mvpMatrix, const GlGeometry & geometry, const Material * material, const int eye);
+    void Render(const Matrix4f & mvpMatrix, const DrawItem & item, const int eye);
 
 private:
     OESShader(const OESShader& oesShader);
@@ -48,6 +49,9 @@ private:
 private:
     GlProgram program;
     GLuint opacity;
+    GLuint positionScale;
+    GLuint positionBias;
+    size_t programBytes;
 
     Matrix4f normalM = Matrix4f::Identity();
     Matrix4f topM = Matrix4f(
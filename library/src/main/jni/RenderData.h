@@ -24,17 +24,29 @@
 
 #include "Component.h"
 #include "Material.h"
+#include "Mesh.h"
+#include "SceneObject.h"
 #include "util/GL.h"
+#include "util/ObjectPool.h"
 
 namespace mgn {
 class Mesh;
 
-class RenderData: public Component {
+/**
+ * Color, UV rect and stereo mode can be overridden per object, and opacity is
+ * multiplied with the material's. So objects which differ only in them can
+ * share one material, with its texture.
+ */
+class RenderData: public Component, public Pooled<RenderData, POOL_RENDER_DATA> {
 public:
     enum Queue {
         Background = 1000, Geometry = 2000, Transparent = 3000, Overlay = 4000
     };
 
+    enum Override {
+        OVERRIDE_COLOR = 1, OVERRIDE_STEREO_MODE = 2
+    };
+
     RenderData() : Component(),
         material_(nullptr),
         mesh_(nullptr),
@@ -45,10 +57,19 @@ public:
         offset_units_(0.0f),
         depth_test_(true),
         alpha_blend_(true),
-        draw_mode_(GL_TRIANGLES) {
+        draw_mode_(GL_TRIANGLES),
+        overrides_(0),
+        color_(1.0f, 1.0f, 1.0f, 1.0f),
+        opacity_(1.0f),
+        uv_rect_(0.0f, 0.0f, 1.0f, 1.0f),
+        stereo_mode_(Material::NORMAL) {
     }
 
     ~RenderData() {
+        // Deleted while attached, if the detach command wasn't applied yet.
+        if (GetOwnerObject() != nullptr) {
+            GetOwnerObject()->DetachRenderData();
+        }
     }
 
     Mesh* GetMesh() const {
@@ -135,16 +156,54 @@ public:
         return draw_mode_;
     }
 
-    void SetCameraDistance(float distance) {
-        camera_distance_ = distance;
+    void SetDrawMode(GLenum draw_mode) {
+        draw_mode_ = draw_mode;
     }
 
-    float GetCameraDistance() const {
-        return camera_distance_;
+    // The material's color unless it is overridden.
+    const Vector4f & GetColor() const {
+        return (overrides_ & OVERRIDE_COLOR) != 0 ? color_ : material_->GetColor();
     }
 
-    void SetDrawMode(GLenum draw_mode) {
-        draw_mode_ = draw_mode;
+    void SetColor(const Vector4f & color) {
+        color_ = color;
+        overrides_ |= OVERRIDE_COLOR;
+    }
+
+    void ClearColor() {
+        overrides_ &= ~OVERRIDE_COLOR;
+    }
+
+    // Multiplied with the material's opacity.
+    float GetOpacity() const {
+        return opacity_;
+    }
+
+    void SetOpacity(float opacity) {
+        opacity_ = opacity;
+    }
+
+    // Part of the texture mapped on the mesh, as (x, y, width, height) in texture coordinates.
+    const Vector4f & GetUvRect() const {
+        return uv_rect_;
+    }
+
+    void SetUvRect(const Vector4f & uv_rect) {
+        uv_rect_ = uv_rect;
+    }
+
+    // The material's stereo mode unless it is overridden.
+    Material::StereoMode GetStereoMode() const {
+        return (overrides_ & OVERRIDE_STEREO_MODE) != 0 ? stereo_mode_ : material_->GetStereoMode();
+    }
+
+    void SetStereoMode(Material::StereoMode stereo_mode) {
+        stereo_mode_ = stereo_mode;
+        overrides_ |= OVERRIDE_STEREO_MODE;
+    }
+
+    void ClearStereoMode() {
+        overrides_ &= ~OVERRIDE_STEREO_MODE;
     }
 
 private:
@@ -155,6 +214,7 @@ private:
 
 private:
     static const int DEFAULT_RENDERING_ORDER = Geometry;
+
     Mesh* mesh_;
     Material * material_;
     bool visible;
@@ -165,37 +225,12 @@ private:
     bool depth_test_;
     bool alpha_blend_;
     GLenum draw_mode_;
-    float camera_distance_;
+    int overrides_;
+    Vector4f color_;
+    float opacity_;
+    Vector4f uv_rect_;
+    Material::StereoMode stereo_mode_;
 };
 
-inline bool compareRenderData(RenderData* i, RenderData* j) {
-    // if it is a transparent object, sort by camera distance.
-    if(i->GetRenderingOrder() == j->GetRenderingOrder() &&
-       i->GetRenderingOrder() >= RenderData::Transparent &&
-       i->GetRenderingOrder() < RenderData::Overlay) {
-        return i->GetCameraDistance() > j->GetCameraDistance();
-    }
-
-    return i->GetRenderingOrder() < j->GetRenderingOrder();
-}
-
-inline bool compareRenderDataWithFrustumCulling(RenderData* i, RenderData* j) {
-    // if either i or j is a transparent object or an overlay object
-    if (i->GetRenderingOrder() >= RenderData::Transparent
-            || j->GetRenderingOrder() >= RenderData::Transparent) {
-        if (i->GetRenderingOrder() == j->GetRenderingOrder()) {
-            // if both are either transparent or both are overlays
-            // place them in reverse camera order from back to front
-            return i->GetCameraDistance() < j->GetCameraDistance();
-        } else {
-            // if one of them is a transparent or an overlay draw by rendering order
-            return i->GetRenderingOrder() < j->GetRenderingOrder();
-        }
-    }
-
-    // if both are neither transparent nor overlays, place them in camera order front to back
-    return i->GetCameraDistance() > j->GetCameraDistance();
-}
-
 }
 #endif
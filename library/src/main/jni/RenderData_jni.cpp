@@ -16,6 +16,7 @@
 #include "includes.h"
 #include "RenderData.h"
 #include "Material.h"
+#include "util/HandleTable.h"
 
 namespace mgn {
 #ifdef __cplusplus
@@ -24,119 +25,161 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL
 Java_com_eje_1c_meganekko_RenderData_initNativeInstance(JNIEnv * env, jobject obj) {
-    return reinterpret_cast<jlong>(new RenderData());
+    return NewHandle(new RenderData());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setMesh(JNIEnv * env, jobject obj, jlong jrenderData, jlong jmesh) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     render_data->SetMesh(mesh);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setMaterial(JNIEnv * env, jobject obj, jlong jrenderData, jlong jmaterial) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    Material* material = FromHandle<Material>(jmaterial);
     render_data->SetMaterial(material);
 }
 
 JNIEXPORT jint JNICALL
 Java_com_eje_1c_meganekko_RenderData_isVisible(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return render_data->IsVisible();
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setVisible(JNIEnv * env, jobject obj, jlong jrenderData, jboolean visible) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetVisible(visible);
 }
 
 JNIEXPORT jint JNICALL
 Java_com_eje_1c_meganekko_RenderData_getRenderingOrder( JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return render_data->GetRenderingOrder();
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setRenderingOrder( JNIEnv * env, jobject obj, jlong jrenderData, jint renderingOrder) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetRenderingOrder(renderingOrder);
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_eje_1c_meganekko_RenderData_getOffset(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return static_cast<jboolean>(render_data->GetOffset());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setOffset(JNIEnv * env, jobject obj, jlong jrenderData, jboolean offset) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetOffset(static_cast<bool>(offset));
 }
 
 JNIEXPORT jfloat JNICALL
 Java_com_eje_1c_meganekko_RenderData_getOffsetFactor(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return render_data->GetOffsetFactor();
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setOffsetFactor(JNIEnv * env, jobject obj, jlong jrenderData, jfloat offsetFactor) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetOffsetFactor(offsetFactor);
 }
 
 JNIEXPORT jfloat JNICALL
 Java_com_eje_1c_meganekko_RenderData_getOffsetUnits(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return render_data->GetOffsetUnits();
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setOffsetUnits(JNIEnv * env, jobject obj, jlong jrenderData, jfloat offsetUnits) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetOffsetUnits(offsetUnits);
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_eje_1c_meganekko_RenderData_getDepthTest(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return static_cast<jboolean>(render_data->GetDepthTest());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setDepthTest(JNIEnv * env, jobject obj, jlong jrenderData, jboolean depthTest) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetDepthTest(static_cast<bool>(depthTest));
 }
 
 JNIEXPORT jboolean JNICALL
 Java_com_eje_1c_meganekko_RenderData_getAlphaBlend(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return static_cast<jboolean>(render_data->GetAlphaBlend());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setAlphaBlend(JNIEnv * env, jobject obj, jlong jrenderData, jboolean alpha_blend) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetAlphaBlend(static_cast<bool>(alpha_blend));
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_RenderData_setDrawMode(JNIEnv * env, jobject obj, jlong jrenderData, jint draw_mode) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     render_data->SetDrawMode(draw_mode);
 }
 
 JNIEXPORT jint JNICALL
 Java_com_eje_1c_meganekko_RenderData_getDrawMode(JNIEnv * env, jobject obj, jlong jrenderData) {
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
     return render_data->GetDrawMode();
 }
 
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_setColor(JNIEnv * env, jobject obj, jlong jrenderData, jfloat r, jfloat g, jfloat b, jfloat a) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->SetColor(Vector4f(r, g, b, a));
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_clearColor(JNIEnv * env, jobject obj, jlong jrenderData) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->ClearColor();
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_eje_1c_meganekko_RenderData_getOpacity(JNIEnv * env, jobject obj, jlong jrenderData) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    return render_data->GetOpacity();
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_setOpacity(JNIEnv * env, jobject obj, jlong jrenderData, jfloat opacity) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->SetOpacity(opacity);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_setUvRect(JNIEnv * env, jobject obj, jlong jrenderData, jfloat x, jfloat y, jfloat width, jfloat height) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->SetUvRect(Vector4f(x, y, width, height));
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_setStereoMode(JNIEnv * env, jobject obj, jlong jrenderData, jint jstereoMode) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->SetStereoMode(static_cast<Material::StereoMode>(jstereoMode));
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_RenderData_clearStereoMode(JNIEnv * env, jobject obj, jlong jrenderData) {
+    RenderData* render_data = FromHandle<RenderData>(jrenderData);
+    render_data->ClearStereoMode();
+}
+
 #ifdef __cplusplus 
 } // extern C
 #endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "RenderSnapshot.h"
+#include "SceneObject.h"
+
+namespace mgn {
+
+// Consistent results of occlusion queries before visibility changes.
+static const int VISIBILITY_CHECK_FRAMES = 12;
+
+void DrawState::SetVisible(bool visibility) {
+    if (visibility) {
+        visCount++;
+    } else {
+        visCount--;
+    }
+
+    if (visCount > VISIBILITY_CHECK_FRAMES) {
+        visible = true;
+        visCount = 0;
+    } else if (visCount < -VISIBILITY_CHECK_FRAMES) {
+        visible = false;
+        visCount = 0;
+    }
+}
+
+void CaptureDrawItem(SceneObject * object, const Matrix4f & matrixPrevious, const Matrix4f & matrixCurrent,
+        DrawStates & states, uint32_t capture, RenderSnapshot & snapshot) {
+
+    RenderData * renderData = object->GetRenderData();
+    if (renderData == nullptr || !renderData->IsVisible()) {
+        return;
+    }
+    Mesh * mesh = renderData->GetMesh();
+    Material * material = renderData->GetMaterial();
+    if (mesh == nullptr || material == nullptr) {
+        return;
+    }
+
+    DrawState & state = states[object->GetDrawKey()];
+    state.capture = capture;
+    if (state.screenPixels > 0.0f) {
+        material->RequestScreenPixels(state.screenPixels);
+        state.screenPixels = 0.0f;
+    }
+
+    snapshot.emplace_back();
+    DrawItem & item = snapshot.back();
+    item.mesh = mesh;
+    item.state = &state;
+    item.boundingBox = mesh->GetBoundingBoxInfo();
+    item.boundingSphere = mesh->GetBoundingSphereInfo();
+    item.usingLod = object->IsUsingLODRange();
+    item.lodMinRange = object->GetLODMinRange();
+    item.lodMaxRange = object->GetLODMaxRange();
+    item.lod = std::min(state.lod, mesh->GetLodCount() - 1);
+    item.matrixPrevious = matrixPrevious;
+    item.matrixCurrent = matrixCurrent;
+    item.matrix = matrixCurrent;
+    item.color = renderData->GetColor();
+    item.uvRect = renderData->GetUvRect();
+    item.opacity = material->GetOpacity() * renderData->GetOpacity() * object->GetWorldOpacity();
+    item.stereoMode = renderData->GetStereoMode();
+    item.textureId = material->GetTextureId();
+    item.side = material->GetSide();
+    item.renderingOrder = renderData->GetRenderingOrder();
+    item.offset = renderData->GetOffset();
+    item.offsetFactor = renderData->GetOffsetFactor();
+    item.offsetUnits = renderData->GetOffsetUnits();
+    item.depthTest = renderData->GetDepthTest();
+    item.alphaBlend = renderData->GetAlphaBlend();
+    item.cameraDistance = 0.0f;
+}
+
+Matrix4f InterpolateMatrix(const Matrix4f & a, const Matrix4f & b, float alpha) {
+    if (memcmp(&a, &b, sizeof(Matrix4f)) == 0) {
+        return b;
+    }
+
+    // Decomposed, so that rotating objects don't shrink halfway.
+    const Matrix4f * m[2] = { &a, &b };
+    Vector3f scale[2];
+    Quatf rotation[2];
+    for (int i = 0; i < 2; ++i) {
+        const Matrix4f & matrix = *m[i];
+        scale[i] = Vector3f(
+                Vector3f(matrix.M[0][0], matrix.M[1][0], matrix.M[2][0]).Length(),
+                Vector3f(matrix.M[0][1], matrix.M[1][1], matrix.M[2][1]).Length(),
+                Vector3f(matrix.M[0][2], matrix.M[1][2], matrix.M[2][2]).Length());
+        if (scale[i].x == 0.0f || scale[i].y == 0.0f || scale[i].z == 0.0f) {
+            rotation[i] = Quatf();
+            continue;
+        }
+        rotation[i] = Quatf(Matrix3f(
+                matrix.M[0][0] / scale[i].x, matrix.M[0][1] / scale[i].y, matrix.M[0][2] / scale[i].z,
+                matrix.M[1][0] / scale[i].x, matrix.M[1][1] / scale[i].y, matrix.M[1][2] / scale[i].z,
+                matrix.M[2][0] / scale[i].x, matrix.M[2][1] / scale[i].y, matrix.M[2][2] / scale[i].z));
+    }
+
+    // Ticks are close in time, so normalized lerp through the shorter arc is enough.
+    const Quatf & qa = rotation[0];
+    Quatf qb = rotation[1];
+    if (qa.x * qb.x + qa.y * qb.y + qa.z * qb.z + qa.w * qb.w < 0.0f) {
+        qb = Quatf(-qb.x, -qb.y, -qb.z, -qb.w);
+    }
+    const Quatf q = Quatf(qa.x + (qb.x - qa.x) * alpha, qa.y + (qb.y - qa.y) * alpha, qa.z + (qb.z - qa.z) * alpha,
+            qa.w + (qb.w - qa.w) * alpha).Normalized();
+
+    const Vector3f position = a.GetTranslation() + (b.GetTranslation() - a.GetTranslation()) * alpha;
+    return Matrix4f::Translation(position) * Matrix4f(q) * Matrix4f::Scaling(scale[0] + (scale[1] - scale[0]) * alpha);
+}
+
+}
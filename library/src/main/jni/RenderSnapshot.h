@@ -0,0 +1,142 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Draw state of a scene, captured after an update and read by rendering.
+ ***************************************************************************/
+
+#ifndef RENDER_SNAPSHOT_H_
+#define RENDER_SNAPSHOT_H_
+
+#include "Material.h"
+#include "RenderData.h"
+#include "util/GL.h"
+
+#include <unordered_map>
+#include <vector>
+
+using namespace OVR;
+
+namespace mgn {
+class Mesh;
+class SceneObject;
+
+/**
+ * Culling and LOD of a drawn object, which only rendering reads and writes. Kept by Scene while the object
+ * is captured.
+ */
+struct DrawState {
+    DrawState() : lod(0), screenPixels(0.0f), inFrustum(false), visible(true), visCount(0),
+            queryIssued(false), query(0), capture(0) {
+    }
+
+    // Set by occlusion queries. Changed only after a few consistent results, to avoid flickering.
+    void SetVisible(bool visibility);
+
+    int      lod;          // Of the mesh in the last frame.
+    float    screenPixels; // Largest projected size since the last capture, requested to the material then.
+    bool     inFrustum;
+    bool     visible;
+    int      visCount;
+    bool     queryIssued;
+    GLuint   query;
+    uint32_t capture;      // The last capture which had the object.
+};
+
+typedef std::unordered_map<uint64_t, DrawState> DrawStates; // By SceneObject::GetDrawKey().
+
+/**
+ * What a RenderData is drawn with. Values are copied when the snapshot is captured, so that Java can
+ * change objects while it is rendered. Rendering writes its results only to the item and its DrawState.
+ * The mesh is kept as a pointer, since its geometry and residency are owned by the GL thread.
+ */
+struct DrawItem {
+    Mesh *      mesh;
+    DrawState * state;
+
+    BoundingBoxInfo    boundingBox; // Of the mesh, in model space.
+    BoundingSphereInfo boundingSphere;
+    bool               usingLod;    // Squared distances from the camera where the object is drawn.
+    float              lodMinRange;
+    float              lodMaxRange;
+    int                lod;         // Drawn with. Picked in each frame.
+
+    Matrix4f matrixPrevious; // World matrices of the last two ticks, or the world matrix twice.
+    Matrix4f matrixCurrent;
+    Matrix4f matrix;         // Rendered with. Interpolated in each frame.
+
+    Vector4f             color;
+    Vector4f             uvRect;
+    float                opacity; // Of the material, the render data and the parents.
+    Material::StereoMode stereoMode;
+    GLuint               textureId;
+    int                  side;
+    int                  renderingOrder;
+    bool                 offset;
+    float                offsetFactor;
+    float                offsetUnits;
+    bool                 depthTest;
+    bool                 alphaBlend;
+    float                cameraDistance; // Set by frustum culling.
+
+    bool InLODRange(float distanceFromCamera) const {
+        return !usingLod || (distanceFromCamera >= lodMinRange && distanceFromCamera < lodMaxRange);
+    }
+};
+
+typedef std::vector<DrawItem> RenderSnapshot;
+
+// Adds a DrawItem of object to snapshot, if it has something to draw. Its DrawState in states is marked with
+// capture, and requests the screen pixels of the last frames to the material.
+void CaptureDrawItem(SceneObject * object, const Matrix4f & matrixPrevious, const Matrix4f & matrixCurrent,
+        DrawStates & states, uint32_t capture, RenderSnapshot & snapshot);
+
+// Translation, rotation and scale at alpha between a (0) and b (1). Shear is dropped.
+Matrix4f InterpolateMatrix(const Matrix4f & a, const Matrix4f & b, float alpha);
+
+inline bool compareDrawItems(const DrawItem * i, const DrawItem * j) {
+    // if it is a transparent object, sort by camera distance.
+    if (i->renderingOrder == j->renderingOrder &&
+        i->renderingOrder >= RenderData::Transparent &&
+        i->renderingOrder < RenderData::Overlay) {
+        return i->cameraDistance > j->cameraDistance;
+    }
+
+    return i->renderingOrder < j->renderingOrder;
+}
+
+inline bool compareDrawItemsWithFrustumCulling(const DrawItem * i, const DrawItem * j) {
+    // if either i or j is a transparent object or an overlay object
+    if (i->renderingOrder >= RenderData::Transparent
+            || j->renderingOrder >= RenderData::Transparent) {
+        if (i->renderingOrder == j->renderingOrder) {
+            // if both are either transparent or both are overlays
+            // place them in reverse camera order from back to front
+            return i->cameraDistance < j->cameraDistance;
+        } else {
+            // if one of them is a transparent or an overlay draw by rendering order
+            return i->renderingOrder < j->renderingOrder;
+        }
+    }
+
+    // if both are neither transparent nor overlays, place them in camera order front to back
+    return i->cameraDistance > j->cameraDistance;
+}
+
+}
+#endif
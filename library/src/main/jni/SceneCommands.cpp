@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "SceneCommands.h"
+#include "SceneObject.h"
+#include "RenderData.h"
+#include "util/HandleTable.h"
+
+namespace mgn {
+
+struct SceneCommandHeader {
+    int32_t opcode;
+    int32_t payloadSize;
+    int64_t handle;
+};
+
+#if defined(OVR_BUILD_DEBUG)
+static int32_t PayloadSizeOf(int32_t opcode) {
+    switch (opcode) {
+    case SCENE_COMMAND_SET_MATRIX:
+        return 16 * sizeof(float);
+    case SCENE_COMMAND_SET_OPACITY:
+    case SCENE_COMMAND_SET_VISIBLE:
+        return 4;
+    case SCENE_COMMAND_ATTACH_RENDER_DATA:
+    case SCENE_COMMAND_ADD_CHILD:
+    case SCENE_COMMAND_REMOVE_CHILD:
+        return sizeof(int64_t);
+    case SCENE_COMMAND_DETACH_RENDER_DATA:
+        return 0;
+    default:
+        return -1;
+    }
+}
+#endif
+
+int ReplaySceneCommands(const uint8_t * data, size_t length) {
+    int applied = 0;
+    size_t offset = 0;
+
+    while (offset + sizeof(SceneCommandHeader) <= length) {
+        // Java side doesn't align commands, so everything is copied out.
+        SceneCommandHeader header;
+        memcpy(&header, data + offset, sizeof(header));
+        const uint8_t * payload = data + offset + sizeof(header);
+        offset += sizeof(header) + header.payloadSize;
+
+#if defined(OVR_BUILD_DEBUG)
+        if (header.payloadSize != PayloadSizeOf(header.opcode) || offset > length) {
+            __android_log_print(ANDROID_LOG_ERROR, "mgn", "ReplaySceneCommands: broken command %d with %d bytes",
+                    header.opcode, header.payloadSize);
+            OVR_ASSERT(false);
+            break;
+        }
+#endif
+
+        // The Java object can be collected while its command waits.
+        if (!native_handles.IsValid(header.handle)) {
+            continue;
+        }
+        SceneObject * sceneObject = FromHandle<SceneObject>(header.handle);
+
+        float values[16];
+        switch (header.opcode) {
+        case SCENE_COMMAND_SET_MATRIX:
+            memcpy(values, payload, 16 * sizeof(float));
+            sceneObject->SetMatrixLocal(Matrix4f(
+                    values[0], values[1], values[2], values[3],
+                    values[4], values[5], values[6], values[7],
+                    values[8], values[9], values[10], values[11],
+                    values[12], values[13], values[14], values[15]));
+            break;
+
+        case SCENE_COMMAND_SET_OPACITY:
+            memcpy(values, payload, sizeof(float));
+            sceneObject->SetOpacity(values[0]);
+            break;
+
+        case SCENE_COMMAND_SET_VISIBLE: {
+            int32_t visible;
+            memcpy(&visible, payload, sizeof(visible));
+            sceneObject->SetHidden(visible == 0);
+            break;
+        }
+
+        case SCENE_COMMAND_ATTACH_RENDER_DATA: {
+            int64_t renderDataHandle;
+            memcpy(&renderDataHandle, payload, sizeof(renderDataHandle));
+            if (!native_handles.IsValid(renderDataHandle)) {
+                continue;
+            }
+            sceneObject->AttachRenderData(sceneObject, FromHandle<RenderData>(renderDataHandle));
+            break;
+        }
+
+        case SCENE_COMMAND_DETACH_RENDER_DATA:
+            sceneObject->DetachRenderData();
+            break;
+
+        case SCENE_COMMAND_ADD_CHILD:
+        case SCENE_COMMAND_REMOVE_CHILD: {
+            int64_t childHandle;
+            memcpy(&childHandle, payload, sizeof(childHandle));
+            if (!native_handles.IsValid(childHandle)) {
+                continue;
+            }
+            SceneObject * child = FromHandle<SceneObject>(childHandle);
+            if (header.opcode == SCENE_COMMAND_REMOVE_CHILD) {
+                sceneObject->RemoveChildObject(child);
+                break;
+            }
+            try {
+                sceneObject->AddChildObject(sceneObject, child);
+            } catch (std::string error) {
+                __android_log_print(ANDROID_LOG_ERROR, "mgn", "ReplaySceneCommands: %s", error.c_str());
+                continue;
+            }
+            break;
+        }
+
+        default:
+            continue;
+        }
+
+        applied++;
+    }
+
+    return applied;
+}
+
+}
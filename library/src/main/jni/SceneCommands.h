@@ -0,0 +1,51 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Changes of scene objects recorded in Java side.
+ ***************************************************************************/
+
+#ifndef SCENE_COMMANDS_H_
+#define SCENE_COMMANDS_H_
+
+namespace mgn {
+
+// Same values as SceneCommands.* in Java side.
+enum SceneCommand {
+    SCENE_COMMAND_SET_MATRIX = 1,
+    SCENE_COMMAND_SET_OPACITY,
+    SCENE_COMMAND_SET_VISIBLE,
+    SCENE_COMMAND_ATTACH_RENDER_DATA,
+    SCENE_COMMAND_DETACH_RENDER_DATA,
+    SCENE_COMMAND_ADD_CHILD,
+    SCENE_COMMAND_REMOVE_CHILD
+};
+
+/**
+ * Applies commands in data to scene objects in order. A command is a header
+ * (int32 opcode, int32 payload size, int64 handle) and its payload, in native
+ * byte order. Commands to deleted objects are skipped. Debug builds also check
+ * the opcodes and payload sizes, and stop at a broken command.
+ *
+ * Returns the number of applied commands.
+ */
+int ReplaySceneCommands(const uint8_t * data, size_t length);
+
+}
+
+#endif
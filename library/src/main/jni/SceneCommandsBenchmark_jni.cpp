@@ -0,0 +1,57 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * One JNI call per change, as SceneObject did before SceneCommands.
+ * Only for SceneCommandsBenchmark in Java side.
+ ***************************************************************************/
+
+#include "includes.h"
+#include "SceneObject.h"
+#include "util/HandleTable.h"
+
+namespace mgn {
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_SceneCommandsBenchmark_setOpacity(JNIEnv * env, jclass clazz, jlong jsceneObject,
+        jfloat opacity) {
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
+    sceneObject->SetOpacity(opacity);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_SceneCommandsBenchmark_setMatrix(JNIEnv * env, jclass clazz, jlong jsceneObject,
+        float m11, float m12, float m13, float m14,
+        float m21, float m22, float m23, float m24,
+        float m31, float m32, float m33, float m34,
+        float m41, float m42, float m43, float m44) {
+
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
+    sceneObject->SetMatrixLocal(Matrix4f(
+        m11, m12, m13, m14,
+        m21, m22, m23, m24,
+        m31, m32, m33, m34,
+        m41, m42, m43, m44
+    ));
+}
+
+#ifdef __cplusplus
+} // extern C
+#endif
+} // namespace mgn
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "SceneCommands.h"
+
+namespace mgn {
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_SceneCommands_replay(JNIEnv * env, jclass clazz, jobject buffer, jint length) {
+    const uint8_t * data = static_cast<const uint8_t *>(env->GetDirectBufferAddress(buffer));
+    if (data == nullptr) {
+        return;
+    }
+    ReplaySceneCommands(data, static_cast<size_t>(length));
+}
+
+#ifdef __cplusplus
+} // extern C
+#endif
+} // namespace mgn
@@ -23,29 +23,40 @@
 #include "RenderData.h"
 #include "Mesh.h"
 
+#include <atomic>
+
 namespace mgn {
+
+static std::atomic<uint64_t> nextDrawKey(0);
+
     SceneObject::SceneObject() : HybridObject(),
-        position(Vector3f()),
-        scale(Vector3f(1, 1, 1)),
-        rotation(Quatf()),
+        transformId(transform_store.Allocate()),
+        transform(transform_store.Get(transformId)),
+        hidden(false),
+        opacity(1.0f),
+        worldOpacity(1.0f),
         renderData(nullptr),
         parent(nullptr),
         children(),
-        visible(true),
-        inFrustum(false),
-        queryCurrentlyIssued(false),
-        visCount(0),
         lodMinRange(0),
         lodMaxRange(MAXFLOAT),
-        usingLod(false) {
-
-    // Occlusion query setup
-    queries = new GLuint[1];
-    glGenQueries(1, queries);
+        usingLod(false),
+        tick(0),
+        drawKey(++nextDrawKey) {
 }
 
 SceneObject::~SceneObject() {
-    delete queries;
+    // Deleted while linked, if the commands to unlink it weren't applied yet.
+    if (parent != nullptr) {
+        parent->RemoveChildObject(this);
+    }
+    for (SceneObject * child : children) {
+        child->parent = nullptr;
+        child->Invalidate(false);
+    }
+    DetachRenderData();
+
+    transform_store.Free(transformId);
 }
 
 void SceneObject::AttachRenderData(SceneObject* self, RenderData* renderData) {
@@ -101,29 +112,6 @@ SceneObject* SceneObject::GetChildByIndex(int index) {
     }
 }
 
-void SceneObject::SetVisible(bool visibility = true) {
-
-    //HACK
-    //If checked every frame, queries may return
-    //an inconsistent result when used with bounding boxes.
-
-    //We need to make sure that the object's visibility status is consistent before
-    //changing the status to avoid flickering artifacts.
-
-    if (visibility == true)
-        visCount++;
-    else
-        visCount--;
-
-    if (visCount > checkFrames) {
-        this->visible = true;
-        visCount = 0;
-    } else if (visCount < (-1 * checkFrames)) {
-        this->visible = false;
-        visCount = 0;
-    }
-}
-
 bool SceneObject::IsColliding(SceneObject *sceneObject) {
 
     //Get the transformed bounding boxes in world coordinates and check if they intersect
@@ -148,28 +136,46 @@ bool SceneObject::IsColliding(SceneObject *sceneObject) {
 }
 
 void SceneObject::SetPosition(const Vector3f& position) {
-    this->position = position;
+    transform->position = position;
     Invalidate(false);
 }
 
 void SceneObject::SetScale(const Vector3f& scale) {
-    this->scale = scale;
+    transform->scale = scale;
     Invalidate(false);
 }
 
 void SceneObject::SetRotation(const Quatf& rotation) {
-    this->rotation = rotation;
+    transform->rotation = rotation;
     Invalidate(true);
 }
 
 const Matrix4f & SceneObject::GetMatrixWorld() {
-    
+
+    ApplyTransformWrites();
+
     if (matrixWorldNeedsUpdate) {
         UpdateMatrixWorld();
         matrixWorldNeedsUpdate = false;
     }
         
-    return matrixWorld;
+    return transform->matrixWorld;
+}
+
+void SceneObject::ApplyTransformWrites() {
+    for (SceneObject * object = this; object != nullptr; object = object->parent) {
+        if (object->transform->dirty != 0.0f) {
+            object->transform->dirty = 0.0f;
+            object->Invalidate(true);
+        }
+    }
+}
+
+void SceneObject::CommitTick(uint32_t tick) {
+    const Matrix4f & matrixWorld = GetMatrixWorld();
+    tickPrevious = (this->tick != 0 && this->tick + 1 == tick) ? tickCurrent : matrixWorld;
+    tickCurrent = matrixWorld;
+    this->tick = tick;
 }
 
 void SceneObject::UpdateMatrixWorld() {
@@ -177,17 +183,17 @@ void SceneObject::UpdateMatrixWorld() {
     UpdateMatrixLocal();
 
     if (GetParent() != nullptr) {
-        this->matrixWorld = GetParent()->GetMatrixWorld() * matrixLocal;
+        transform->matrixWorld = GetParent()->GetMatrixWorld() * matrixLocal;
     } else {
-        this->matrixWorld = matrixLocal;
+        transform->matrixWorld = matrixLocal;
     }
 }
 
 void SceneObject::UpdateMatrixLocal() {
 
-    Matrix4f translationMatrix = Matrix4f::Translation(position);
-    Matrix4f rotationMatrix = Matrix4f(rotation);
-    Matrix4f scaleMatrix = Matrix4f::Scaling(scale);
+    Matrix4f translationMatrix = Matrix4f::Translation(transform->position);
+    Matrix4f rotationMatrix = Matrix4f(transform->rotation);
+    Matrix4f scaleMatrix = Matrix4f::Scaling(transform->scale);
     matrixLocal = translationMatrix * rotationMatrix * scaleMatrix;
 
 }
@@ -213,9 +219,9 @@ void SceneObject::SetMatrixLocal(const Matrix4f & matrix) {
             matrix.M[1][0] / newScale.x, matrix.M[1][1] / newScale.y, matrix.M[1][2] / newScale.z,
             matrix.M[2][0] / newScale.x, matrix.M[2][1] / newScale.y, matrix.M[2][2] / newScale.z);
 
-    position = matrix.GetTranslation();
-    scale = newScale;
-    rotation = Quatf(rotationMatrix);
+    transform->position = matrix.GetTranslation();
+    transform->scale = newScale;
+    transform->rotation = Quatf(rotationMatrix);
 
     Invalidate(true);
 }
@@ -235,6 +241,7 @@ void SceneObject::Invalidate(bool rotationUpdated) {
         // scale rotation if needed to avoid overflow
         static const float threshold = sqrt(FLT_MAX) / 2.0f;
         static const float scale_factor = 0.5f / sqrt(FLT_MAX);
+        Quatf & rotation = transform->rotation;
         if (rotation.w > threshold || rotation.x > threshold
                 || rotation.y > threshold || rotation.z > threshold) {
             rotation.w *= scale_factor;
@@ -23,6 +23,8 @@
 
 #include "HybridObject.h"
 #include "util/GL.h"
+#include "util/ObjectPool.h"
+#include "util/TransformStore.h"
 
 using namespace OVR;
 
@@ -30,31 +32,37 @@ namespace mgn {
 class Camera;
 class RenderData;
 
-class SceneObject: public HybridObject {
+class SceneObject: public HybridObject, public Pooled<SceneObject, POOL_SCENE_OBJECT> {
 public:
     SceneObject();
     ~SceneObject();
 
-    void SetInFrustum(bool inFrustum = true) {
-        this->inFrustum = inFrustum;
+    // Unique in the process, unlike addresses of pooled objects. Keys the DrawState of this object.
+    uint64_t GetDrawKey() const {
+        return drawKey;
     }
 
-    bool IsInFrustum() const {
-        return inFrustum;
+    // Hides this object and its children. Set from Java; not to be confused with visibility of occlusion culling.
+    void SetHidden(bool hidden) {
+        this->hidden = hidden;
     }
 
-    void SetVisible(bool visibility);
+    bool IsHidden() const {
+        return hidden;
+    }
 
-    bool IsVisible() const {
-        return visible;
+    // Opacity of this object and its children.
+    void SetOpacity(float opacity) {
+        this->opacity = opacity;
     }
 
-    void SetQueryIssued(bool issued = true) {
-        queryCurrentlyIssued = issued;
+    float GetOpacity() const {
+        return opacity;
     }
 
-    bool IsQueryIssued() {
-        return queryCurrentlyIssued;
+    // Opacity multiplied with the parents'. Resolved by Scene::PrepareForRendering() in each frame.
+    float GetWorldOpacity() const {
+        return worldOpacity;
     }
 
     void AttachRenderData(SceneObject* self, RenderData* render_data);
@@ -81,10 +89,6 @@ public:
 
     SceneObject* GetChildByIndex(int index);
 
-    GLuint * GetOcclusionArray() {
-        return queries;
-    }
-
     bool IsColliding(SceneObject* scene_object);
 
     void SetLODRange(float minRange, float maxRange) {
@@ -101,39 +105,37 @@ public:
         return lodMaxRange;
     }
 
-    bool InLODRange(float distance_from_camera) {
-        if(!usingLod) {
-            return true;
-        }
-        if(distance_from_camera >= lodMinRange &&
-           distance_from_camera < lodMaxRange) {
-            return true;
-        }
-        return false;
+    bool IsUsingLODRange() const {
+        return usingLod;
     }
     
     const Vector3f & GetPosition() const {
-        return position;
+        return transform->position;
     }
     
     const Vector3f & GetPosition() {
-        return position;
+        return transform->position;
     }
     
     const Vector3f & GetScale() const {
-        return scale;
+        return transform->scale;
     }
     
     const Vector3f & GetScale() {
-        return scale;
+        return transform->scale;
     }
     
     const Quatf & GetRotation() const {
-        return rotation;
+        return transform->rotation;
     }
     
     const Quatf & GetRotation() {
-        return rotation;
+        return transform->rotation;
+    }
+
+    // Id of the slot in transform_store, which Java reads and writes directly.
+    uint32_t GetTransformId() const {
+        return transformId;
     }
     
     void SetPosition(const Vector3f& position);
@@ -153,6 +155,8 @@ public:
     void Invalidate(bool rotationUpdated);
 
 private:
+    friend class Scene;
+
     SceneObject(const SceneObject& scene_object);
     SceneObject(SceneObject&& scene_object);
     SceneObject& operator=(const SceneObject& scene_object);
@@ -163,13 +167,27 @@ private:
     void UpdateMatrixWorld();
     void UpdateMatrixLocal();
 
-    Vector3f position;
-    Vector3f scale;
-    Quatf    rotation;
+    // Invalidates matrices if Java wrote a transform of this object or its parents.
+    void ApplyTransformWrites();
+
+    // Keeps the world matrices of the last two ticks. If this object missed the previous tick, both are the same.
+    void CommitTick(uint32_t tick);
+
+    // Position, rotation, scale and world matrix.
+    uint32_t        transformId;
+    TransformSlot * transform;
     Matrix4f matrixLocal;
-    Matrix4f matrixWorld;
     bool     matrixWorldNeedsUpdate = true;
 
+    // World matrices of fixed rate ticks. tick is 0 until the first one.
+    Matrix4f tickPrevious;
+    Matrix4f tickCurrent;
+    uint32_t tick;
+
+    bool  hidden;
+    float opacity;
+    float worldOpacity;
+
     RenderData *              renderData;
     SceneObject *             parent;
     std::vector<SceneObject*> children;
@@ -178,14 +196,7 @@ private:
     float lodMaxRange;
     bool  usingLod;
 
-    //Flags to check for visibility of a node and
-    //whether there are any pending occlusion queries on it
-    const int checkFrames = 12;
-    int       visCount;
-    bool      visible;
-    bool      inFrustum;
-    bool      queryCurrentlyIssued;
-    GLuint *  queries;
+    uint64_t drawKey;
 };
 
 }
@@ -16,6 +16,7 @@
 #include "includes.h"
 #include "SceneObject.h"
 #include "util/convert.h"
+#include "util/HandleTable.h"
 
 namespace mgn {
 #ifdef __cplusplus
@@ -24,126 +25,59 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL
 Java_com_eje_1c_meganekko_SceneObject_initNativeInstance(JNIEnv * env, jobject obj) {
-    return reinterpret_cast<jlong>(new SceneObject());
+    return NewHandle(new SceneObject());
 }
 
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_attachRenderData(JNIEnv * env, jobject obj, jlong jsceneObject, jlong jrenderData) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    RenderData* render_data = reinterpret_cast<RenderData*>(jrenderData);
-    sceneObject->AttachRenderData(sceneObject, render_data);
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_detachRenderData(JNIEnv * env, jobject obj, jlong jsceneObject) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    sceneObject->DetachRenderData();
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_SceneObject_getTransformId(JNIEnv * env, jobject obj, jlong jsceneObject) {
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
+    return static_cast<jint>(sceneObject->GetTransformId());
 }
 
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_addChildObject(JNIEnv * env, jobject obj, jlong jsceneObject, jlong jchild) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    SceneObject* child = reinterpret_cast<SceneObject*>(jchild);
-    sceneObject->AddChildObject(sceneObject, child);
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_removeChildObject(JNIEnv * env, jobject obj, jlong jsceneObject, jlong jchild) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    SceneObject* child = reinterpret_cast<SceneObject*>(jchild);
-    sceneObject->RemoveChildObject(child);
+JNIEXPORT jobject JNICALL
+Java_com_eje_1c_meganekko_SceneObject_getTransformChunk(JNIEnv * env, jclass clazz, jint chunk) {
+    TransformSlot * slots = transform_store.GetChunk(static_cast<uint32_t>(chunk));
+    if (slots == nullptr) {
+        return nullptr;
+    }
+    return env->NewDirectByteBuffer(slots, TransformStore::CHUNK_SIZE * sizeof(TransformSlot));
 }
 
 JNIEXPORT bool JNICALL
 Java_com_eje_1c_meganekko_SceneObject_isColliding(JNIEnv * env, jobject obj, jlong jsceneObject, jlong jotherObject) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    SceneObject* other_object = reinterpret_cast<SceneObject*>(jotherObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
+    SceneObject* other_object = FromHandle<SceneObject>(jotherObject);
     return sceneObject->IsColliding(other_object);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_SceneObject_setLODRange(JNIEnv * env, jobject obj, jlong jsceneObject, jfloat minRange, jfloat maxRange) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     sceneObject->SetLODRange(minRange, maxRange);
 }
 
 JNIEXPORT jfloat JNICALL
 Java_com_eje_1c_meganekko_SceneObject_getLODMinRange(JNIEnv * env, jobject obj, jlong jsceneObject) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     return sceneObject->GetLODMinRange();
 }
 
 JNIEXPORT jfloat JNICALL
 Java_com_eje_1c_meganekko_SceneObject_getLODMaxRange(JNIEnv * env, jobject obj, jlong jsceneObject) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     return sceneObject->GetLODMaxRange();
 }
 
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_setPosition(JNIEnv * env, jobject obj, jlong jsceneObject, jfloat x, jfloat y, jfloat z){
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    sceneObject->SetPosition(Vector3f(x, y, z));
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_getPosition(JNIEnv * env, jobject obj, jlong jsceneObject, jfloatArray values){
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    Vector3f pos = sceneObject->GetPosition();
-    FillElementsUnSafe(env, values, pos);
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_setScale(JNIEnv * env, jobject obj, jlong jsceneObject, jfloat x, jfloat y, jfloat z){
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    sceneObject->SetScale(Vector3f(x, y, z));
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_getScale(JNIEnv * env, jobject obj, jlong jsceneObject, jfloatArray values) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    Vector3f scale = sceneObject->GetScale();
-    FillElementsUnSafe(env, values, scale);
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_setRotation(JNIEnv * env, jobject obj, jlong jsceneObject, jfloat x, jfloat y, jfloat z, jfloat w){
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    sceneObject->SetRotation(Quatf(x, y, z, w));
-}
-
-JNIEXPORT void JNICALL
-Java_com_eje_1c_meganekko_SceneObject_getRotation(JNIEnv * env, jobject obj, jlong jsceneObject, jfloatArray values) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    Quatf rotation = sceneObject->GetRotation();
-    FillElementsUnSafe(env, values, rotation);
-}
-
-JNIEXPORT jobject JNICALL
-Java_com_eje_1c_meganekko_SceneObject_setMatrix(JNIEnv * env, jobject obj, jlong jsceneObject,
-        float m11, float m12, float m13, float m14,
-        float m21, float m22, float m23, float m24,
-        float m31, float m32, float m33, float m34,
-        float m41, float m42, float m43, float m44) {
-
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
-    sceneObject->SetMatrixLocal(Matrix4f(
-        m11, m12, m13, m14,
-        m21, m22, m23, m24,
-        m31, m32, m33, m34,
-        m41, m42, m43, m44
-    ));
-}
-
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_SceneObject_getMatrixWorld(JNIEnv * env, jobject obj, jlong jsceneObject, jfloatArray values) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     Matrix4f m = sceneObject->GetMatrixWorld();
     FillElementsUnSafe(env, values, m);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_SceneObject_getMatrix(JNIEnv * env, jobject obj, jlong jsceneObject, jfloatArray values) {
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     Matrix4f m = sceneObject->GetMatrix();
     FillElementsUnSafe(env, values, m);
 }
@@ -35,6 +35,7 @@
 #include <android/log.h>
 #include <android/asset_manager_jni.h>
 #include <jni.h>
+#include <EGL/egl.h>
 
 /*
  * LibOVR Kernel
@@ -23,6 +23,8 @@
 #define MATERIAL_H_
 
 #include "util/GL.h"
+#include "util/GpuMemory.h"
+#include "util/ObjectPool.h"
 #include "HybridObject.h"
 
 using namespace OVR;
@@ -30,7 +32,7 @@ using namespace OVR;
 namespace mgn {
 class Color;
 
-class Material: public HybridObject {
+class Material: public HybridObject, public Pooled<Material, POOL_MATERIAL> {
 public:
 
     enum Side: int {
@@ -42,27 +44,58 @@ public:
         TOP_ONLY, BOTTOM_ONLY, LEFT_ONLY, RIGHT_ONLY
     };
 
-    explicit Material(JNIEnv * jni) {
+    Material() {
         Mode = NORMAL;
         side = FrontSide;
-        surfaceTexture = new SurfaceTexture(jni);
+        surfaceTexture = nullptr;
         color = Vector4f(1.0f, 1.0f, 1.0f, 1.0f);
         opacity = 1.0f;
+        textureBytes = 0;
+        screenPixels = 0.0f;
     }
 
     ~Material() {
+        gpu_memory.Free(GPU_MEMORY_TEXTURE, textureBytes);
         delete surfaceTexture;
         surfaceTexture = nullptr;
     }
 
+    // Returns 0 until the SurfaceTexture is created.
     GLuint GetTextureId() const {
-        return surfaceTexture->GetTextureId();
+        return surfaceTexture != nullptr ? surfaceTexture->GetTextureId() : 0;
     }
 
-    jobject GetSurfaceTexture() {
+    // The SurfaceTexture is created on the first call on the GL thread. Returns null if it is not
+    // created yet and the calling thread has no GL context.
+    jobject GetSurfaceTexture(JNIEnv * jni) {
+        if (surfaceTexture == nullptr) {
+            if (eglGetCurrentContext() == EGL_NO_CONTEXT) {
+                return nullptr;
+            }
+            surfaceTexture = new SurfaceTexture(jni);
+        }
         return surfaceTexture->GetJavaObject();
     }
 
+    // The SurfaceTexture allocates its buffers, so the size is told from Java side and accounted as RGBA.
+    void SetTextureSize(int width, int height) {
+        gpu_memory.Free(GPU_MEMORY_TEXTURE, textureBytes);
+        textureBytes = static_cast<size_t>(width) * height * 4;
+        gpu_memory.Allocate(GPU_MEMORY_TEXTURE, textureBytes);
+    }
+
+    // Called by the renderer with the projected size of each mesh drawn with this material.
+    void RequestScreenPixels(float pixels) {
+        screenPixels = std::max(screenPixels, pixels);
+    }
+
+    // Largest projected size in pixels since the last call. 0 if not drawn.
+    float TakeScreenPixels() {
+        const float pixels = screenPixels;
+        screenPixels = 0.0f;
+        return pixels;
+    }
+
     StereoMode GetStereoMode() const {
         return Mode;
     }
@@ -115,6 +148,8 @@ private:
 
 private:
     SurfaceTexture *surfaceTexture;
+    size_t textureBytes;
+    float screenPixels;
     Vector4f color;
     float opacity;
     StereoMode Mode;
@@ -16,6 +16,7 @@
 #include "includes.h"
 #include "Material.h"
 #include "util/convert.h"
+#include "util/HandleTable.h"
 
 namespace mgn {
 #ifdef __cplusplus
@@ -24,49 +25,61 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL
 Java_com_eje_1c_meganekko_Material_initNativeInstance(JNIEnv * env, jobject obj) {
-    return reinterpret_cast<jlong>(new Material(env));
+    return NewHandle(new Material());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Material_setColor(JNIEnv * env, jobject obj, jlong jmaterial, jfloat r, jfloat g, jfloat b, jfloat a) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     material->SetColor(Vector4f(r, g, b, a));
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Material_getColor(JNIEnv * env, jobject obj, jlong jmaterial, jfloatArray values) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     Vector4f color = material->GetColor();
     FillElementsUnSafe(env, values, color);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Material_setOpacity(JNIEnv * env, jobject obj, jlong jmaterial, jfloat opacity) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     material->SetOpacity(opacity);
 }
 
 JNIEXPORT jfloat JNICALL
 Java_com_eje_1c_meganekko_Material_getOpacity(JNIEnv * env, jobject obj, jlong jmaterial) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     return material->GetOpacity();
 }
 
 JNIEXPORT jobject JNICALL
 Java_com_eje_1c_meganekko_Material_getSurfaceTexture(JNIEnv * env, jobject obj, jlong jmaterial) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
-    return material->GetSurfaceTexture();
+    Material* material = FromHandle<Material>(jmaterial);
+    return material->GetSurfaceTexture(env);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_Material_setTextureSize(JNIEnv * env, jobject obj, jlong jmaterial, jint width, jint height) {
+    Material* material = FromHandle<Material>(jmaterial);
+    material->SetTextureSize(width, height);
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_eje_1c_meganekko_Material_takeScreenPixels(JNIEnv * env, jobject obj, jlong jmaterial) {
+    Material* material = FromHandle<Material>(jmaterial);
+    return material->TakeScreenPixels();
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Material_setStereoMode(JNIEnv * env, jobject obj, jlong jmaterial, jint jstereoMode) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     material->SetStereoMode(static_cast<Material::StereoMode>(jstereoMode));
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Material_setSide(JNIEnv* env, jobject obj, jlong jmaterial, jint jside) {
-    Material* material = reinterpret_cast<Material*>(jmaterial);
+    Material* material = FromHandle<Material>(jmaterial);
     material->SetSide(jside);
 }
 
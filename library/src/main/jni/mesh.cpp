@@ -15,12 +15,789 @@
 
 #include "includes.h"
 #include "Mesh.h"
+#include "util/GlDelete.h"
+#include "util/GlRingBuffer.h"
+#include "util/MeshBounds.h"
+#include "util/MeshCache.h"
+#include "util/MeshFile.h"
+#include "util/MeshOptimizer.h"
+#include "util/MeshSimplifier.h"
 
 namespace mgn {
 
+// Simplification stops at this error relative to the mesh size, or below this many indices.
+static const float MAX_LOD_ERROR = 0.05f;
+static const size_t MIN_LOD_INDICES = 3 * 64;
+
+static inline int IndexSize(GLenum indexType) {
+    return indexType == GL_UNSIGNED_INT ? 4 : 2;
+}
+
+// Dynamic vertices drawn unchanged for this many frames are dropped from memory.
+static const uint32_t DYNAMIC_IDLE_FRAMES = 90;
+
+static size_t BufferSize(GLuint buffer) {
+    if (buffer == 0) {
+        return 0;
+    }
+    GLint size = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return size;
+}
+
+void MeshGeometry::SetGeometry(const GlGeometry & geometry, GLenum indexType) {
+    ReleaseGeometry();
+    this->geometry = geometry;
+    this->indexType = indexType;
+    SetPositionQuantization(Vector3f(1.0f, 1.0f, 1.0f), Vector3f());
+    std::vector<uint8_t>().swap(dynamicVertices);
+
+    // Asked from GL, as the geometry may come from OVR builders.
+    vertexBufferBytes = BufferSize(geometry.vertexBuffer);
+    indexBufferBytes = BufferSize(geometry.indexBuffer);
+    residentBytes = vertexBufferBytes + indexBufferBytes;
+    gpu_memory.Allocate(GPU_MEMORY_BUFFER, residentBytes);
+}
+
+void MeshGeometry::ReleaseGeometry() {
+    gpu_memory.Free(GPU_MEMORY_BUFFER, residentBytes);
+    residentBytes = 0;
+
+    for (size_t i = 0; i < lods.size(); ++i) {
+        if (lods[i].vertexArrayObject != geometry.vertexArrayObject) {
+            gl_delete.queueVertexArray(lods[i].vertexArrayObject);
+        }
+    }
+    lods.clear();
+
+    gl_delete.queueVertexArray(geometry.vertexArrayObject);
+    gl_delete.queueBuffer(geometry.vertexBuffer, vertexBufferBytes);
+    gl_delete.queueBuffer(geometry.indexBuffer, indexBufferBytes);
+    vertexBufferBytes = 0;
+    indexBufferBytes = 0;
+    geometry = GlGeometry();
+}
+
+void MeshGeometry::SetGeometryLods(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+        const MeshLodData * lodData, int lodCount) {
+
+    // Offsets of each LOD in the buffers. Index offsets are kept aligned for 32 bit indices.
+    std::vector<size_t> vertexOffsets(lodCount);
+    std::vector<size_t> indexOffsets(lodCount);
+    std::vector<bool> sharedVertices(lodCount, false);
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    for (int i = 0; i < lodCount; ++i) {
+        vertexOffsets[i] = vertexBytes;
+        for (int j = 0; j < i; ++j) {
+            if (lodData[j].vertices == lodData[i].vertices) {
+                vertexOffsets[i] = vertexOffsets[j];
+                sharedVertices[i] = true;
+                break;
+            }
+        }
+        if (!sharedVertices[i]) {
+            vertexBytes += lodData[i].vertexCount * stride;
+        }
+        indexOffsets[i] = indexBytes;
+        indexBytes += (lodData[i].indexCount * IndexSize(lodData[i].indexType) + 3) & ~3;
+    }
+
+    GlGeometry newGeometry;
+    newGeometry.vertexCount = lodData[0].vertexCount;
+    newGeometry.indexCount = lodData[0].indexCount;
+
+    glGenBuffers(1, &newGeometry.vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, newGeometry.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, lodCount == 1 ? lodData[0].vertices : nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &newGeometry.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newGeometry.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, lodCount == 1 ? lodData[0].indices : nullptr, GL_STATIC_DRAW);
+
+    if (lodCount > 1) {
+        for (int i = 0; i < lodCount; ++i) {
+            if (!sharedVertices[i]) {
+                glBufferSubData(GL_ARRAY_BUFFER, vertexOffsets[i], lodData[i].vertexCount * stride, lodData[i].vertices);
+            }
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffsets[i],
+                    lodData[i].indexCount * IndexSize(lodData[i].indexType), lodData[i].indices);
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    std::vector<MeshLod> newLods(lodCount - 1);
+    for (int i = 0; i < lodCount; ++i) {
+        GLuint vertexArray = 0;
+        if (i > 0 && vertexOffsets[i] == vertexOffsets[0]) {
+            vertexArray = newGeometry.vertexArrayObject;
+        } else {
+            glGenVertexArrays(1, &vertexArray);
+            glBindVertexArray(vertexArray);
+            glBindBuffer(GL_ARRAY_BUFFER, newGeometry.vertexBuffer);
+            for (int a = 0; a < attributeCount; ++a) {
+                const VertexAttribute & attribute = attributes[a];
+                glEnableVertexAttribArray(attribute.location);
+                glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized,
+                        stride, reinterpret_cast<const void*>(vertexOffsets[i] + attribute.offset));
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newGeometry.indexBuffer);
+            glBindVertexArray(0);
+        }
+
+        if (i == 0) {
+            newGeometry.vertexArrayObject = vertexArray;
+        } else {
+            MeshLod & lod = newLods[i - 1];
+            lod.vertexArrayObject = vertexArray;
+            lod.indexCount = lodData[i].indexCount;
+            lod.indexType = lodData[i].indexType;
+            lod.indexOffset = indexOffsets[i];
+            lod.error = lodData[i].error;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    SetGeometry(newGeometry, lodData[0].indexType);
+    lods.swap(newLods);
+}
+
+void MeshGeometry::SetDynamicGeometry(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+        const void * vertices, int vertexCount, const void * indices, int indexCount, GLenum indexType) {
+
+    GlGeometry newGeometry;
+    newGeometry.vertexCount = vertexCount;
+    newGeometry.indexCount = indexCount;
+
+    // Attribute pointers are set when the vertices are written to gl_ring.
+    glGenVertexArrays(1, &newGeometry.vertexArrayObject);
+    glBindVertexArray(newGeometry.vertexArrayObject);
+    glGenBuffers(1, &newGeometry.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newGeometry.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * IndexSize(indexType), indices, GL_STATIC_DRAW);
+    for (int a = 0; a < attributeCount; ++a) {
+        glEnableVertexAttribArray(attributes[a].location);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    SetGeometry(newGeometry, indexType);
+    dynamicStride = stride;
+    dynamicAttributes.assign(attributes, attributes + attributeCount);
+    const uint8_t * p = static_cast<const uint8_t*>(vertices);
+    dynamicVertices.assign(p, p + vertexCount * stride);
+    dynamicChanged = true;
+    drawnFrame = 0;
+    idleFrames = 0;
+}
+
+bool MeshGeometry::UpdateDynamicVertices(const void * vertices, int vertexCount, GLsizei stride) {
+    if (!IsDynamic() || vertexCount != geometry.vertexCount || stride != dynamicStride) {
+        return false;
+    }
+    memcpy(dynamicVertices.data(), vertices, dynamicVertices.size());
+    dynamicChanged = true;
+    return true;
+}
+
+void Mesh::SetDynamicGeometry(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+        const void * vertices, int vertexCount, const void * indices, int indexCount, GLenum indexType) {
+    std::shared_ptr<MeshGeometry> newGeometry = std::make_shared<MeshGeometry>();
+    newGeometry->SetDynamicGeometry(stride, attributes, attributeCount, vertices, vertexCount,
+            indices, indexCount, indexType);
+    SetSharedGeometry(newGeometry);
+}
+
+void Mesh::SetGeometry(const GlGeometry & glGeometry, GLenum indexType) {
+    std::shared_ptr<MeshGeometry> newGeometry = std::make_shared<MeshGeometry>();
+    newGeometry->SetGeometry(glGeometry, indexType);
+    SetSharedGeometry(newGeometry);
+}
+
+void Mesh::SetInterleavedGeometry(const void * vertices, int vertexCount, GLsizei stride,
+        const VertexAttribute * attributes, int attributeCount,
+        const void * indices, int indexCount, GLenum indexType) {
+
+    MeshLodData lod;
+    lod.vertices = vertices;
+    lod.vertexCount = vertexCount;
+    lod.indices = indices;
+    lod.indexCount = indexCount;
+    lod.indexType = indexType;
+    lod.error = 0.0f;
+    SetGeometryLods(stride, attributes, attributeCount, &lod, 1);
+}
+
+void Mesh::SetGeometryLods(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+        const MeshLodData * lods, int lodCount) {
+    std::shared_ptr<MeshGeometry> newGeometry = std::make_shared<MeshGeometry>();
+    newGeometry->SetGeometryLods(stride, attributes, attributeCount, lods, lodCount);
+    SetSharedGeometry(newGeometry);
+}
+
+void Mesh::SetSharedGeometry(const std::shared_ptr<MeshGeometry> & newGeometry) {
+    // The old geometry is released outside the lock.
+    std::shared_ptr<MeshGeometry> oldGeometry = newGeometry;
+    lock();
+    geometry.swap(oldGeometry);
+    unlock();
+}
+
+std::shared_ptr<MeshGeometry> Mesh::GetSharedGeometry() {
+    lock();
+    std::shared_ptr<MeshGeometry> result = geometry;
+    unlock();
+    return result;
+}
+
+GlUpload::Builder Mesh::WithPendingBounds(const GlUpload::Builder & builder) {
+    lock();
+    const BoundingBoxInfo box = pendingBoundingBoxInfo;
+    const BoundingSphereInfo sphere = pendingBoundingSphereInfo;
+    unlock();
+
+    return [builder, box, sphere](Mesh * mesh) {
+        if (!builder(mesh)) {
+            return false;
+        }
+        mesh->ApplyBounds(box, sphere);
+        return true;
+    };
+}
+
+void Mesh::ApplyBounds(const BoundingBoxInfo & box, const BoundingSphereInfo & sphere) {
+    lock();
+    boundingBoxInfo = box;
+    boundingSphereInfo = sphere;
+    unlock();
+}
+
+void Mesh::QueueGeometry(const MeshKey & key, const GlUpload::Builder & builder, bool keepSource) {
+    const GlUpload::Builder boundedBuilder = WithPendingBounds(builder);
+    const GlUpload::Builder cachedBuilder = [key, boundedBuilder](Mesh * mesh) {
+        std::shared_ptr<MeshGeometry> cached = mesh_cache.Find(key);
+        if (cached) {
+            mesh->ApplyBounds(cached->GetBoundingBoxInfo(), cached->GetBoundingSphereInfo());
+            mesh->SetSharedGeometry(cached);
+            return true;
+        }
+
+        if (!boundedBuilder(mesh)) {
+            return false;
+        }
+
+        std::shared_ptr<MeshGeometry> built = mesh->GetSharedGeometry();
+        built->SetBounds(mesh->GetBoundingBoxInfo(), mesh->GetBoundingSphereInfo());
+        mesh_cache.Insert(key, built);
+        return true;
+    };
+
+    SetSource(keepSource ? cachedBuilder : GlUpload::Builder());
+    gl_upload.queue(this, cachedBuilder);
+}
+
+bool Mesh::Evict() {
+    lock();
+    const bool hasSource = static_cast<bool>(source);
+    unlock();
+    if (!hasSource || !IsUploaded()) {
+        return false;
+    }
+
+    // Other meshes may share the geometry. Its GL objects go with the last one.
+    SetSharedGeometry(std::make_shared<MeshGeometry>());
+    evicted = true;
+    return true;
+}
+
+void Mesh::Restore() {
+    if (!evicted) {
+        return;
+    }
+    evicted = false;
+
+    lock();
+    const GlUpload::Builder builder = source;
+    unlock();
+    if (builder) {
+        gl_upload.queue(this, builder);
+    }
+}
+
+std::shared_ptr<MeshGeometry> Mesh::QueueCachedGeometry(const MeshKey & key) {
+    std::shared_ptr<MeshGeometry> cached = mesh_cache.Find(key);
+    if (!cached) {
+        return cached;
+    }
+
+    // Bounds of cached geometry don't change after it is cached.
+    lock();
+    pendingBoundingBoxInfo = cached->GetBoundingBoxInfo();
+    pendingBoundingSphereInfo = cached->GetBoundingSphereInfo();
+    unlock();
+    QueueGeometry([cached](Mesh * mesh) {
+        mesh->SetSharedGeometry(cached);
+        return true;
+    });
+    return cached;
+}
+
+template<typename T>
+static inline void Append(std::vector<uint8_t> & out, size_t & offset, T value) {
+    memcpy(&out[offset], &value, sizeof(T));
+    offset += sizeof(T);
+}
+
+static inline uint16_t ToUnorm16(float value) {
+    return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+static inline uint8_t ToUnorm8(float value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+template<typename T>
+static inline float ReadComponent(const uint8_t * p, bool normalized) {
+    const T value = *reinterpret_cast<const T*>(p);
+    return normalized ? static_cast<float>(value) / std::numeric_limits<T>::max() : static_cast<float>(value);
+}
+
+void PackVertices(const float * positions, const float * colors, const float * uvs, int vertexCount,
+        const int32_t * indices, int indexCount, bool compact, PackedVertices & out) {
+
+    out.vertexCount = vertexCount;
+    out.indexCount = indexCount;
+    out.attributeCount = 0;
+
+    // Bounds are needed for quantization, so positions are read twice.
+    ComputeMinMax(positions, 3, vertexCount, &out.mins.x, &out.maxs.x);
+    ComputeBoundingSphere(positions, 3, vertexCount, &out.sphereCenter.x, out.sphereRadius);
+
+    bool uniformColor = true;
+    for (int i = 1; i < vertexCount && uniformColor; ++i) {
+        uniformColor = memcmp(&colors[0], &colors[i * 4], sizeof(float) * 4) == 0;
+    }
+
+    bool uvInUnitRange = true;
+    for (int i = 0; i < vertexCount * 2 && uvInUnitRange; ++i) {
+        uvInUnitRange = uvs[i] >= 0.0f && uvs[i] <= 1.0f;
+    }
+
+    const bool quantizePositions = compact;
+    const bool packColors = !(compact && uniformColor);
+    const bool quantizeUvs = compact && uvInUnitRange;
+
+    GLuint offset = 0;
+    VertexAttribute & position = out.attributes[out.attributeCount++];
+    position.location = VERTEX_ATTRIBUTE_LOCATION_POSITION;
+    position.size = 3;
+    position.type = quantizePositions ? GL_UNSIGNED_SHORT : GL_FLOAT;
+    position.normalized = quantizePositions ? GL_TRUE : GL_FALSE;
+    position.offset = offset;
+    offset += quantizePositions ? 8 : 12; // unorm16 x 3 and padding
+
+    if (packColors) {
+        VertexAttribute & color = out.attributes[out.attributeCount++];
+        color.location = VERTEX_ATTRIBUTE_LOCATION_COLOR;
+        color.size = 4;
+        color.type = compact ? GL_UNSIGNED_BYTE : GL_FLOAT;
+        color.normalized = compact ? GL_TRUE : GL_FALSE;
+        color.offset = offset;
+        offset += compact ? 4 : 16;
+    }
+
+    VertexAttribute & uv = out.attributes[out.attributeCount++];
+    uv.location = VERTEX_ATTRIBUTE_LOCATION_UV0;
+    uv.size = 2;
+    uv.type = quantizeUvs ? GL_UNSIGNED_SHORT : GL_FLOAT;
+    uv.normalized = quantizeUvs ? GL_TRUE : GL_FALSE;
+    uv.offset = offset;
+    offset += quantizeUvs ? 4 : 8;
+
+    out.stride = offset;
+
+    if (quantizePositions) {
+        out.positionBias = out.mins;
+        out.positionScale = out.maxs - out.mins;
+    } else {
+        out.positionBias = Vector3f();
+        out.positionScale = Vector3f(1.0f, 1.0f, 1.0f);
+    }
+    const Vector3f inverseScale(
+            out.positionScale.x > 0.0f ? 1.0f / out.positionScale.x : 0.0f,
+            out.positionScale.y > 0.0f ? 1.0f / out.positionScale.y : 0.0f,
+            out.positionScale.z > 0.0f ? 1.0f / out.positionScale.z : 0.0f);
+
+    out.vertices.resize(vertexCount * out.stride);
+    size_t p = 0;
+    for (int i = 0; i < vertexCount; ++i) {
+        const float * v = &positions[i * 3];
+        if (quantizePositions) {
+            Append(out.vertices, p, ToUnorm16((v[0] - out.positionBias.x) * inverseScale.x));
+            Append(out.vertices, p, ToUnorm16((v[1] - out.positionBias.y) * inverseScale.y));
+            Append(out.vertices, p, ToUnorm16((v[2] - out.positionBias.z) * inverseScale.z));
+            Append(out.vertices, p, static_cast<uint16_t>(0));
+        } else {
+            Append(out.vertices, p, v[0]);
+            Append(out.vertices, p, v[1]);
+            Append(out.vertices, p, v[2]);
+        }
+
+        if (packColors) {
+            const float * c = &colors[i * 4];
+            for (int k = 0; k < 4; ++k) {
+                if (compact) {
+                    Append(out.vertices, p, ToUnorm8(c[k]));
+                } else {
+                    Append(out.vertices, p, c[k]);
+                }
+            }
+        }
+
+        const float * t = &uvs[i * 2];
+        if (quantizeUvs) {
+            Append(out.vertices, p, ToUnorm16(t[0]));
+            Append(out.vertices, p, ToUnorm16(t[1]));
+        } else {
+            Append(out.vertices, p, t[0]);
+            Append(out.vertices, p, t[1]);
+        }
+    }
+
+    // Vertices are only dropped by OptimizePackedVertices(), so the index type can be decided here.
+    out.triangles.assign(indices, indices + indexCount);
+    out.indexType = vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    const size_t unpackedBytes = vertexCount * (sizeof(float) * (3 + 4 + 2)) + indexCount * 4;
+    out.bytesSaved = unpackedBytes - out.vertices.size() - indexCount * (out.indexType == GL_UNSIGNED_INT ? 4 : 2);
+}
+
+void OptimizePackedVertices(PackedVertices & packed, bool optimizeOverdraw, int lodCount) {
+    const size_t indexCount = packed.triangles.size();
+    packed.lodIndexCounts.assign(1, static_cast<int>(indexCount));
+    packed.lodErrors.assign(1, 0.0f);
+
+    // Out of range indices would break the optimizer. Leave such meshes as they are.
+    bool valid = indexCount % 3 == 0;
+    for (size_t i = 0; i < indexCount && valid; ++i) {
+        valid = packed.triangles[i] < static_cast<uint32_t>(packed.vertexCount);
+    }
+
+    if (valid) {
+        uint32_t * triangles = packed.triangles.data();
+        packed.acmrBefore = ComputeAcmr(triangles, indexCount, packed.vertexCount);
+        OptimizeVertexCache(triangles, indexCount, packed.vertexCount);
+
+        std::vector<float> positions;
+        if (optimizeOverdraw || lodCount > 1) {
+            positions.resize(packed.vertexCount * 3);
+            const uint8_t * v = packed.vertices.data();
+            const bool quantized = packed.attributes[0].type == GL_UNSIGNED_SHORT;
+            for (int i = 0; i < packed.vertexCount; ++i, v += packed.stride) {
+                for (int k = 0; k < 3; ++k) {
+                    positions[i * 3 + k] = quantized
+                            ? packed.positionBias[k] + ReadComponent<uint16_t>(v + k * 2, true) * packed.positionScale[k]
+                            : ReadComponent<float>(v + k * 4, false);
+                }
+            }
+        }
+
+        if (optimizeOverdraw) {
+            OptimizeOverdraw(triangles, indexCount, positions.data(), 3, packed.vertexCount);
+        }
+
+        packed.acmrAfter = ComputeAcmr(triangles, indexCount, packed.vertexCount);
+
+        // Each LOD halves the previous one. Errors add up because quadrics start over from the previous LOD.
+        std::vector<uint32_t> lod(packed.triangles);
+        std::vector<uint32_t> simplified;
+        float error = 0.0f;
+        for (int level = 1; level < lodCount; ++level) {
+            const size_t target = lod.size() / 6 * 3;
+            if (target < MIN_LOD_INDICES) {
+                break;
+            }
+            error += SimplifyMesh(lod.data(), lod.size(), positions.data(), 3, packed.vertexCount,
+                    target, MAX_LOD_ERROR, simplified);
+            if (simplified.empty() || simplified.size() > lod.size() * 3 / 4) {
+                break;
+            }
+            OptimizeVertexCache(simplified.data(), simplified.size(), packed.vertexCount);
+            packed.triangles.insert(packed.triangles.end(), simplified.begin(), simplified.end());
+            packed.lodIndexCounts.push_back(static_cast<int>(simplified.size()));
+            packed.lodErrors.push_back(error);
+            lod.swap(simplified);
+        }
+
+        // Store vertices in the order they are fetched. LODs only use vertices of LOD 0, unreferenced ones are dropped.
+        std::vector<uint32_t> remap;
+        const size_t used = BuildVertexFetchRemap(packed.triangles.data(), indexCount, packed.vertexCount, remap);
+        std::vector<uint8_t> vertices(used * packed.stride);
+        RemapVertices(packed.vertices.data(), vertices.data(), packed.stride, remap);
+        RemapIndices(packed.triangles.data(), packed.triangles.size(), remap);
+        packed.vertices.swap(vertices);
+        packed.vertexCount = static_cast<int>(used);
+    }
+
+    const uint32_t * triangles = packed.triangles.data();
+    const size_t totalIndexCount = packed.triangles.size();
+    if (packed.indexType == GL_UNSIGNED_SHORT) {
+        packed.indices.resize(totalIndexCount * 2);
+        size_t q = 0;
+        for (size_t i = 0; i < totalIndexCount; ++i) {
+            Append(packed.indices, q, static_cast<uint16_t>(triangles[i]));
+        }
+    } else {
+        packed.indices.resize(totalIndexCount * 4);
+        memcpy(packed.indices.data(), triangles, totalIndexCount * 4);
+    }
+
+    std::vector<uint32_t>().swap(packed.triangles);
+    packed.ready.store(true, std::memory_order_release);
+}
+
+// Uploads packed vertices once OptimizePackedVertices() is done with them.
+static GlUpload::Builder PackedVerticesBuilder(const std::shared_ptr<PackedVertices> & packed) {
+    return [packed](Mesh * mesh) {
+        if (!packed->ready.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const int indexSize = IndexSize(packed->indexType);
+        std::vector<MeshLodData> lods(packed->lodIndexCounts.size());
+        size_t indexOffset = 0;
+        for (size_t i = 0; i < lods.size(); ++i) {
+            lods[i].vertices = packed->vertices.data();
+            lods[i].vertexCount = packed->vertexCount;
+            lods[i].indices = packed->indices.data() + indexOffset;
+            lods[i].indexCount = packed->lodIndexCounts[i];
+            lods[i].indexType = packed->indexType;
+            lods[i].error = packed->lodErrors[i];
+            indexOffset += packed->lodIndexCounts[i] * indexSize;
+        }
+        mesh->SetGeometryLods(packed->stride, packed->attributes, packed->attributeCount,
+                lods.data(), lods.size());
+        mesh->SetPositionQuantization(packed->positionScale, packed->positionBias);
+        mesh->SetAcmr(packed->acmrBefore, packed->acmrAfter);
+        mesh->SetBytesSaved(static_cast<int>(packed->bytesSaved));
+        return true;
+    };
+}
+
+void Mesh::QueuePackedVertices(const std::shared_ptr<PackedVertices> & packed) {
+    SetBoundingBox(packed->mins, packed->maxs);
+    SetBoundingSphere(packed->sphereCenter, packed->sphereRadius);
+    QueueGeometry(PackedVerticesBuilder(packed));
+}
+
+void Mesh::QueuePackedVertices(const std::shared_ptr<PackedVertices> & packed, const MeshKey & key) {
+    SetBoundingBox(packed->mins, packed->maxs);
+    SetBoundingSphere(packed->sphereCenter, packed->sphereRadius);
+    QueueGeometry(key, PackedVerticesBuilder(packed), false);
+}
+
+void Mesh::QueueMeshFile(const std::shared_ptr<MeshFile> & file, const MeshKey & key) {
+    const MeshFileHeader & header = file->GetHeader();
+
+    SetBoundingBox(Vector3f(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+            Vector3f(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+    SetBoundingSphere(Vector3f(header.sphereCenter[0], header.sphereCenter[1], header.sphereCenter[2]),
+            header.sphereRadius);
+
+    QueueGeometry(key, [file](Mesh * mesh) {
+        const MeshFileHeader & header = file->GetHeader();
+
+        VertexAttribute attributes[MESH_FILE_MAX_ATTRIBUTES];
+        for (uint32_t i = 0; i < header.attributeCount; ++i) {
+            attributes[i].location = header.attributes[i].location;
+            attributes[i].size = header.attributes[i].size;
+            attributes[i].type = header.attributes[i].type;
+            attributes[i].normalized = header.attributes[i].normalized ? GL_TRUE : GL_FALSE;
+            attributes[i].offset = header.attributes[i].offset;
+        }
+
+        MeshLodData lods[MESH_FILE_MAX_LODS];
+        for (uint32_t i = 0; i < header.lodCount; ++i) {
+            lods[i].vertices = file->GetVertices(i);
+            lods[i].vertexCount = header.lods[i].vertexCount;
+            lods[i].indices = file->GetIndices(i);
+            lods[i].indexCount = header.lods[i].indexCount;
+            lods[i].indexType = header.lods[i].indexType;
+            lods[i].error = header.lods[i].error;
+        }
+        mesh->SetGeometryLods(header.vertexStride, attributes, header.attributeCount, lods, header.lodCount);
+
+        // unorm16 positions are quantized in the bounding box.
+        if (header.attributes[0].type == MESH_FILE_UNSIGNED_SHORT) {
+            const Vector3f mins(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+            const Vector3f maxs(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+            mesh->SetPositionQuantization(maxs - mins, mins);
+        }
+        return true;
+    });
+}
+
+void MeshGeometry::Draw(int lod) {
+    if (IsDynamic()) {
+        DrawDynamic();
+        return;
+    }
+
+    if (lod > 0 && !lods.empty()) {
+        const MeshLod & l = lods[std::min(lod, static_cast<int>(lods.size())) - 1];
+        glBindVertexArray(l.vertexArrayObject);
+        glDrawElements(GL_TRIANGLES, l.indexCount, l.indexType, reinterpret_cast<const void*>(l.indexOffset));
+        glBindVertexArray(0);
+        return;
+    }
+
+    if (indexType == GL_UNSIGNED_SHORT) {
+        geometry.Draw();
+        return;
+    }
+
+    glBindVertexArray(geometry.vertexArrayObject);
+    glDrawElements(GL_TRIANGLES, geometry.indexCount, indexType, nullptr);
+    glBindVertexArray(0);
+}
+
+void MeshGeometry::DrawDynamic() {
+    const uint32_t frame = gl_ring.GetFrameNumber();
+
+    // Decided on the first draw of a frame, then the other eye draws the same vertices.
+    if (drawnFrame != frame) {
+        if (dynamicChanged) {
+            // Streamed, so a change every frame neither reallocates nor waits for the GPU.
+            GLintptr offset;
+            if (!gl_ring.Write(dynamicVertices.data(), dynamicVertices.size(), 16, offset)) {
+                return;
+            }
+            BindDynamicVertices(gl_ring.GetBuffer(), offset);
+            dynamicChanged = false;
+            idleFrames = 0;
+        } else if (idleFrames == 0) {
+            // Ring data lives only for the frame it was written in. Unchanged vertices are copied
+            // once, and drawn from their own buffer until they change again.
+            UploadDynamicVertices();
+            BindDynamicVertices(geometry.vertexBuffer, 0);
+            idleFrames = 1;
+        } else if (++idleFrames >= DYNAMIC_IDLE_FRAMES) {
+            // The vertex array keeps pointing to the buffer, so it draws as static geometry from now on.
+            std::vector<uint8_t>().swap(dynamicVertices);
+            std::vector<VertexAttribute>().swap(dynamicAttributes);
+        }
+        drawnFrame = frame;
+    }
+
+    glBindVertexArray(geometry.vertexArrayObject);
+    glDrawElements(GL_TRIANGLES, geometry.indexCount, indexType, nullptr);
+    glBindVertexArray(0);
+}
+
+void MeshGeometry::BindDynamicVertices(GLuint buffer, GLintptr offset) {
+    glBindVertexArray(geometry.vertexArrayObject);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (size_t a = 0; a < dynamicAttributes.size(); ++a) {
+        const VertexAttribute & attribute = dynamicAttributes[a];
+        glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized,
+                dynamicStride, reinterpret_cast<const void*>(offset + attribute.offset));
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshGeometry::UploadDynamicVertices() {
+    if (geometry.vertexBuffer == 0) {
+        glGenBuffers(1, &geometry.vertexBuffer);
+        vertexBufferBytes = dynamicVertices.size();
+        residentBytes += vertexBufferBytes;
+        gpu_memory.Allocate(GPU_MEMORY_BUFFER, vertexBufferBytes);
+    }
+
+    // Respecified, so the driver gives new storage if frames in flight still read the old contents.
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, dynamicVertices.size(), dynamicVertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+template<typename T>
+static void ComputeBoundsT(const uint8_t * p, int vertexCount, GLsizei stride, bool normalized,
+        Vector3f & mins, Vector3f & maxs) {
+    for (int i = 0; i < vertexCount; ++i, p += stride) {
+        const float x = ReadComponent<T>(p, normalized);
+        const float y = ReadComponent<T>(p + sizeof(T), normalized);
+        const float z = ReadComponent<T>(p + sizeof(T) * 2, normalized);
+
+        mins.x = std::min(mins.x, x);
+        mins.y = std::min(mins.y, y);
+        mins.z = std::min(mins.z, z);
+
+        maxs.x = std::max(maxs.x, x);
+        maxs.y = std::max(maxs.y, y);
+        maxs.z = std::max(maxs.z, z);
+    }
+}
+
+bool ComputeBounds(const void * vertices, int vertexCount, GLsizei stride,
+        const VertexAttribute & position, Vector3f & mins, Vector3f & maxs,
+        Vector3f & center, float & radius) {
+
+    mins = Vector3f(FLT_MAX, FLT_MAX, FLT_MAX);
+    maxs = Vector3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    if (position.size < 3) {
+        return false;
+    }
+
+    const uint8_t * p = static_cast<const uint8_t*>(vertices) + position.offset;
+    const bool normalized = position.normalized == GL_TRUE;
+
+    // Aligned float streams, the usual case, go through the vectorized reduction.
+    if (position.type == GL_FLOAT && stride % sizeof(float) == 0
+            && reinterpret_cast<uintptr_t>(p) % sizeof(float) == 0) {
+        const float * positions = reinterpret_cast<const float*>(p);
+        ComputeMinMax(positions, stride / sizeof(float), vertexCount, &mins.x, &maxs.x);
+        ComputeBoundingSphere(positions, stride / sizeof(float), vertexCount, &center.x, radius);
+        return true;
+    }
+
+    switch (position.type) {
+    case GL_FLOAT:
+        ComputeBoundsT<float>(p, vertexCount, stride, false, mins, maxs);
+        break;
+    case GL_SHORT:
+        ComputeBoundsT<int16_t>(p, vertexCount, stride, normalized, mins, maxs);
+        break;
+    case GL_UNSIGNED_SHORT:
+        ComputeBoundsT<uint16_t>(p, vertexCount, stride, normalized, mins, maxs);
+        break;
+    case GL_BYTE:
+        ComputeBoundsT<int8_t>(p, vertexCount, stride, normalized, mins, maxs);
+        break;
+    case GL_UNSIGNED_BYTE:
+        ComputeBoundsT<uint8_t>(p, vertexCount, stride, normalized, mins, maxs);
+        break;
+    default:
+        return false;
+    }
+
+    if (vertexCount == 0) {
+        mins = maxs = Vector3f();
+    }
+
+    // Sphere around the box for the other types.
+    center = (mins + maxs) * 0.5f;
+    radius = (maxs - center).Length();
+    return true;
+}
+
 void Mesh::SetBoundingBox(const Vector3f & mins, const Vector3f & maxs){
-    boundingBoxInfo.mins = mins;
-    boundingBoxInfo.maxs = maxs;
+    lock();
+    pendingBoundingBoxInfo.mins = mins;
+    pendingBoundingBoxInfo.maxs = maxs;
 
     Vector3f center = (mins + maxs) * 0.5f;
 
@@ -31,18 +808,27 @@ void Mesh::SetBoundingBox(const Vector3f & mins, const Vector3f & maxs){
     float radius = sqrtf(x_squared + y_squared + z_squared);
 
     // assign the sphere
-    boundingSphereInfo.center = center;
-    boundingSphereInfo.radius = radius;
+    pendingBoundingSphereInfo.center = center;
+    pendingBoundingSphereInfo.radius = radius;
+    unlock();
 }
 
 const BoundingBoxInfo & Mesh::GetBoundingBoxInfo() {
     return boundingBoxInfo;
 }
 
+BoundingBoxInfo Mesh::CopyBoundingBoxInfo() {
+    lock();
+    const BoundingBoxInfo box = boundingBoxInfo;
+    unlock();
+    return box;
+}
+
 void Mesh::GetTransformedBoundingBoxInfo(OVR::Matrix4f *Mat,
         float *transformed_bounding_box) {
 
     OVR::Matrix4f M(*Mat);
+    const BoundingBoxInfo box = CopyBoundingBoxInfo();
     float a, b;
 
     //Inspired by Graphics Gems - TransBox.c
@@ -60,8 +846,8 @@ void Mesh::GetTransformedBoundingBoxInfo(OVR::Matrix4f *Mat,
 
     for (int i = 0; i < 3; i++) {
         //x coord
-        a = M.M[0][i] * boundingBoxInfo.mins.x;
-        b = M.M[0][i] * boundingBoxInfo.maxs.x;
+        a = M.M[0][i] * box.mins.x;
+        b = M.M[0][i] * box.maxs.x;
         if (a < b) {
             transformed_bounding_box[0] += a;
             transformed_bounding_box[3] += b;
@@ -71,8 +857,8 @@ void Mesh::GetTransformedBoundingBoxInfo(OVR::Matrix4f *Mat,
         }
 
         //y coord
-        a = M.M[1][i] * boundingBoxInfo.mins.y;
-        b = M.M[1][i] * boundingBoxInfo.maxs.y;
+        a = M.M[1][i] * box.mins.y;
+        b = M.M[1][i] * box.maxs.y;
         if (a < b) {
             transformed_bounding_box[1] += a;
             transformed_bounding_box[4] += b;
@@ -82,8 +868,8 @@ void Mesh::GetTransformedBoundingBoxInfo(OVR::Matrix4f *Mat,
         }
 
         //z coord
-        a = M.M[2][i] * boundingBoxInfo.mins.z;
-        b = M.M[2][i] * boundingBoxInfo.maxs.z;
+        a = M.M[2][i] * box.mins.z;
+        b = M.M[2][i] * box.maxs.z;
         if (a < b) {
             transformed_bounding_box[2] += a;
             transformed_bounding_box[5] += b;
@@ -96,7 +882,7 @@ void Mesh::GetTransformedBoundingBoxInfo(OVR::Matrix4f *Mat,
     *Mat = M;
 }
 
-// This gives us a really coarse bounding sphere given the already calcuated bounding box.  This won't be a tight-fitting sphere because it is based on the bounding box.  We can revisit this later if we decide we need a tighter sphere.
+// Ritter's sphere of the vertices or an analytic one for procedural meshes; the sphere around the bounding box otherwise.
 const BoundingSphereInfo & Mesh::GetBoundingSphereInfo() {
     return boundingSphereInfo;
 }
@@ -21,11 +21,20 @@
 #ifndef MESH_H_
 #define MESH_H_
 
+#include <atomic>
+#include <memory>
+#include <pthread.h>
+
 #include "HybridObject.h"
 #include "Material.h"
 #include "util/GL.h"
+#include "util/GlUpload.h"
+#include "util/GpuMemory.h"
+#include "util/ObjectPool.h"
 
 namespace mgn {
+class MeshFile;
+class MeshKey;
 
 struct BoundingBoxInfo {
     Vector3f mins;
@@ -37,37 +46,404 @@ struct BoundingSphereInfo {
     float radius;
 };
 
-class Mesh: public HybridObject {
+// An attribute in an interleaved vertex buffer. Location is one of VERTEX_ATTRIBUTE_LOCATION_*.
+struct VertexAttribute {
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;
+};
+
+// Streams of a LOD. LODs which pass the same vertices pointer share the vertex buffer.
+struct MeshLodData {
+    const void * vertices;
+    int          vertexCount;
+    const void * indices;
+    int          indexCount;
+    GLenum       indexType;
+    float        error; // Simplification error relative to the largest extent of the bounding box
+};
+
+// Computes the bounding box and sphere of the position attribute. Returns false if the type is not supported.
+bool ComputeBounds(const void * vertices, int vertexCount, GLsizei stride,
+        const VertexAttribute & position, Vector3f & mins, Vector3f & maxs,
+        Vector3f & center, float & radius);
+
+/**
+ * Interleaved vertices and indices packed from separate float arrays.
+ * In the compact layout positions are unorm16 in the bounding box, colors
+ * are unorm8 or dropped when every vertex has the same color, UVs are
+ * unorm16 when they are in [0, 1], and indices are 16 bit when possible.
+ * indices is filled by OptimizePackedVertices(), which sets ready at last.
+ * LODs follow LOD 0 in indices and share the vertices.
+ */
+struct PackedVertices {
+    PackedVertices() :
+            acmrBefore(0.0f),
+            acmrAfter(0.0f),
+            ready(false) {
+    }
+
+    std::vector<uint8_t> vertices;
+    std::vector<uint32_t> triangles; // Until optimized
+    std::vector<uint8_t> indices;
+    VertexAttribute attributes[3];
+    int      attributeCount;
+    GLsizei  stride;
+    int      vertexCount;
+    int      indexCount;
+    GLenum   indexType;
+    Vector3f mins;
+    Vector3f maxs;
+    Vector3f sphereCenter;
+    float    sphereRadius;
+    Vector3f positionScale; // position = positionBias + attribute * positionScale
+    Vector3f positionBias;
+    size_t   bytesSaved;    // Compared with float attributes and 32 bit indices
+    float    acmrBefore;
+    float    acmrAfter;
+    std::vector<int>   lodIndexCounts;
+    std::vector<float> lodErrors;
+    std::atomic<bool> ready;
+};
+
+void PackVertices(const float * positions, const float * colors, const float * uvs, int vertexCount,
+        const int32_t * indices, int indexCount, bool compact, PackedVertices & out);
+
+// Reorders triangles for the vertex cache (and overdraw), generates up to lodCount - 1 simplified LODs,
+// then stores vertices in fetch order. Can be run on any thread.
+void OptimizePackedVertices(PackedVertices & packed, bool optimizeOverdraw, int lodCount);
+
+/**
+ * GL objects of a mesh. Meshes built from the same key share one through
+ * mesh_cache, so it is never changed after it is set to a mesh: a rebuild
+ * makes new geometry. The GL objects are released through gl_delete when
+ * the last mesh lets it go.
+ */
+class MeshGeometry {
 public:
-    Mesh() {
+    MeshGeometry() :
+            indexType(GL_UNSIGNED_SHORT),
+            positionScale(1.0f, 1.0f, 1.0f),
+            acmrBefore(0.0f),
+            acmrAfter(0.0f),
+            bytesSaved(0),
+            residentBytes(0),
+            vertexBufferBytes(0),
+            indexBufferBytes(0),
+            dynamicStride(0),
+            dynamicChanged(false),
+            drawnFrame(0),
+            idleFrames(0) {
+        boundingSphereInfo.radius = 0.0f;
     }
 
-    ~Mesh() {
-        geometry.Free();
+    ~MeshGeometry() {
+        ReleaseGeometry();
     }
 
     const GlGeometry & GetGeometry() const {
         return geometry;
     }
 
-    const GlGeometry & GetGeometry() {
-        return geometry;
+    // Must be called on the GL thread. The buffers are accounted in gpu_memory.
+    void SetGeometry(const GlGeometry & geometry, GLenum indexType = GL_UNSIGNED_SHORT);
+
+    // Must be called on the GL thread, after the geometry is set.
+    void SetPositionQuantization(const Vector3f & scale, const Vector3f & bias) {
+        positionScale = scale;
+        positionBias = bias;
+    }
+
+    const Vector3f & GetPositionScale() const {
+        return positionScale;
+    }
+
+    const Vector3f & GetPositionBias() const {
+        return positionBias;
+    }
+
+    // Must be called on the GL thread. LODs are packed in one vertex and one index buffer,
+    // each LOD gets its own vertex array unless it shares the vertices of LOD 0.
+    void SetGeometryLods(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+            const MeshLodData * lods, int lodCount);
+
+    // Must be called on the GL thread. The vertices are kept here, so UpdateDynamicVertices() can
+    // replace them without making new GL objects. They are written to gl_ring on the first draw of
+    // a frame in which they changed, and copied once to a vertex buffer of their own when a frame
+    // draws them unchanged. After DYNAMIC_IDLE_FRAMES unchanged frames the copy here is dropped and
+    // the geometry is static again. Dynamic geometry is never cached.
+    void SetDynamicGeometry(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+            const void * vertices, int vertexCount, const void * indices, int indexCount, GLenum indexType);
+
+    // Must be called on the GL thread. Returns false unless the geometry is dynamic with the same layout.
+    bool UpdateDynamicVertices(const void * vertices, int vertexCount, GLsizei stride);
+
+    bool IsDynamic() const {
+        return !dynamicVertices.empty();
+    }
+
+    int GetLodCount() const {
+        return 1 + static_cast<int>(lods.size());
+    }
+
+    // Relative to the largest extent of the bounding box. 0 for LOD 0.
+    float GetLodError(int lod) const {
+        return lod <= 0 ? 0.0f : lods[lod - 1].error;
+    }
+
+    bool IsUploaded() const {
+        return geometry.vertexArrayObject != 0;
+    }
+
+    GLenum GetIndexType() const {
+        return indexType;
+    }
+
+    void SetAcmr(float before, float after) {
+        acmrBefore = before;
+        acmrAfter = after;
+    }
+
+    float GetAcmrBefore() const {
+        return acmrBefore;
+    }
+
+    float GetAcmrAfter() const {
+        return acmrAfter;
+    }
+
+    void SetBytesSaved(int bytes) {
+        bytesSaved = bytes;
+    }
+
+    int GetBytesSaved() const {
+        return bytesSaved;
+    }
+
+    // Size of the GL buffers.
+    size_t GetResidentBytes() const {
+        return residentBytes;
+    }
+
+    // Bounds of the data it was built from, copied to meshes which find it in the cache.
+    void SetBounds(const BoundingBoxInfo & box, const BoundingSphereInfo & sphere) {
+        boundingBoxInfo = box;
+        boundingSphereInfo = sphere;
+    }
+
+    const BoundingBoxInfo & GetBoundingBoxInfo() const {
+        return boundingBoxInfo;
+    }
+
+    const BoundingSphereInfo & GetBoundingSphereInfo() const {
+        return boundingSphereInfo;
+    }
+
+    // Must be called on the GL thread.
+    void Draw(int lod = 0);
+
+private:
+    // LOD 1 and later. LOD 0 is geometry.
+    struct MeshLod {
+        GLuint    vertexArrayObject;
+        int       indexCount;
+        GLenum    indexType;
+        uintptr_t indexOffset;
+        float     error;
+    };
+
+    MeshGeometry(const MeshGeometry& geometry);
+    MeshGeometry& operator=(const MeshGeometry& geometry);
+
+    // GL objects may still be used by in-flight frames, so they are deleted through gl_delete.
+    void ReleaseGeometry();
+
+    void DrawDynamic();
+
+    // Points the vertex array to dynamic vertices at offset in buffer.
+    void BindDynamicVertices(GLuint buffer, GLintptr offset);
+
+    // Copies dynamic vertices to geometry.vertexBuffer, which is made or respecified.
+    void UploadDynamicVertices();
+
+    GlGeometry geometry;
+    GLenum indexType;
+    std::vector<MeshLod> lods;
+
+    // Dequantization of positions, done in the shader.
+    Vector3f positionScale;
+    Vector3f positionBias;
+
+    float acmrBefore;
+    float acmrAfter;
+    int bytesSaved;
+    size_t residentBytes;
+    size_t vertexBufferBytes;
+    size_t indexBufferBytes;
+
+    BoundingBoxInfo boundingBoxInfo;
+    BoundingSphereInfo boundingSphereInfo;
+
+    // Vertices of dynamic geometry. dynamicChanged is set when they change and cleared when they are
+    // streamed. drawnFrame is the gl_ring frame number of the last draw, and idleFrames counts frames
+    // drawn since the last change.
+    std::vector<uint8_t> dynamicVertices;
+    std::vector<VertexAttribute> dynamicAttributes;
+    GLsizei dynamicStride;
+    bool dynamicChanged;
+    uint32_t drawnFrame;
+    uint32_t idleFrames;
+};
+
+/**
+ * The geometry is replaced only on the GL thread, so the renderer reads it
+ * without locking. Other threads get it through GetSharedGeometry().
+ *
+ * A mesh built from a source which can be run again (procedural builders and
+ * mesh files) can be evicted by gpu_memory when it is not drawn, and is built
+ * again when it is drawn next. Meshes built from arrays are not evicted, as
+ * their vertices are not kept after upload.
+ */
+class Mesh: public HybridObject, public GpuResource, public Pooled<Mesh, POOL_MESH> {
+public:
+    Mesh() :
+            geometry(std::make_shared<MeshGeometry>()),
+            evicted(false) {
+        pthread_mutex_init(&mutex, 0);
+        boundingSphereInfo.radius = 0.0f;
+        pendingBoundingSphereInfo.radius = 0.0f;
+    }
+
+    ~Mesh() {
+        gl_upload.cancel(this);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    const GlGeometry & GetGeometry() const {
+        return geometry->GetGeometry();
+    }
+
+    // Must be called on the GL thread. Each of the setters makes new geometry.
+    void SetGeometry(const GlGeometry & geometry, GLenum indexType = GL_UNSIGNED_SHORT);
+
+    // Must be called on the GL thread. Vertices and indices are uploaded with one glBufferData each.
+    void SetInterleavedGeometry(const void * vertices, int vertexCount, GLsizei stride,
+            const VertexAttribute * attributes, int attributeCount,
+            const void * indices, int indexCount, GLenum indexType);
+
+    // Must be called on the GL thread. See MeshGeometry::SetGeometryLods().
+    void SetGeometryLods(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+            const MeshLodData * lods, int lodCount);
+
+    // Must be called on the GL thread. See MeshGeometry::SetDynamicGeometry().
+    void SetDynamicGeometry(GLsizei stride, const VertexAttribute * attributes, int attributeCount,
+            const void * vertices, int vertexCount, const void * indices, int indexCount, GLenum indexType);
+
+    // Must be called on the GL thread. Returns false if the geometry is not dynamic, then set it first.
+    bool UpdateDynamicVertices(const void * vertices, int vertexCount, GLsizei stride) {
+        return geometry->UpdateDynamicVertices(vertices, vertexCount, stride);
+    }
+
+    // Must be called on the GL thread, after the geometry is set and before it is shared.
+    void SetPositionQuantization(const Vector3f & scale, const Vector3f & bias) {
+        geometry->SetPositionQuantization(scale, bias);
+    }
+
+    const Vector3f & GetPositionScale() const {
+        return geometry->GetPositionScale();
+    }
+
+    const Vector3f & GetPositionBias() const {
+        return geometry->GetPositionBias();
+    }
+
+    int GetLodCount() const {
+        return geometry->GetLodCount();
+    }
+
+    float GetLodError(int lod) const {
+        return geometry->GetLodError(lod);
     }
 
-    void SetGeometry(const GlGeometry & geometry) {
-        this->geometry.Free();
-        this->geometry = geometry;
+    // Can be called on any thread. The builder is run by gl_upload on the GL thread.
+    // Bounds set before are applied with the geometry.
+    void QueueGeometry(const GlUpload::Builder & builder) {
+        SetSource(GlUpload::Builder());
+        gl_upload.queue(this, WithPendingBounds(builder));
     }
 
+    // Can be called on any thread. The geometry is looked up in mesh_cache by key on the GL thread,
+    // and built and cached only if it is not there. Bounds must be set before.
+    // If keepSource, the builder is kept for building again after eviction.
+    void QueueGeometry(const MeshKey & key, const GlUpload::Builder & builder, bool keepSource = true);
+
+    // Can be called on any thread. Takes the geometry and bounds cached for key, and returns the geometry.
+    // Returns null if nothing is cached for key.
+    std::shared_ptr<MeshGeometry> QueueCachedGeometry(const MeshKey & key);
+
+    // Must be called on the GL thread.
+    void SetSharedGeometry(const std::shared_ptr<MeshGeometry> & geometry);
+
+    // Can be called on any thread.
+    std::shared_ptr<MeshGeometry> GetSharedGeometry();
+
+    bool IsUploaded() const {
+        return geometry->IsUploaded();
+    }
+
+    GLenum GetIndexType() const {
+        return geometry->GetIndexType();
+    }
+
+    // Average cache miss ratio of the triangles before and after optimization. 0 if not measured.
+    // Must be called on the GL thread, after the geometry is set and before it is shared.
+    void SetAcmr(float before, float after) {
+        geometry->SetAcmr(before, after);
+    }
+
+    void SetBytesSaved(int bytes) {
+        geometry->SetBytesSaved(bytes);
+    }
+
+    void Draw(int lod = 0) const {
+        geometry->Draw(lod);
+    }
+
+    // Can be called on any thread. Bounds of the geometry queued next. They replace the current bounds
+    // on the GL thread when that geometry is set, so the renderer never sees them apart.
     void SetBoundingBox(const Vector3f & mins, const Vector3f & maxs);
 
+    // Overrides the sphere derived from the bounding box.
+    void SetBoundingSphere(const Vector3f & center, float radius) {
+        lock();
+        pendingBoundingSphereInfo.center = center;
+        pendingBoundingSphereInfo.radius = radius;
+        unlock();
+    }
+
+    // Can be called on any thread. Sets the bounds, and uploads the vertices when they are optimized.
+    void QueuePackedVertices(const std::shared_ptr<PackedVertices> & packed);
+    void QueuePackedVertices(const std::shared_ptr<PackedVertices> & packed, const MeshKey & key);
+
+    // Can be called on any thread. The file is kept mapped as the source of the mesh.
+    void QueueMeshFile(const std::shared_ptr<MeshFile> & file, const MeshKey & key);
+
+    // Must be called on the GL thread. Bounds of the current geometry.
     const BoundingBoxInfo & GetBoundingBoxInfo(); // Xmin, Ymin, Zmin and Xmax, Ymax, Zmax
+    const BoundingSphereInfo & GetBoundingSphereInfo(); // Get bounding sphere based on the bounding box
+
+    // Can be called on any thread.
+    BoundingBoxInfo CopyBoundingBoxInfo();
     void GetTransformedBoundingBoxInfo(OVR::Matrix4f *M,
             float *transformed_bounding_box); //Get Bounding box info transformed by matrix
-    const BoundingSphereInfo & GetBoundingSphereInfo(); // Get bounding sphere based on the bounding box
 
-    // generate VAO
-    void GenerateVAO();
+    // Must be called on the GL thread. Lets the geometry go, if it can be built again from the source.
+    bool Evict();
+
+    // Must be called on the GL thread. Queues building from the source, if the geometry was evicted.
+    void Restore();
 
 private:
     Mesh(const Mesh& mesh);
@@ -75,13 +451,42 @@ private:
     Mesh& operator=(const Mesh& mesh);
     Mesh& operator=(Mesh&& mesh);
 
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    void SetSource(const GlUpload::Builder & builder) {
+        lock();
+        source = builder;
+        unlock();
+    }
+
+    // The bounds pending when it is called are applied after builder succeeds.
+    GlUpload::Builder WithPendingBounds(const GlUpload::Builder & builder);
+
+    // Must be called on the GL thread, next to setting the geometry.
+    void ApplyBounds(const BoundingBoxInfo & box, const BoundingSphereInfo & sphere);
+
 private:
 
-    // bounding box info
+    // Bounds of the current geometry. Written on the GL thread with the mutex held.
     BoundingBoxInfo boundingBoxInfo;
     BoundingSphereInfo boundingSphereInfo;
 
-    GlGeometry geometry;
+    // Bounds of the geometry queued next. Guarded by the mutex.
+    BoundingBoxInfo pendingBoundingBoxInfo;
+    BoundingSphereInfo pendingBoundingSphereInfo;
+
+    // Never null. Written on the GL thread with the mutex held.
+    std::shared_ptr<MeshGeometry> geometry;
+    pthread_mutex_t mutex;
+
+    // Builds the current geometry again. Empty if it can't. Guarded by the mutex.
+    GlUpload::Builder source;
+    bool evicted; // Owned by the GL thread
 };
 }
 #endif
@@ -15,156 +15,495 @@
 
 #include "includes.h"
 #include "Mesh.h"
+#include "util/HandleTable.h"
+#include "util/MeshCache.h"
+#include "util/MeshFile.h"
+#include "util/Worker.h"
 
 namespace mgn {
+
+// Forsyth reordering takes about 1 ms per 1000 triangles on a phone.
+static const int MAX_INLINE_OPTIMIZE_TRIANGLES = 4096;
+
+// BuildDome(), BuildGlobe() and BuildSpherePatch() in GlGeometry.cpp make vertices on this sphere.
+static const float GEOMETRY_SPHERE_RADIUS = 100.0f;
+
+/**
+ * Bounds of BuildDome(). Latitude runs from the north pole (+Y) down by latRads
+ * over all longitudes, so the dome is a cap of the sphere around +Y.
+ */
+static void SetDomeBounds(Mesh * mesh, float latRads) {
+    const float r = GEOMETRY_SPHERE_RADIUS;
+    const float cap = std::min(std::max(latRads, 0.0f), MATH_FLOAT_PI);
+    const float width = cap < MATH_FLOAT_PI * 0.5f ? r * sinf(cap) : r;
+    const float bottom = r * cosf(cap);
+    mesh->SetBoundingBox(Vector3f(-width, bottom, -width), Vector3f(width, r, width));
+
+    // Up to a hemisphere the base circle bounds the cap, the pole is closer to its center.
+    if (cap < MATH_FLOAT_PI * 0.5f) {
+        mesh->SetBoundingSphere(Vector3f(0.0f, bottom, 0.0f), width);
+    } else {
+        mesh->SetBoundingSphere(Vector3f(), r);
+    }
+}
+
+/**
+ * Bounds of BuildSpherePatch(). Latitude and longitude both span fov around
+ * the Z axis. Which end of the axis it faces has changed between SDK
+ * versions, so both are covered.
+ */
+static void SetSpherePatchBounds(Mesh * mesh, float fov) {
+    const float r = GEOMETRY_SPHERE_RADIUS;
+    const float half = std::min(std::max(fov, 0.0f), MATH_FLOAT_PI) * 0.5f;
+    const float width = r * sinf(half);
+    mesh->SetBoundingBox(Vector3f(-width, -width, -r), Vector3f(width, width, r));
+    mesh->SetBoundingSphere(Vector3f(), r);
+}
+
+/**
+ * Keeps a direct buffer alive until the geometry is uploaded on the GL thread.
+ * Data starts at position of the buffer.
+ */
+class DirectBufferRef {
+public:
+    DirectBufferRef(JNIEnv * env, jobject buffer, jint position) : address(nullptr), size(0) {
+        env->GetJavaVM(&vm);
+        this->buffer = env->NewGlobalRef(buffer);
+        uint8_t * base = static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer));
+        const jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (base != nullptr && position >= 0 && position <= capacity) {
+            address = base + position;
+            size = static_cast<size_t>(capacity - position);
+        }
+    }
+
+    ~DirectBufferRef() {
+        JNIEnv * env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+            env->DeleteGlobalRef(buffer);
+        } else {
+            __android_log_print(ANDROID_LOG_ERROR, "mgn", "DirectBufferRef : released on a detached thread");
+        }
+    }
+
+    const void * GetAddress() const {
+        return address;
+    }
+
+    // Bytes from position to capacity.
+    size_t GetSize() const {
+        return size;
+    }
+
+private:
+    DirectBufferRef(const DirectBufferRef& ref);
+    DirectBufferRef& operator=(const DirectBufferRef& ref);
+
+    JavaVM * vm;
+    jobject buffer;
+    void * address;
+    size_t size;
+};
+
+// Same types as Mesh.VertexLayout in Java side. Returns 0 for others.
+static int AttributeTypeSize(GLenum type) {
+    switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_FLOAT:
+    case GL_FIXED:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+template<typename T>
+static bool IndicesInRange(const void * indices, int indexCount, int vertexCount) {
+    const T * p = static_cast<const T*>(indices);
+    for (int i = 0; i < indexCount; ++i) {
+        if (static_cast<int64_t>(p[i]) >= vertexCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Buffers are read on the GL thread later, so a layout which doesn't fit them is rejected here.
+ */
+static bool ValidateInterleaved(const DirectBufferRef & vertices, int vertexCount, int stride,
+        const std::vector<VertexAttribute> & attributes, const DirectBufferRef & indices, int indexCount,
+        GLenum indexType) {
+
+    const char * error = nullptr;
+    const int indexSize = indexType == GL_UNSIGNED_INT ? 4 : (indexType == GL_UNSIGNED_SHORT ? 2 : 0);
+    if (vertices.GetAddress() == nullptr || indices.GetAddress() == nullptr) {
+        error = "buffers must be direct";
+    } else if (vertexCount < 0 || indexCount < 0 || stride <= 0) {
+        error = "counts and stride must be positive";
+    } else if (indexSize == 0) {
+        error = "indexType must be GL_UNSIGNED_SHORT or GL_UNSIGNED_INT";
+    } else if (static_cast<int64_t>(vertexCount) * stride > static_cast<int64_t>(vertices.GetSize())) {
+        error = "vertices are larger than the remaining bytes of the buffer";
+    } else if (static_cast<int64_t>(indexCount) * indexSize > static_cast<int64_t>(indices.GetSize())) {
+        error = "indices are larger than the remaining bytes of the buffer";
+    }
+
+    for (size_t i = 0; error == nullptr && i < attributes.size(); ++i) {
+        const VertexAttribute & attribute = attributes[i];
+        const int typeSize = AttributeTypeSize(attribute.type);
+        if (typeSize == 0 || attribute.size < 1 || attribute.size > 4) {
+            error = "unsupported attribute size or type";
+        } else if (static_cast<int64_t>(attribute.offset) + attribute.size * typeSize > stride) {
+            error = "attribute exceeds stride";
+        }
+    }
+
+    if (error == nullptr) {
+        const bool inRange = indexType == GL_UNSIGNED_INT
+                ? IndicesInRange<uint32_t>(indices.GetAddress(), indexCount, vertexCount)
+                : IndicesInRange<uint16_t>(indices.GetAddress(), indexCount, vertexCount);
+        if (!inRange) {
+            error = "index out of vertexCount";
+        }
+    }
+
+    if (error != nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "Mesh::buildInterleaved() : %s", error);
+        return false;
+    }
+    return true;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 JNIEXPORT jlong JNICALL
 Java_com_eje_1c_meganekko_Mesh_initNativeInstance(JNIEnv* env, jobject obj) {
-    return reinterpret_cast<jlong>(new Mesh());
+    return NewHandle(new Mesh());
 }
 
-JNIEXPORT void JNICALL
+JNIEXPORT jint JNICALL
 Java_com_eje_1c_meganekko_Mesh_build(JNIEnv * env, jobject obj, jlong jmesh,
-        jfloatArray jPositions, jfloatArray jColors, jfloatArray jUVs, jintArray jTriangles) {
+        jfloatArray jPositions, jfloatArray jColors, jfloatArray jUVs, jintArray jTriangles, jboolean compact,
+        jboolean optimizeOverdraw, jint lodCount) {
+
+    const int vertexCount = env->GetArrayLength(jPositions) / 3;
+    const int indexCount = env->GetArrayLength(jTriangles);
+
+    // Copied out, so that no lock is taken and no long work is done while the GC is blocked.
+    std::vector<float> positions(vertexCount * 3);
+    std::vector<float> colors(vertexCount * 4);
+    std::vector<float> uvs(vertexCount * 2);
+    std::vector<jint> triangles(indexCount);
+    env->GetFloatArrayRegion(jPositions, 0, positions.size(), positions.data());
+    env->GetFloatArrayRegion(jColors, 0, colors.size(), colors.data());
+    env->GetFloatArrayRegion(jUVs, 0, uvs.size(), uvs.data());
+    env->GetIntArrayRegion(jTriangles, 0, triangles.size(), triangles.data());
+
+    // Same data and options make the same geometry. Hashing is much cheaper than packing and optimizing.
+    const MeshKey key = MeshKey("build")
+            .Add(positions.data(), positions.size() * sizeof(float))
+            .Add(colors.data(), colors.size() * sizeof(float))
+            .Add(uvs.data(), uvs.size() * sizeof(float))
+            .Add(triangles.data(), triangles.size() * sizeof(jint))
+            .Add(compact).Add(optimizeOverdraw).Add(lodCount)
+            .Counts(vertexCount, indexCount);
+
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    std::shared_ptr<MeshGeometry> cached = mesh->QueueCachedGeometry(key);
+    if (cached) {
+        return static_cast<jint>(cached->GetBytesSaved());
+    }
 
-    VertexAttribs attribs;
+    std::shared_ptr<PackedVertices> packed(new PackedVertices());
+    PackVertices(positions.data(), colors.data(), uvs.data(), vertexCount, triangles.data(), indexCount, compact,
+            *packed);
+
+    // Large meshes and LODs are made on the worker. Until then the builder is retried every frame.
+    if (indexCount / 3 <= MAX_INLINE_OPTIMIZE_TRIANGLES && lodCount <= 1) {
+        OptimizePackedVertices(*packed, optimizeOverdraw, 1);
+    } else {
+        const bool overdraw = optimizeOverdraw;
+        const int lods = lodCount;
+        worker.Post([packed, overdraw, lods]() {
+            OptimizePackedVertices(*packed, overdraw, lods);
+        });
+    }
 
-    // positions
-    jsize jPositionsSize = env->GetArrayLength(jPositions);
-    jfloat *jPositionsElements = env->GetFloatArrayElements(jPositions, 0);
+    mesh->QueuePackedVertices(packed, key);
 
-    // for bounding box
-    Vector3f mins;
-    Vector3f maxs;
+    return static_cast<jint>(packed->bytesSaved);
+}
 
-    for (int i = 0; i < jPositionsSize; i += 3) {
-        float x = jPositionsElements[i];
-        float y = jPositionsElements[i + 1];
-        float z = jPositionsElements[i + 2];
-        attribs.position.PushBack(Vector3f(x, y, z));
-        attribs.color.PushBack(Vector4f(1.0f, 1.0f, 1.0f, 1.0f));
+JNIEXPORT jboolean JNICALL
+Java_com_eje_1c_meganekko_Mesh_buildInterleaved(JNIEnv * env, jobject obj, jlong jmesh,
+        jobject jvertices, jint verticesPosition, jint vertexCount, jint stride, jintArray jattributes,
+        jobject jindices, jint indicesPosition, jint indexCount, jint indexType) {
+
+    std::shared_ptr<DirectBufferRef> vertices(new DirectBufferRef(env, jvertices, verticesPosition));
+    std::shared_ptr<DirectBufferRef> indices(new DirectBufferRef(env, jindices, indicesPosition));
+
+    // (location, size, type, normalized, offset) for each attribute
+    jsize jattributesSize = env->GetArrayLength(jattributes);
+    std::vector<jint> values(jattributesSize);
+    env->GetIntArrayRegion(jattributes, 0, jattributesSize, values.data());
+
+    std::vector<VertexAttribute> attributes(jattributesSize / 5);
+    const VertexAttribute * position = nullptr;
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        attributes[i].location = values[i * 5];
+        attributes[i].size = values[i * 5 + 1];
+        attributes[i].type = values[i * 5 + 2];
+        attributes[i].normalized = values[i * 5 + 3] ? GL_TRUE : GL_FALSE;
+        attributes[i].offset = values[i * 5 + 4];
+        if (attributes[i].location == VERTEX_ATTRIBUTE_LOCATION_POSITION) {
+            position = &attributes[i];
+        }
+    }
 
-        // calc mins and maxs
-        mins.x = std::min(mins.x, x);
-        mins.y = std::min(mins.y, y);
-        mins.z = std::min(mins.z, z);
+    if (jattributesSize % 5 != 0 || !ValidateInterleaved(*vertices, vertexCount, stride, attributes, *indices,
+            indexCount, indexType)) {
+        return false;
+    }
 
-        maxs.x = std::max(maxs.x, x);
-        maxs.y = std::max(maxs.y, y);
-        maxs.z = std::max(maxs.z, z);
+    const int indexSize = indexType == GL_UNSIGNED_INT ? 4 : 2;
+    const MeshKey key = MeshKey("interleaved")
+            .Add(vertices->GetAddress(), static_cast<size_t>(vertexCount) * stride)
+            .Add(indices->GetAddress(), static_cast<size_t>(indexCount) * indexSize)
+            .Add(values.data(), values.size() * sizeof(jint))
+            .Add(stride).Add(indexType)
+            .Counts(vertexCount, indexCount);
+
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    if (mesh->QueueCachedGeometry(key)) {
+        return true;
     }
 
-    env->ReleaseFloatArrayElements(jPositions, jPositionsElements, 0);
+    Vector3f mins;
+    Vector3f maxs;
+    Vector3f center;
+    float radius;
+    if (position != nullptr && ComputeBounds(vertices->GetAddress(), vertexCount, stride, *position,
+            mins, maxs, center, radius)) {
+        mesh->SetBoundingBox(mins, maxs);
+        mesh->SetBoundingSphere(center, radius);
+    }
 
-    // colors
-    jsize jColorsSize = env->GetArrayLength(jColors);
-    jfloat *jColorsElements = env->GetFloatArrayElements(jColors, 0);
+    mesh->QueueGeometry(key, [=](Mesh * mesh) {
+        mesh->SetInterleavedGeometry(vertices->GetAddress(), vertexCount, stride,
+                attributes.data(), attributes.size(),
+                indices->GetAddress(), indexCount, indexType);
+        return true;
+    });
+    return true;
+}
 
-    for (int i = 0; i < jColorsSize; i += 4) {
-        float r = jColorsElements[i];
-        float g = jColorsElements[i + 1];
-        float b = jColorsElements[i + 2];
-        float a = jColorsElements[i + 3];
-        attribs.color.PushBack(Vector4f(r, g, b, a));
+JNIEXPORT jboolean JNICALL
+Java_com_eje_1c_meganekko_Mesh_loadFile(JNIEnv * env, jobject obj, jlong jmesh, jstring jpath) {
+    const char * path = env->GetStringUTFChars(jpath, 0);
+    std::shared_ptr<MeshFile> file = MeshFile::Open(path);
+    if (!file) {
+        env->ReleaseStringUTFChars(jpath, path);
+        return false;
     }
 
-    env->ReleaseFloatArrayElements(jColors, jColorsElements, 0);
+    // A file rewritten under the same path has another size or modification time.
+    const MeshFileHeader & header = file->GetHeader();
+    const MeshKey key = MeshKey("file").Add(path, strlen(path)).Add(header)
+            .Add(file->GetSize()).Add(file->GetModifiedTime())
+            .Counts(header.lods[0].vertexCount, header.lods[0].indexCount);
+    env->ReleaseStringUTFChars(jpath, path);
 
-    // UVs
-    jsize jUVsSize = env->GetArrayLength(jUVs);
-    jfloat *jUVsElements = env->GetFloatArrayElements(jUVs, 0);
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    if (!mesh->QueueCachedGeometry(key)) {
+        mesh->QueueMeshFile(file, key);
+    }
+    return true;
+}
 
-    for (int i = 0; i < jUVsSize; i += 2) {
-        float x = jUVsElements[i];
-        float y = jUVsElements[i + 1];
-        attribs.uv0.PushBack(Vector2f(x, y));
+JNIEXPORT jboolean JNICALL
+Java_com_eje_1c_meganekko_Mesh_loadAsset(JNIEnv * env, jobject obj, jlong jmesh, jobject jassetManager, jstring jpath) {
+    AAssetManager * assets = AAssetManager_fromJava(env, jassetManager);
+    const char * path = env->GetStringUTFChars(jpath, 0);
+    std::shared_ptr<MeshFile> file = MeshFile::Open(assets, path);
+    if (!file) {
+        env->ReleaseStringUTFChars(jpath, path);
+        return false;
     }
 
-    env->ReleaseFloatArrayElements(jUVs, jUVsElements, 0);
+    // Assets have no modification time, so the contents are hashed. They are mapped already.
+    const MeshFileHeader & header = file->GetHeader();
+    const MeshKey key = MeshKey("asset").Add(path, strlen(path)).Add(file->GetData(), file->GetSize())
+            .Counts(header.lods[0].vertexCount, header.lods[0].indexCount);
+    env->ReleaseStringUTFChars(jpath, path);
 
-    // triangles
-    jsize jTrianglesSize = env->GetArrayLength(jTriangles);
-    jint *jTrianglesElements = env->GetIntArrayElements(jTriangles, 0);
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    if (!mesh->QueueCachedGeometry(key)) {
+        mesh->QueueMeshFile(file, key);
+    }
+    return true;
+}
 
-    Array< TriangleIndex > indices;
-    indices.Resize(jTrianglesSize);
+JNIEXPORT jboolean JNICALL
+Java_com_eje_1c_meganekko_Mesh_isUploaded(JNIEnv * env, jobject obj, jlong jmesh) {
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    return mesh->GetSharedGeometry()->IsUploaded();
+}
 
-    for (int i = 0; i < jTrianglesSize; ++i) {
-        indices[i] = jTrianglesElements[i];
-    }
+JNIEXPORT jint JNICALL
+Java_com_eje_1c_meganekko_Mesh_getLodCount(JNIEnv * env, jobject obj, jlong jmesh) {
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    return mesh->GetSharedGeometry()->GetLodCount();
+}
 
-    env->ReleaseIntArrayElements(jTriangles, jTrianglesElements, 0);
+JNIEXPORT jfloat JNICALL
+Java_com_eje_1c_meganekko_Mesh_getAcmr(JNIEnv * env, jobject obj, jlong jmesh, jboolean optimized) {
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    std::shared_ptr<MeshGeometry> geometry = mesh->GetSharedGeometry();
+    return optimized ? geometry->GetAcmrAfter() : geometry->GetAcmrBefore();
+}
 
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(GlGeometry(attribs, indices));
-    mesh->SetBoundingBox(mins, maxs);
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_Mesh_updateQuad(JNIEnv * env, jobject obj, jlong jmesh, jfloat width, jfloat height) {
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    const float x = width * 0.5f;
+    const float y = height * 0.5f;
+    mesh->SetBoundingBox(Vector3f(-x, -y, 0.0f), Vector3f(x, y, 0.0f));
+
+    // Resizing again before the upload only replaces the builder.
+    mesh->QueueGeometry([=](Mesh * mesh) {
+
+        // Same vertices as Mesh.buildQuad() in Java side: position xyz, uv.
+        const float vertices[] = {
+                -x, y, 0.0f, 0.0f, 0.0f,
+                -x, -y, 0.0f, 0.0f, 1.0f,
+                x, y, 0.0f, 1.0f, 0.0f,
+                x, -y, 0.0f, 1.0f, 1.0f
+        };
+        const GLsizei stride = sizeof(float) * 5;
+        if (mesh->UpdateDynamicVertices(vertices, 4, stride)) {
+            return true;
+        }
+
+        static const uint16_t indices[] = { 0, 1, 2, 1, 3, 2 };
+        VertexAttribute attributes[2];
+        attributes[0].location = VERTEX_ATTRIBUTE_LOCATION_POSITION;
+        attributes[0].size = 3;
+        attributes[0].type = GL_FLOAT;
+        attributes[0].normalized = GL_FALSE;
+        attributes[0].offset = 0;
+        attributes[1].location = VERTEX_ATTRIBUTE_LOCATION_UV0;
+        attributes[1].size = 2;
+        attributes[1].type = GL_FLOAT;
+        attributes[1].normalized = GL_FALSE;
+        attributes[1].offset = sizeof(float) * 3;
+        mesh->SetDynamicGeometry(stride, attributes, 2, vertices, 4, indices, 6, GL_UNSIGNED_SHORT);
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildTesselatedQuad(JNIEnv * env, jobject obj, jlong jmesh, jint horizontal, jint vertical, jboolean twoSided) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildTesselatedQuad(horizontal, vertical, twoSided));
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     mesh->SetBoundingBox(Vector3f(-1.0f, -1.0f, 0.0f), Vector3f(1.0f, 1.0f, 0.0f));
+    mesh->QueueGeometry(MeshKey("tesselatedQuad").Add(horizontal).Add(vertical).Add(twoSided), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildTesselatedQuad(horizontal, vertical, twoSided));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildFadedScreenMask(JNIEnv * env, jobject obj, jlong jmesh, jfloat xFraction, jfloat yFraction) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildFadedScreenMask(xFraction, yFraction));
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     mesh->SetBoundingBox(Vector3f(-1.0f, -1.0f, 0.0f), Vector3f(1.0f, 1.0f, 0.0f));
+    mesh->QueueGeometry(MeshKey("fadedScreenMask").Add(xFraction).Add(yFraction), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildFadedScreenMask(xFraction, yFraction));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildVignette(JNIEnv * env, jobject obj, jlong jmesh, jfloat xFraction, jfloat yFraction) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildVignette(xFraction, yFraction));
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     mesh->SetBoundingBox(Vector3f(-1.0f, -1.0f, 0.0f), Vector3f(1.0f, 1.0f, 0.0f));
+    mesh->QueueGeometry(MeshKey("vignette").Add(xFraction).Add(yFraction), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildVignette(xFraction, yFraction));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildTesselatedCylinder(JNIEnv * env, jobject obj, jlong jmesh,
         jfloat radius, jfloat height, jint horizontal, jint vertical, jfloat uScale, jfloat vScale) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildTesselatedCylinder(radius, height, horizontal, vertical, uScale, vScale));
-    mesh->SetBoundingBox(Vector3f(-radius, -radius, -height), Vector3f(radius, radius, height)); // TODO Help! Could you calculate right value?
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    // Circle of radius around Z, from -height to height.
+    mesh->SetBoundingBox(Vector3f(-radius, -radius, -height), Vector3f(radius, radius, height));
+    mesh->SetBoundingSphere(Vector3f(), sqrtf(radius * radius + height * height));
+    const MeshKey key = MeshKey("tesselatedCylinder").Add(radius).Add(height).Add(horizontal).Add(vertical)
+            .Add(uScale).Add(vScale);
+    mesh->QueueGeometry(key, [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildTesselatedCylinder(radius, height, horizontal, vertical, uScale, vScale));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildDome(JNIEnv * env, jobject obj, jlong jmesh, jfloat latRads, jfloat uScale, jfloat vScale) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildDome(latRads, uScale, vScale));
-    mesh->SetBoundingBox(Vector3f(-100, -100, -100), Vector3f(100, 100, 100)); // TODO Help! Could you calculate right value?
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    SetDomeBounds(mesh, latRads);
+    mesh->QueueGeometry(MeshKey("dome").Add(latRads).Add(uScale).Add(vScale), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildDome(latRads, uScale, vScale));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildGlobe(JNIEnv * env, jobject obj, jlong jmesh, jfloat uScale, jfloat vScale) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildGlobe(uScale, vScale));
-    mesh->SetBoundingBox(Vector3f(-100, -100, -100), Vector3f(100, 100, 100)); // TODO Help! Could you calculate right value?
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    const float r = GEOMETRY_SPHERE_RADIUS;
+    mesh->SetBoundingBox(Vector3f(-r, -r, -r), Vector3f(r, r, r));
+    mesh->SetBoundingSphere(Vector3f(), r);
+    mesh->QueueGeometry(MeshKey("globe").Add(uScale).Add(vScale), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildGlobe(uScale, vScale));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildSpherePatch(JNIEnv * env, jobject obj, jlong jmesh, jfloat fov) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildSpherePatch(fov));
-    mesh->SetBoundingBox(Vector3f(-100, -100, -100), Vector3f(100, 100, 100)); // TODO Help! Could you calculate right value?
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
+    SetSpherePatchBounds(mesh, fov);
+    mesh->QueueGeometry(MeshKey("spherePatch").Add(fov), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildSpherePatch(fov));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildCalibrationLines(JNIEnv * env, jobject obj, jlong jmesh, jint extraLines, jboolean fullGrid) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildCalibrationLines(extraLines, fullGrid));
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     mesh->SetBoundingBox(Vector3f(-1.0f, -1.0f, -1.0f), Vector3f(1.0f, 1.0f, 1.0f));
+    mesh->QueueGeometry(MeshKey("calibrationLines").Add(extraLines).Add(fullGrid), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildCalibrationLines(extraLines, fullGrid));
+        return true;
+    });
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Mesh_buildUnitCubeLines(JNIEnv * env, jobject obj, jlong jmesh) {
-    Mesh* mesh = reinterpret_cast<Mesh*>(jmesh);
-    mesh->SetGeometry(BuildUnitCubeLines());
+    Mesh* mesh = FromHandle<Mesh>(jmesh);
     mesh->SetBoundingBox(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.0f, 1.0f, 1.0f));
+    mesh->QueueGeometry(MeshKey("unitCubeLines"), [=](Mesh * mesh) {
+        mesh->SetGeometry(BuildUnitCubeLines());
+        return true;
+    });
 }
 
 #ifdef __cplusplus 
@@ -23,12 +23,17 @@
 #include "Material.h"
 #include "Scene.h"
 #include "RenderData.h"
+#include "util/GpuMemory.h"
 
 using namespace OVR;
 
 namespace mgn {
 
-void Renderer::RenderEyeView(Scene* scene, std::vector<SceneObject*> scene_objects, OESShader* oesShader,
+// About a pixel of the eye buffer in NDC, where the height is 2.
+static const float LOD_SCREEN_ERROR = 0.002f;
+static const float LOD_HYSTERESIS = 0.75f;
+
+void Renderer::RenderEyeView(Scene* scene, RenderSnapshot& snapshot, OESShader* oesShader,
         const Matrix4f &eyeViewMatrix, const Matrix4f &eyeProjectionMatrix, const Matrix4f &eyeViewProjection, const int eye) {
     // there is no need to flat and sort every frame.
     // however let's keep it as is and assume we are not changed
@@ -36,22 +41,28 @@ void Renderer::RenderEyeView(Scene* scene, std::vector<SceneObject*> scene_objec
     // bone/weight/joint and other assimp data, we will put general model conversion
     // on hold and do this kind of conversion fist
 
-    std::vector<RenderData*> render_data_vector;
+    std::vector<DrawItem*> render_data_vector;
 
     // do occlusion culling, if enabled
-    OcclusionCull(scene, scene_objects);
+    OcclusionCull(scene, snapshot);
 
     // do frustum culling, if enabled
-    FrustumCull(scene, eyeViewMatrix.GetTranslation(), scene_objects, render_data_vector,
+    FrustumCull(scene, eyeViewMatrix.GetTranslation(), snapshot, render_data_vector,
             eyeViewProjection, oesShader);
 
+    // pick LODs and texture sizes from projected size
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    SelectLods(render_data_vector, eyeViewMatrix.Inverted().GetTranslation(), eyeProjectionMatrix.M[1][1],
+            static_cast<float>(viewport[3]));
+
     // do sorting based on render order
     if (!scene->GetFrustumCulling()) {
         std::sort(render_data_vector.begin(), render_data_vector.end(),
-                compareRenderData);
+                compareDrawItems);
     } else {
         std::sort(render_data_vector.begin(), render_data_vector.end(),
-                compareRenderDataWithFrustumCulling);
+                compareDrawItemsWithFrustumCulling);
     }
 
     glEnable (GL_DEPTH_TEST);
@@ -70,74 +81,58 @@ void Renderer::RenderEyeView(Scene* scene, std::vector<SceneObject*> scene_objec
 
     for (auto it = render_data_vector.begin();
             it != render_data_vector.end(); ++it) {
-        RenderRenderData(*it, eyeViewMatrix, eyeProjectionMatrix, oesShader, eye);
+        RenderDrawItem(**it, eyeViewMatrix, eyeProjectionMatrix, oesShader, eye);
     }
 
 }
 
-void Renderer::OcclusionCull(Scene* scene, std::vector<SceneObject*> scene_objects) {
+void Renderer::OcclusionCull(Scene* scene, RenderSnapshot& snapshot) {
     if (!scene->GetOcclusionCulling()) {
         return;
     }
 
-    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
-        RenderData* render_data = (*it)->GetRenderData();
-        if (render_data == nullptr) {
-            continue;
-        }
-
-        if (render_data->GetMaterial() == nullptr) {
-            continue;
-        }
+    for (auto item = snapshot.begin(); item != snapshot.end(); ++item) {
+        DrawState* state = item->state;
 
         //If a query was issued on an earlier or same frame and if results are
         //available, then update the same. If results are unavailable, do nothing
-        if (!(*it)->IsQueryIssued()) {
+        if (!state->queryIssued) {
             continue;
         }
 
         GLuint query_result = GL_FALSE;
-        GLuint *query = (*it)->GetOcclusionArray();
-        glGetQueryObjectuiv(query[0], GL_QUERY_RESULT_AVAILABLE, &query_result);
+        GLuint query = state->query;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &query_result);
 
         if (query_result) {
             GLuint pixel_count;
-            glGetQueryObjectuiv(query[0], GL_QUERY_RESULT, &pixel_count);
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &pixel_count);
             bool visibility = ((pixel_count & GL_TRUE) == GL_TRUE);
 
-            (*it)->SetVisible(visibility);
-            (*it)->SetQueryIssued(false);
+            state->SetVisible(visibility);
+            state->queryIssued = false;
         }
     }
 }
 
 void Renderer::FrustumCull(Scene* scene, const Vector3f& camera_position,
-        std::vector<SceneObject*> scene_objects,
-        std::vector<RenderData*>& render_data_vector, const Matrix4f &vp_matrix,
+        RenderSnapshot& snapshot,
+        std::vector<DrawItem*>& render_data_vector, const Matrix4f &vp_matrix,
         OESShader * oesShader) {
-    for (auto it = scene_objects.begin(); it != scene_objects.end(); ++it) {
-        SceneObject *scene_object = (*it);
-        RenderData* render_data = scene_object->GetRenderData();
-        if (render_data == nullptr || render_data->GetMaterial() == nullptr) {
-            continue;
-        }
+    for (auto item = snapshot.begin(); item != snapshot.end(); ++item) {
+        DrawState *state = item->state;
 
         // Check for frustum culling flag
         if (!scene->GetFrustumCulling()) {
             //No occlusion or frustum tests enabled
-            render_data_vector.push_back(render_data);
+            render_data_vector.push_back(&*item);
             continue;
         }
 
         // Frustum culling setup
-        Mesh* currentMesh = render_data->GetMesh();
-        if (currentMesh == nullptr) {
-            continue;
-        }
-
-        BoundingBoxInfo bounding_box_info = currentMesh->GetBoundingBoxInfo();
+        const BoundingBoxInfo & bounding_box_info = item->boundingBox;
 
-        Matrix4f modelMatrixTmp = render_data->GetOwnerObject()->GetMatrixWorld();
+        Matrix4f modelMatrixTmp = item->matrix;
         Matrix4f mvpMatrixTmp(vp_matrix * modelMatrixTmp);
 
         // Frustum
@@ -156,12 +151,12 @@ void Renderer::FrustumCull(Scene* scene, const Vector3f& camera_position,
 
         // Only push those scene objects that are inside of the frustum
         if (!is_inside) {
-            scene_object->SetInFrustum(false);
+            state->inFrustum = false;
             continue;
         }
 
         // Transform the bounding sphere
-        const BoundingSphereInfo sphereInfo = currentMesh->GetBoundingSphereInfo();
+        const BoundingSphereInfo & sphereInfo = item->boundingSphere;
         Vector4f sphere_center(sphereInfo.center, 1.0f);
         Vector4f transformed_sphere_center = mvpMatrixTmp.Transform(sphere_center);
 
@@ -171,28 +166,67 @@ void Renderer::FrustumCull(Scene* scene, const Vector3f& camera_position,
         float distance = difference.Dot(difference);
 
         // this distance will be used when sorting transparent objects
-        render_data->SetCameraDistance(distance);
+        item->cameraDistance = distance;
 
         // Check if this is the correct LOD level
-        if (!scene_object->InLODRange(distance)) {
+        if (!item->InLODRange(distance)) {
             // not in range, don't add it to the list
             continue;
         }
 
-        scene_object->SetInFrustum();
-        bool visible = scene_object->IsVisible();
+        state->inFrustum = true;
+        bool visible = state->visible;
 
         //If visibility flag was set by an earlier occlusion query,
         //turn visibility on for the object
         if (visible) {
-            render_data_vector.push_back(render_data);
+            render_data_vector.push_back(&*item);
         }
+    }
+}
 
-        if (render_data->GetMaterial() == nullptr
-                || !scene->GetOcclusionCulling()) {
-            continue;
-        }
+void Renderer::SelectLods(std::vector<DrawItem*>& render_data_vector, const Vector3f& eye_position,
+        float projection_scale, float viewport_height) {
+    for (auto it = render_data_vector.begin(); it != render_data_vector.end(); ++it) {
+        DrawItem* item = *it;
+        Mesh* mesh = item->mesh;
+
+        const Matrix4f & model_matrix = item->matrix;
+        const BoundingBoxInfo & box = item->boundingBox;
+        const Vector3f extents = box.maxs - box.mins;
+        const float size = std::max(extents.x, std::max(extents.y, extents.z));
+
+        // LOD errors are relative to the mesh size, so the largest axis scale is enough.
+        const float scale = std::max(Vector3f(model_matrix.M[0][0], model_matrix.M[1][0], model_matrix.M[2][0]).Length(),
+                std::max(Vector3f(model_matrix.M[0][1], model_matrix.M[1][1], model_matrix.M[2][1]).Length(),
+                        Vector3f(model_matrix.M[0][2], model_matrix.M[1][2], model_matrix.M[2][2]).Length()));
+
+        const Vector3f center = model_matrix.Transform(item->boundingSphere.center);
+        const float distance = (center - eye_position).Length();
+        const float screen_size = distance > 0.0f ? size * scale * projection_scale / distance : FLT_MAX;
+
+        // The largest side of the texture is mapped on the largest extent of the mesh. Requested to the
+        // material at the next capture.
+        DrawState* state = item->state;
+        state->screenPixels = std::max(state->screenPixels, screen_size * 0.5f * viewport_height);
+
+        // The mesh may have been built again with fewer LODs since the capture.
+        item->lod = mesh->GetLodCount() > 1 ? SelectLod(mesh, item->lod, screen_size) : 0;
+        state->lod = item->lod;
+    }
+}
+
+int Renderer::SelectLod(const Mesh * mesh, int lod, float screenSize) {
+    const int count = mesh->GetLodCount();
+    lod = std::min(lod, count - 1);
+
+    while (lod > 0 && mesh->GetLodError(lod) * screenSize > LOD_SCREEN_ERROR) {
+        lod--;
+    }
+    while (lod + 1 < count && mesh->GetLodError(lod + 1) * screenSize < LOD_SCREEN_ERROR * LOD_HYSTERESIS) {
+        lod++;
     }
+    return lod;
 }
 
 void Renderer::BuildFrustum(float frustum[6][4], float mvp_matrix[16]) {
@@ -322,38 +356,37 @@ bool Renderer::IsCubeInFrustum(float frustum[6][4], const BoundingBoxInfo & vert
     return true;
 }
 
-void Renderer::RenderRenderData(RenderData* renderData,
+void Renderer::RenderDrawItem(const DrawItem& item,
         const Matrix4f& view_matrix, const Matrix4f& projection_matrix,
         OESShader * oesShader, const int eye) {
 
-    if (!renderData->IsVisible()) return;
-
-    Mesh * mesh = renderData->GetMesh();
-    if (mesh == nullptr) return;
-
-    Material* material = renderData->GetMaterial();
-    if (material == nullptr) return;
+    Mesh * mesh = item.mesh;
+    if (!mesh->IsUploaded()) {
+        // Evicted meshes are built again when they are needed.
+        mesh->Restore();
+        return;
+    }
 
-    if (renderData->GetOffset()) {
+    if (item.offset) {
         glEnable (GL_POLYGON_OFFSET_FILL);
-        glPolygonOffset(renderData->GetOffsetFactor(), renderData->GetOffsetUnits());
+        glPolygonOffset(item.offsetFactor, item.offsetUnits);
     }
 
-    if (!renderData->GetDepthTest()) {
+    if (!item.depthTest) {
         glDisable (GL_DEPTH_TEST);
     }
 
-    if (!renderData->GetAlphaBlend()) {
+    if (!item.alphaBlend) {
         glDisable (GL_BLEND);
     }
 
-    SetFaceCulling(material->GetSide());
+    SetFaceCulling(item.side);
 
-    Matrix4f model_matrix = renderData->GetOwnerObject()->GetMatrixWorld();
-    Matrix4f mv_matrix(view_matrix * model_matrix);
+    Matrix4f mv_matrix(view_matrix * item.matrix);
     Matrix4f mvp_matrix = projection_matrix * mv_matrix;
     try {
-        oesShader->Render(mvp_matrix, mesh->GetGeometry(), material, eye);
+        oesShader->Render(mvp_matrix, item, eye);
+        gpu_memory.Touch(mesh);
     } catch (std::string error) {
         __android_log_print(ANDROID_LOG_ERROR, "mgn", "Error detected in Renderer::renderRenderData; error : %s", error.c_str());
     }
@@ -361,20 +394,20 @@ void Renderer::RenderRenderData(RenderData* renderData,
     // Restoring to Default.
     // TODO: There's a lot of redundant state changes. If on every render face culling is being set there's no need to
     // restore defaults. Possibly later we could add a OpenGL state wrapper to avoid redundant api calls.
-    if (renderData->GetMaterial()->GetSide() != Material::FrontSide) {
+    if (item.side != Material::FrontSide) {
         glEnable (GL_CULL_FACE);
         glCullFace (GL_BACK);
     }
 
-    if (renderData->GetOffset()) {
+    if (item.offset) {
         glDisable (GL_POLYGON_OFFSET_FILL);
     }
 
-    if (!renderData->GetDepthTest()) {
+    if (!item.depthTest) {
         glEnable (GL_DEPTH_TEST);
     }
 
-    if (!renderData->GetAlphaBlend()) {
+    if (!item.alphaBlend) {
         glEnable (GL_BLEND);
     }
 }
@@ -24,6 +24,7 @@
 #include "util/GL.h"
 #include "mesh.h"
 #include "OESShader.h"
+#include "RenderSnapshot.h"
 
 namespace mgn
 {
@@ -40,7 +41,7 @@ private:
 
 public:
 
-    static void RenderEyeView(Scene* scene, std::vector<SceneObject*>,
+    static void RenderEyeView(Scene* scene, RenderSnapshot& snapshot,
             OESShader * oesShader,
             const OVR::Matrix4f &eyeViewMatrix,
             const OVR::Matrix4f &eyeProjectionMatrix,
@@ -48,16 +49,22 @@ public:
             const int eye);
 
 private:
-    static void RenderRenderData(RenderData* renderData,
+    static void RenderDrawItem(const DrawItem& item,
             const OVR::Matrix4f& viewMatrix,
             const OVR::Matrix4f& projectionMatrix,
             OESShader * oesShader, const int eye);
 
-    static void OcclusionCull(Scene* scene, std::vector<SceneObject*> sceneObjects);
+    static void OcclusionCull(Scene* scene, RenderSnapshot& snapshot);
     static void FrustumCull(Scene* scene, const OVR::Vector3f& cameraPosition,
-            std::vector<SceneObject*> sceneObjects,
-            std::vector<RenderData*>& renderDataVector, const OVR::Matrix4f &vpMatrix,
+            RenderSnapshot& snapshot,
+            std::vector<DrawItem*>& renderDataVector, const OVR::Matrix4f &vpMatrix,
             OESShader * oesShader);
+    static void SelectLods(std::vector<DrawItem*>& renderDataVector, const OVR::Vector3f& eyePosition,
+            float projectionScale, float viewportHeight);
+    // Picks the coarsest LOD whose error projects below LOD_SCREEN_ERROR, starting from lod. screenSize is
+    // the projected size of the mesh in normalized device coordinates. A coarser LOD is taken only when it
+    // is clearly good enough, so that the level doesn't flicker around a threshold.
+    static int SelectLod(const Mesh * mesh, int lod, float screenSize);
     static void BuildFrustum(float frustum[6][4], float mvpMatrix[16]);
     static bool IsCubeInFrustum(float frustum[6][4], const BoundingBoxInfo & vertexLimit);
 
@@ -22,37 +22,122 @@
 
 #include "SceneObject.h"
 #include "RenderData.h"
+#include "util/GlDelete.h"
 
 namespace mgn {
     Scene::Scene() : SceneObject(),
         frustumFlag(false),
-        occlusionFlag(false) {
-    oesShader = new OESShader();
+        occlusionFlag(false),
+        oesShader(nullptr),
+        frontSnapshot(0),
+        captureCount(0),
+        tickCount(0),
+        tickInterpolation(false),
+        tickAlpha(1.0f) {
 }
 
 Scene::~Scene() {
     delete oesShader;
+    for (auto & entry : drawStates) {
+        gl_delete.queueQuery(entry.second.query);
+    }
 }
 
 std::vector<SceneObject*> Scene::GetWholeSceneObjects() {
-    std::vector<SceneObject*> sceneObjects(GetChildren());
-    for (int i = 0; i < sceneObjects.size(); ++i) {
-        std::vector<SceneObject*> children(sceneObjects[i]->GetChildren());
-        for (auto it = children.begin(); it != children.end(); ++it) {
-            sceneObjects.push_back(*it);
+    std::vector<SceneObject*> sceneObjects;
+    CollectShownObjects(sceneObjects);
+    return sceneObjects;
+}
+
+void Scene::PrepareForRendering() {
+    if (!tickInterpolation) {
+        CaptureSnapshot();
+        return;
+    }
+
+    for (DrawItem & item : snapshots[frontSnapshot]) {
+        item.matrix = InterpolateMatrix(item.matrixPrevious, item.matrixCurrent, tickAlpha);
+    }
+}
+
+void Scene::CaptureSnapshot() {
+    sceneObjects.clear();
+    CollectShownObjects(sceneObjects);
+
+    captureCount++;
+    RenderSnapshot & snapshot = snapshots[1 - frontSnapshot];
+    snapshot.clear();
+    for (SceneObject * object : sceneObjects) {
+        // World matrices in transform_store are read by Java until the next capture.
+        const Matrix4f & matrixWorld = object->GetMatrixWorld();
+        if (tickInterpolation && object->tick != 0) {
+            CaptureDrawItem(object, object->tickPrevious, object->tickCurrent, drawStates, captureCount, snapshot);
+        } else {
+            CaptureDrawItem(object, matrixWorld, matrixWorld, drawStates, captureCount, snapshot);
         }
     }
+    frontSnapshot = 1 - frontSnapshot;
+
+    // States of objects which are no longer drawn. The back snapshot which points to them isn't rendered.
+    for (auto it = drawStates.begin(); it != drawStates.end();) {
+        if (it->second.capture != captureCount) {
+            gl_delete.queueQuery(it->second.query);
+            it = drawStates.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
 
-    return sceneObjects;
+void Scene::CommitTick(bool advance) {
+    if (advance) {
+        tickCount++;
+    }
+
+    // Hidden objects too, so that they have both ticks when they are shown.
+    tickObjects.clear();
+    tickObjects.insert(tickObjects.end(), GetChildren().begin(), GetChildren().end());
+    for (size_t i = 0; i < tickObjects.size(); ++i) {
+        SceneObject * object = tickObjects[i];
+        if (advance || object->tick == 0) {
+            object->CommitTick(tickCount);
+        }
+        tickObjects.insert(tickObjects.end(), object->GetChildren().begin(), object->GetChildren().end());
+    }
+
+    CaptureSnapshot();
 }
 
-void Scene::PrepareForRendering() {
-    sceneObjects = GetWholeSceneObjects();
+void Scene::CollectShownObjects(std::vector<SceneObject*> & objects) {
+    worldOpacity = IsHidden() ? 0.0f : GetOpacity();
+    if (worldOpacity <= 0.0f) {
+        return;
+    }
+
+    // Breadth first, so that parents are resolved before their children. Hidden or fully transparent
+    // subtrees are skipped with all their descendants.
+    objects.push_back(this);
+    for (size_t i = 0; i < objects.size(); ++i) {
+        SceneObject * parent = objects[i];
+        for (SceneObject * child : parent->GetChildren()) {
+            child->worldOpacity = child->hidden ? 0.0f : parent->worldOpacity * child->opacity;
+            if (child->worldOpacity > 0.0f) {
+                objects.push_back(child);
+            }
+        }
+    }
+    objects.erase(objects.begin());
 }
 
 Matrix4f Scene::Render(const int eye) {
     const Matrix4f viewProjectionM = projectionM * viewM;
-    Renderer::RenderEyeView(this, sceneObjects, oesShader, viewM, projectionM, viewProjectionM, eye);
+
+    // The shader is built on the GL thread, so that a scene can be created on any thread.
+    if (oesShader == nullptr) {
+        oesShader = new OESShader();
+    }
+
+    Renderer::RenderEyeView(this, snapshots[frontSnapshot], oesShader, viewM, projectionM, viewProjectionM, eye);
     return viewProjectionM;
 }
 
@@ -65,7 +150,7 @@ IntersectRayBoundsResult Scene::IntersectRayBounds(SceneObject *target, bool axi
 
     const Vector3f rayStart = worldToModelM.Transform(inWorldCenterViewPos);
     const Vector3f rayDir = worldToModelM.Transform(centerViewRot.Rotate(Vector3f(0.0f, 0.0f, -1.0f))) - rayStart;
-    const BoundingBoxInfo boundingBoxInfo = target->GetRenderData()->GetMesh()->GetBoundingBoxInfo();
+    const BoundingBoxInfo boundingBoxInfo = target->GetRenderData()->GetMesh()->CopyBoundingBoxInfo();
     float t0 = 0.0f;
     float t1 = 0.0f;
 
@@ -24,6 +24,7 @@
 
 #include "SceneObject.h"
 #include "Renderer.h"
+#include "RenderSnapshot.h"
 
 using namespace OVR;
 
@@ -79,8 +80,25 @@ public:
         projectionM = m;
     }
 
+    // Captures a snapshot unless ticks do, and sets matrices of the snapshot for this frame.
     void PrepareForRendering();
 
+    // Takes the world matrices of all objects as a fixed rate tick, and captures a snapshot of them.
+    // If advance is false, only objects which have never been in a tick are taken, so that objects
+    // added between ticks can be rendered.
+    void CommitTick(bool advance);
+
+    // While enabled, objects are rendered at alpha between the last two ticks instead of their current
+    // world matrices, which Java may be writing on the simulation thread.
+    void SetTickInterpolation(bool enabled, float alpha) {
+        tickInterpolation = enabled;
+        tickAlpha = alpha;
+    }
+
+    bool IsTickInterpolated() const {
+        return tickInterpolation;
+    }
+
     Matrix4f Render(const int eye);
 
     IntersectRayBoundsResult IntersectRayBounds(SceneObject * target, bool axisInWorld);
@@ -103,6 +121,13 @@ private:
     Scene& operator=(const Scene& scene);
     Scene& operator=(Scene&& scene);
 
+    // Resolves world opacity of the objects, and collects those to be rendered.
+    void CollectShownObjects(std::vector<SceneObject*> & objects);
+
+    // Copies draw state of shown objects into the back snapshot, and makes it the front one. Rendering
+    // reads only the front snapshot, so updates can change objects until the next capture.
+    void CaptureSnapshot();
+
 private:
     OESShader* oesShader;
 
@@ -110,7 +135,16 @@ private:
     Matrix4f centerViewM;
     Matrix4f viewM;
     Matrix4f projectionM;
-    std::vector<SceneObject*> sceneObjects; // will be rendererd
+    std::vector<SceneObject*> sceneObjects;
+    std::vector<SceneObject*> tickObjects;
+    RenderSnapshot snapshots[2];
+    int frontSnapshot;
+    DrawStates drawStates; // Of objects in the front snapshot.
+    uint32_t captureCount;
+
+    uint32_t tickCount;
+    bool     tickInterpolation;
+    float    tickAlpha;
 
     bool frustumFlag;
     bool occlusionFlag;
@@ -14,8 +14,10 @@
  */
 
 #include "includes.h"
+#include "AnimationSystem.h"
 #include "Scene.h"
 #include "util/convert.h"
+#include "util/HandleTable.h"
 
 namespace mgn {
 #ifdef __cplusplus
@@ -24,40 +26,56 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL
 Java_com_eje_1c_meganekko_Scene_initNativeInstance(JNIEnv * env, jobject obj) {
-    return reinterpret_cast<jlong>(new Scene());
+    return NewHandle(new Scene());
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_setFrustumCulling(JNIEnv * env, jobject obj, jlong jscene, jboolean flag) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     scene->SetFrustumCulling(static_cast<bool>(flag));
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_setOcclusionQuery(JNIEnv * env, jobject obj, jlong jscene, jboolean flag) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     scene->SetOcclusionCulling(static_cast<bool>(flag));
 }
 
+// Called on the GL thread while the simulation thread is waiting.
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_Scene_commitTick(JNIEnv * env, jobject obj, jlong jscene, jdouble time, jboolean advance) {
+    Scene* scene = FromHandle<Scene>(jscene);
+    if (advance) {
+        animation_system.Update(time);
+    }
+    scene->CommitTick(advance);
+}
+
+JNIEXPORT void JNICALL
+Java_com_eje_1c_meganekko_Scene_setTickInterpolation(JNIEnv * env, jobject obj, jlong jscene, jboolean enabled, jfloat alpha) {
+    Scene* scene = FromHandle<Scene>(jscene);
+    scene->SetTickInterpolation(enabled, alpha);
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_eje_1c_meganekko_Scene_isLookingAt(JNIEnv * env, jobject obj, jlong jscene, jlong jsceneObject) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    Scene* scene = FromHandle<Scene>(jscene);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     IntersectRayBoundsResult result = scene->IntersectRayBounds(sceneObject, false);
     return result.intersected;
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_getLookingPoint(JNIEnv * env, jobject obj, jlong jscene, jlong jsceneObject, jboolean axisInWorld, jfloatArray values) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
-    SceneObject* sceneObject = reinterpret_cast<SceneObject*>(jsceneObject);
+    Scene* scene = FromHandle<Scene>(jscene);
+    SceneObject* sceneObject = FromHandle<SceneObject>(jsceneObject);
     IntersectRayBoundsResult result = scene->IntersectRayBounds(sceneObject, axisInWorld);
     FillElementsUnSafe(env, values, result.first);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_setViewMatrix(JNIEnv * jni, jobject obj, jlong jscene, jfloatArray jarray) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     jfloat tmp[16];
     jni->GetFloatArrayRegion(jarray, 0, 16, tmp);
 
@@ -71,7 +89,7 @@ Java_com_eje_1c_meganekko_Scene_setViewMatrix(JNIEnv * jni, jobject obj, jlong j
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_setProjectionMatrix(JNIEnv * jni, jobject obj, jlong jscene, jfloatArray jarray) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     jfloat tmp[16];
     jni->GetFloatArrayRegion(jarray, 0, 16, tmp);
 
@@ -85,26 +103,26 @@ Java_com_eje_1c_meganekko_Scene_setProjectionMatrix(JNIEnv * jni, jobject obj, j
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_render(JNIEnv * jni, jobject obj, jlong jscene, jint eye) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     scene->Render(eye);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_setViewPosition(JNIEnv * jni, jobject obj, jlong jscene, jfloat x, jfloat y, jfloat z) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     scene->SetViewPosition(Vector3f(x, y, z));
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_getViewPosition(JNIEnv * jni, jobject obj, jlong jscene, jfloatArray values) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     Vector3f pos = scene->GetViewPosition();
     FillElementsUnSafe(jni, values, pos);
 }
 
 JNIEXPORT void JNICALL
 Java_com_eje_1c_meganekko_Scene_getViewOrientation(JNIEnv * jni, jobject obj, jlong jscene, jfloatArray values) {
-    Scene* scene = reinterpret_cast<Scene*>(jscene);
+    Scene* scene = FromHandle<Scene>(jscene);
     Quatf orientation = Quatf(scene->GetCenterViewMatrix().InvertedHomogeneousTransform());
     FillElementsUnSafe(jni, values, orientation);
 }
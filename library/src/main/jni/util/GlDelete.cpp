@@ -20,112 +20,151 @@ namespace mgn {
 
 GlDelete gl_delete;
 
-void GlDelete::queueBuffer(GLuint buffer) {
-    lock();
-    buffers_.push_back(buffer);
-//    LOGD("queueBuffer(%d) buffers_.size() = %d", buffer, buffers_.size());
-    dirty = true;
-    unlock();
+GlDelete::~GlDelete() {
+    // The GL context is gone at this point. Only the requests are freed.
+    for (size_t i = 0; i < inFlight.size(); ++i) {
+        Request * request = inFlight[i].requests;
+        while (request != nullptr) {
+            Request * next = request->next;
+            delete request;
+            request = next;
+        }
+    }
+
+    Request * request = head.exchange(nullptr);
+    while (request != nullptr) {
+        Request * next = request->next;
+        delete request;
+        request = next;
+    }
+}
+
+void GlDelete::queueBuffer(GLuint buffer, size_t bytes) {
+    queue(BUFFER, buffer, bytes);
 }
 
 void GlDelete::queueFrameBuffer(GLuint buffer) {
-    lock();
-    frame_buffers_.push_back(buffer);
-//    LOGD("queueFrameBuffer(%d) frame_buffers_.size() = %d", buffer,
-//            frame_buffers_.size());
-    dirty = true;
-    unlock();
+    queue(FRAME_BUFFER, buffer, 0);
 }
 
-void GlDelete::queueProgram(GLuint program) {
-    lock();
-    programs_.push_back(program);
-//    LOGD("queueProgram(%d) programs_.size() = %d", program, programs_.size());
-    dirty = true;
-    unlock();
+void GlDelete::queueProgram(GLuint program, size_t bytes) {
+    queue(PROGRAM, program, bytes);
 }
 
-void GlDelete::queueRenderBuffer(GLuint buffer) {
-    lock();
-    render_buffers_.push_back(buffer);
-//    LOGD("queueRenderBuffer(%d) render_buffers_.size() = %d", buffer,
-//            render_buffers_.size());
-    dirty = true;
-    unlock();
+void GlDelete::queueQuery(GLuint query) {
+    queue(QUERY, query, 0);
+}
+
+void GlDelete::queueRenderBuffer(GLuint buffer, size_t bytes) {
+    queue(RENDER_BUFFER, buffer, bytes);
 }
 
 void GlDelete::queueShader(GLuint shader) {
-    lock();
-    shaders_.push_back(shader);
-//    LOGD("queueShader(%d) shaders_.size() = %d", shader, shaders_.size());
-    dirty = true;
-    unlock();
+    queue(SHADER, shader, 0);
 }
 
-void GlDelete::queueTexture(GLuint texture) {
-    lock();
-    textures_.push_back(texture);
-//    LOGD("queueTexture(%d) textures_.size() = %d", texture, textures_.size());
-    dirty = true;
-    unlock();
+void GlDelete::queueTexture(GLuint texture, size_t bytes) {
+    queue(TEXTURE, texture, bytes);
 }
 
 void GlDelete::queueVertexArray(GLuint vertex_array) {
-    lock();
-    vertex_arrays_.push_back(vertex_array);
-//    LOGD("queueVertexArray(%d) vertex_arrays_.size() = %d", vertex_array,
-//            vertex_arrays_.size());
-    dirty = true;
-    unlock();
+    queue(VERTEX_ARRAY, vertex_array, 0);
+}
+
+void GlDelete::queue(Type type, GLuint name, size_t bytes) {
+    if (name == 0) {
+        return;
+    }
+
+    Request * request = new Request();
+    request->name = name;
+    request->type = type;
+    request->bytes = bytes;
+
+    pendingCount.fetch_add(1, std::memory_order_relaxed);
+    pendingBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    request->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(request->next, request,
+            std::memory_order_release, std::memory_order_relaxed)) {
+    }
 }
 
 void GlDelete::processQueues() {
-    /*
-     * Do an unsynchronized check of the dirty flag, so that we don't have to
-     * call lock() on each and every frame. The consequences of 'just missing'
-     * a queue op and leaving a handle on a queue for an extra frame are quite
-     * minimal, but locking every frame is not free.
-     */
-    if (dirty) {
-        lock();
-//    LOGD("GlDelete::processQueues()");
-        if (buffers_.size() > 0) {
-            glDeleteBuffers(buffers_.size(), buffers_.data());
-            buffers_.clear();
-        }
-        if (frame_buffers_.size() > 0) {
-            glDeleteFramebuffers(frame_buffers_.size(), frame_buffers_.data());
-            frame_buffers_.clear();
-        }
-        if (programs_.size() > 0) {
-            for (int index = 0, size = programs_.size(); index < size;
-                    ++index) {
-                glDeleteProgram(programs_[index]);
-            }
-            programs_.clear();
-        }
-        if (render_buffers_.size() > 0) {
-            glDeleteRenderbuffers(render_buffers_.size(),
-                    render_buffers_.data());
-            render_buffers_.clear();
-        }
-        if (shaders_.size() > 0) {
-            for (int index = 0, size = shaders_.size(); index < size; ++index) {
-                glDeleteShader(shaders_[index]);
+
+    // Fences are signaled in order, so stop at the first one which is still pending.
+    while (!inFlight.empty()) {
+        FrameBatch & batch = inFlight.front();
+        if (batch.fence != 0) {
+            const GLenum status = glClientWaitSync(batch.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                break;
             }
-            shaders_.clear();
+            glDeleteSync(batch.fence);
         }
-        if (textures_.size() > 0) {
-            glDeleteTextures(textures_.size(), textures_.data());
-            textures_.clear();
-        }
-        if (vertex_arrays_.size() > 0) {
-            glDeleteVertexArrays(vertex_arrays_.size(), vertex_arrays_.data());
-            vertex_arrays_.clear();
-        }
-        dirty = false;
-        unlock();
+        release(batch.requests);
+        inFlight.pop_front();
+    }
+
+    /*
+     * Everything queued so far was last used by commands issued before this
+     * point, so a fence inserted now guards the whole batch.
+     */
+    Request * requests = head.exchange(nullptr, std::memory_order_acquire);
+    if (requests != nullptr) {
+        FrameBatch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batch.requests = requests;
+        inFlight.push_back(batch);
+    }
+}
+
+void GlDelete::release(Request * requests) {
+    size_t count = 0;
+    size_t bytes = 0;
+
+    while (requests != nullptr) {
+        Request * next = requests->next;
+        names[requests->type].push_back(requests->name);
+        count++;
+        bytes += requests->bytes;
+        delete requests;
+        requests = next;
+    }
+
+//    LOGD("GlDelete::release() %d objects, %d bytes", count, bytes);
+    if (names[BUFFER].size() > 0) {
+        glDeleteBuffers(names[BUFFER].size(), names[BUFFER].data());
+    }
+    if (names[FRAME_BUFFER].size() > 0) {
+        glDeleteFramebuffers(names[FRAME_BUFFER].size(), names[FRAME_BUFFER].data());
+    }
+    for (size_t index = 0; index < names[PROGRAM].size(); ++index) {
+        glDeleteProgram(names[PROGRAM][index]);
+    }
+    if (names[QUERY].size() > 0) {
+        glDeleteQueries(names[QUERY].size(), names[QUERY].data());
+    }
+    if (names[RENDER_BUFFER].size() > 0) {
+        glDeleteRenderbuffers(names[RENDER_BUFFER].size(), names[RENDER_BUFFER].data());
+    }
+    for (size_t index = 0; index < names[SHADER].size(); ++index) {
+        glDeleteShader(names[SHADER][index]);
     }
+    if (names[TEXTURE].size() > 0) {
+        glDeleteTextures(names[TEXTURE].size(), names[TEXTURE].data());
+    }
+    if (names[VERTEX_ARRAY].size() > 0) {
+        glDeleteVertexArrays(names[VERTEX_ARRAY].size(), names[VERTEX_ARRAY].data());
+    }
+
+    // Vectors keep their capacity for the next batch.
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        names[type].clear();
+    }
+
+    pendingCount.fetch_sub(count, std::memory_order_relaxed);
+    pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
 }
 
 }
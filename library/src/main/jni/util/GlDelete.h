@@ -18,47 +18,84 @@
 #ifndef GL_DELETE_H_
 #define GL_DELETE_H_
 
+#include <atomic>
+#include <deque>
+
 namespace mgn {
+
+/**
+ * Deletes GL objects on the GL thread. queue*() can be called from any thread
+ * without locking. processQueues() collects the requests once per frame and
+ * puts a fence behind them; the objects are deleted when the GPU has passed
+ * that fence, so nothing in flight can still reference them.
+ */
 class GlDelete {
 
 public:
-    GlDelete() {
-        pthread_mutex_init(&mutex, 0);
+    GlDelete() :
+            head(nullptr),
+            pendingCount(0),
+            pendingBytes(0) {
     }
 
-    ~GlDelete() {
-        pthread_mutex_destroy(&mutex);
-    }
+    ~GlDelete();
 
-    void queueBuffer(GLuint buffer);
+    void queueBuffer(GLuint buffer, size_t bytes = 0);
     void queueFrameBuffer(GLuint buffer);
-    void queueProgram(GLuint program);
-    void queueRenderBuffer(GLuint buffer);
+    void queueProgram(GLuint program, size_t bytes = 0);
+    void queueQuery(GLuint query);
+    void queueRenderBuffer(GLuint buffer, size_t bytes = 0);
     void queueShader(GLuint shader);
-    void queueTexture(GLuint texture);
+    void queueTexture(GLuint texture, size_t bytes = 0);
     void queueVertexArray(GLuint vertex_array);
 
+    // Must be called on the GL thread once per frame.
     void processQueues();
 
+    size_t getPendingCount() const {
+        return pendingCount.load(std::memory_order_relaxed);
+    }
+
+    size_t getPendingBytes() const {
+        return pendingBytes.load(std::memory_order_relaxed);
+    }
+
 private:
+    enum Type {
+        BUFFER = 0,
+        FRAME_BUFFER,
+        PROGRAM,
+        QUERY,
+        RENDER_BUFFER,
+        SHADER,
+        TEXTURE,
+        VERTEX_ARRAY,
+        TYPE_COUNT
+    };
 
-    pthread_mutex_t mutex;
-    bool dirty = false;
+    struct Request {
+        Request * next;
+        GLuint name;
+        Type type;
+        size_t bytes;
+    };
 
-    void lock() {
-        pthread_mutex_lock(&mutex);
-    }
-    void unlock() {
-        pthread_mutex_unlock(&mutex);
-    }
+    struct FrameBatch {
+        GLsync fence;
+        Request * requests;
+    };
+
+    void queue(Type type, GLuint name, size_t bytes);
+    void release(Request * requests);
+
+    // Multiple producers push, the GL thread takes the whole list at once.
+    std::atomic<Request*> head;
+    std::atomic<size_t> pendingCount;
+    std::atomic<size_t> pendingBytes;
 
-    std::vector<GLuint> buffers_;
-    std::vector<GLuint> frame_buffers_;
-    std::vector<GLuint> programs_;
-    std::vector<GLuint> render_buffers_;
-    std::vector<GLuint> shaders_;
-    std::vector<GLuint> textures_;
-    std::vector<GLuint> vertex_arrays_;
+    // Owned by the GL thread
+    std::deque<FrameBatch> inFlight;
+    std::vector<GLuint> names[TYPE_COUNT];
 };
 
 extern GlDelete gl_delete;
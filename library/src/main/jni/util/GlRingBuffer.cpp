@@ -0,0 +1,113 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GlRingBuffer.h"
+#include "GlDelete.h"
+#include "GpuMemory.h"
+
+namespace mgn {
+
+GlRingBuffer gl_ring;
+
+// Waits are done in slices, so that GL_SYNC_FLUSH_COMMANDS_BIT is sent once and failures don't hang.
+static const GLuint64 WAIT_NANOS = 1000000;
+
+void GlRingBuffer::BeginFrame() {
+    if (buffer == 0) {
+        Grow(INITIAL_REGION_SIZE);
+    } else {
+        // Commands reading the region were all issued before this point.
+        fences[frame] = used > 0 ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : 0;
+        frame = (frame + 1) % FRAME_COUNT;
+
+        // Passed already unless the GPU is FRAME_COUNT - 1 frames behind.
+        GLsync fence = fences[frame];
+        if (fence != 0) {
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                stallCount++;
+                do {
+                    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_NANOS);
+                } while (status == GL_TIMEOUT_EXPIRED);
+            }
+            glDeleteSync(fence);
+            fences[frame] = 0;
+        }
+    }
+
+    used = 0;
+    frameNumber++;
+}
+
+bool GlRingBuffer::Write(const void * data, size_t bytes, size_t alignment, GLintptr & offset) {
+    size_t start = (used + alignment - 1) / alignment * alignment;
+    if (buffer == 0 || start + bytes > regionSize) {
+        Grow(start + bytes);
+        start = 0;
+    }
+
+    offset = static_cast<GLintptr>(frame * regionSize + start);
+
+    // The GPU is done with the region, so nothing has to be synchronized.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    void * mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "GlRingBuffer: glMapBufferRange failed for %zu bytes", bytes);
+        return false;
+    }
+    memcpy(mapped, data, bytes);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    used = start + bytes;
+    return true;
+}
+
+void GlRingBuffer::Grow(size_t minRegionSize) {
+    size_t size = regionSize > 0 ? regionSize * 2 : INITIAL_REGION_SIZE;
+    while (size < minRegionSize) {
+        size *= 2;
+    }
+
+    // Data written to the old buffer in this frame stays valid until gl_delete frees it.
+    gl_delete.queueBuffer(buffer, regionSize * FRAME_COUNT);
+    gpu_memory.Free(GPU_MEMORY_BUFFER, regionSize * FRAME_COUNT);
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        if (fences[i] != 0) {
+            glDeleteSync(fences[i]);
+            fences[i] = 0;
+        }
+    }
+
+    if (uniformAlignment == 0) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        uniformAlignment = alignment > 0 ? alignment : 256;
+    }
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size * FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    gpu_memory.Allocate(GPU_MEMORY_BUFFER, size * FRAME_COUNT);
+
+    regionSize = size;
+    used = 0;
+}
+
+}
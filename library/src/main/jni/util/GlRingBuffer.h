@@ -0,0 +1,104 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Streams per-frame data to the GPU.
+ ***************************************************************************/
+
+#ifndef GL_RING_BUFFER_H_
+#define GL_RING_BUFFER_H_
+
+namespace mgn {
+
+/**
+ * One GL buffer split in FRAME_COUNT regions, used in turn by frames. Data
+ * is written with unsynchronized maps into the region of the current frame,
+ * which the GPU no longer reads: a fence is put behind each frame, and a
+ * region is reused only after the fence of its last frame has passed. So
+ * writes never reallocate nor wait for the GPU in the normal case.
+ *
+ * Everything must be called on the GL thread. Data lives until the end of
+ * the frame it was written in, so dynamic data is written again every frame.
+ */
+class GlRingBuffer {
+public:
+    static const int FRAME_COUNT = 3;
+
+    GlRingBuffer() :
+            buffer(0),
+            regionSize(0),
+            frame(0),
+            used(0),
+            frameNumber(0),
+            uniformAlignment(0),
+            stallCount(0) {
+        for (int i = 0; i < FRAME_COUNT; ++i) {
+            fences[i] = 0;
+        }
+    }
+
+    // Must be called once per frame, before anything is written or drawn.
+    void BeginFrame();
+
+    // Copies bytes into the current region, and returns the offset in GetBuffer().
+    // The region grows if it is full, so this fails only if mapping fails.
+    bool Write(const void * data, size_t bytes, size_t alignment, GLintptr & offset);
+
+    // Can change when the ring grows, so it is taken after Write().
+    GLuint GetBuffer() const {
+        return buffer;
+    }
+
+    // Alignment for glBindBufferRange(GL_UNIFORM_BUFFER, ...).
+    size_t GetUniformAlignment() const {
+        return uniformAlignment;
+    }
+
+    // Counts up in BeginFrame(). Tells whether data was already written in this frame.
+    uint32_t GetFrameNumber() const {
+        return frameNumber;
+    }
+
+    // Frames which had to wait for the GPU to finish a region.
+    uint32_t GetStallCount() const {
+        return stallCount;
+    }
+
+private:
+    GlRingBuffer(const GlRingBuffer& ring);
+    GlRingBuffer& operator=(const GlRingBuffer& ring);
+
+    static const size_t INITIAL_REGION_SIZE = 64 * 1024;
+
+    // Makes a new buffer. The old one is deleted through gl_delete after the frames using it.
+    void Grow(size_t minRegionSize);
+
+    GLuint buffer;
+    size_t regionSize;
+    int frame;
+    size_t used;
+    GLsync fences[FRAME_COUNT];
+    uint32_t frameNumber;
+    size_t uniformAlignment;
+    uint32_t stallCount;
+};
+
+extern GlRingBuffer gl_ring;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GlUpload.h"
+#include "Mesh.h"
+
+namespace mgn {
+
+GlUpload gl_upload;
+
+void GlUpload::queue(Mesh * mesh, const Builder & builder) {
+    lock();
+    auto it = builders.find(mesh);
+    if (it != builders.end()) {
+        it->second = builder;
+    } else {
+        builders.insert(std::make_pair(mesh, builder));
+        order.push_back(mesh);
+    }
+    unlock();
+}
+
+void GlUpload::cancel(Mesh * mesh) {
+    lock();
+    builders.erase(mesh);
+    unlock();
+}
+
+void GlUpload::processQueues(double budgetSeconds) {
+    const double deadline = vrapi_GetTimeInSeconds() + budgetSeconds;
+    std::vector<std::pair<Mesh*, Builder> > notReady;
+
+    do {
+        lock();
+        Mesh * mesh = nullptr;
+        Builder builder;
+        while (!order.empty() && mesh == nullptr) {
+            auto it = builders.find(order.front());
+            if (it != builders.end()) {
+                mesh = it->first;
+                builder.swap(it->second);
+                builders.erase(it);
+            }
+            order.pop_front();
+        }
+        unlock();
+
+        if (mesh == nullptr) {
+            break;
+        }
+
+        if (!builder(mesh)) {
+            notReady.push_back(std::make_pair(mesh, builder));
+        }
+
+    } while (vrapi_GetTimeInSeconds() < deadline);
+
+    if (notReady.empty()) {
+        return;
+    }
+
+    // Put back unless a newer builder was queued meanwhile.
+    lock();
+    for (size_t i = 0; i < notReady.size(); ++i) {
+        if (builders.insert(notReady[i]).second) {
+            order.push_back(notReady[i].first);
+        }
+    }
+    unlock();
+}
+
+size_t GlUpload::getPendingCount() {
+    lock();
+    const size_t count = builders.size();
+    unlock();
+    return count;
+}
+
+}
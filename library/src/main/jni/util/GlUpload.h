@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Uploads mesh geometry on the GL thread under a time budget.
+ ***************************************************************************/
+
+#ifndef GL_UPLOAD_H_
+#define GL_UPLOAD_H_
+
+#include <deque>
+#include <functional>
+#include <pthread.h>
+
+namespace mgn {
+class Mesh;
+
+/**
+ * Meshes can be built on any thread. Creating vertex arrays and buffers
+ * needs the GL context, so the builder is queued here and run by
+ * processQueues() on the GL thread. Meshes are deleted only on the GL thread, so a mesh taken from
+ * the queue stays alive while its builder runs.
+ */
+class GlUpload {
+public:
+    // Builds the geometry and sets it to the mesh. Returns false if the data is not ready yet,
+    // then it is tried again in the next frame.
+    typedef std::function<bool(Mesh*)> Builder;
+
+    GlUpload() {
+        pthread_mutex_init(&mutex, 0);
+    }
+
+    ~GlUpload() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // Replaces the builder if the mesh is already queued.
+    void queue(Mesh * mesh, const Builder & builder);
+
+    void cancel(Mesh * mesh);
+
+    // Must be called on the GL thread. At least one mesh is uploaded per call.
+    void processQueues(double budgetSeconds);
+
+    size_t getPendingCount();
+
+private:
+    GlUpload(const GlUpload& upload);
+    GlUpload& operator=(const GlUpload& upload);
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+
+    // A mesh may appear more than once in order after cancel(). Only the entry in builders counts.
+    std::deque<Mesh*> order;
+    std::map<Mesh*, Builder> builders;
+};
+
+extern GlUpload gl_upload;
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuMemory.h"
+
+namespace mgn {
+
+GpuMemory gpu_memory;
+
+GpuResource::~GpuResource() {
+    gpu_memory.Remove(this);
+}
+
+size_t GpuMemory::GetTotalBytes() const {
+    size_t total = 0;
+    for (int i = 0; i < GPU_MEMORY_CATEGORY_COUNT; ++i) {
+        total += bytes[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void GpuMemory::ShrinkBudget(float fraction) {
+    size_t current = budget.load(std::memory_order_relaxed);
+    const size_t total = GetTotalBytes();
+    if (current == 0 || total < current) {
+        current = total;
+    }
+    budget.store(static_cast<size_t>(current * fraction), std::memory_order_relaxed);
+}
+
+void GpuMemory::BeginFrame() {
+    frame++;
+
+    const size_t limit = budget.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return;
+    }
+
+    // Shared geometry is released only by its last user, so the total is checked after each eviction.
+    GpuResource * resource = lruTail;
+    while (resource != nullptr && resource->lastUsedFrame + MIN_IDLE_FRAMES <= frame && GetTotalBytes() > limit) {
+        GpuResource * prev = resource->lruPrev;
+        Remove(resource);
+        if (resource->Evict()) {
+            evictedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        resource = prev;
+    }
+}
+
+void GpuMemory::Touch(GpuResource * resource) {
+    if (resource->inLru) {
+        if (resource == lruHead) {
+            resource->lastUsedFrame = frame;
+            return;
+        }
+        Remove(resource);
+    }
+
+    resource->lruPrev = nullptr;
+    resource->lruNext = lruHead;
+    if (lruHead != nullptr) {
+        lruHead->lruPrev = resource;
+    } else {
+        lruTail = resource;
+    }
+    lruHead = resource;
+    resource->inLru = true;
+    resource->lastUsedFrame = frame;
+}
+
+void GpuMemory::Remove(GpuResource * resource) {
+    if (!resource->inLru) {
+        return;
+    }
+
+    if (resource->lruPrev != nullptr) {
+        resource->lruPrev->lruNext = resource->lruNext;
+    } else {
+        lruHead = resource->lruNext;
+    }
+    if (resource->lruNext != nullptr) {
+        resource->lruNext->lruPrev = resource->lruPrev;
+    } else {
+        lruTail = resource->lruPrev;
+    }
+    resource->lruPrev = nullptr;
+    resource->lruNext = nullptr;
+    resource->inLru = false;
+}
+
+}
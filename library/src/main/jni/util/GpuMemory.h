@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Accounts GPU memory, and keeps it within a budget.
+ ***************************************************************************/
+
+#ifndef GPU_MEMORY_H_
+#define GPU_MEMORY_H_
+
+#include <atomic>
+
+namespace mgn {
+
+// Same values as NativeMemory.GPU_* in Java side.
+enum GpuMemoryCategory {
+    GPU_MEMORY_BUFFER = 0,
+    GPU_MEMORY_TEXTURE,
+    GPU_MEMORY_PROGRAM,
+    GPU_MEMORY_CATEGORY_COUNT
+};
+
+/**
+ * Something drawn with GL objects which it can release and make again from
+ * its source. Everything is done on the GL thread.
+ */
+class GpuResource {
+public:
+    GpuResource() :
+            lruPrev(nullptr),
+            lruNext(nullptr),
+            lastUsedFrame(0),
+            inLru(false) {
+    }
+
+    // Releases the GL objects. Returns false if they can't be made again, then nothing is released.
+    virtual bool Evict() = 0;
+
+protected:
+    virtual ~GpuResource();
+
+private:
+    friend class GpuMemory;
+
+    GpuResource * lruPrev;
+    GpuResource * lruNext;
+    uint32_t lastUsedFrame;
+    bool inLru;
+};
+
+/**
+ * Bytes of GL objects by category, and an LRU list of resources in order of
+ * their last draw. When the total is over the budget, resources which have
+ * not been drawn for a while are evicted from the least recently used one.
+ */
+class GpuMemory {
+public:
+    GpuMemory() :
+            budget(0),
+            evictedCount(0),
+            frame(0),
+            lruHead(nullptr),
+            lruTail(nullptr) {
+        for (int i = 0; i < GPU_MEMORY_CATEGORY_COUNT; ++i) {
+            bytes[i] = 0;
+        }
+    }
+
+    // Can be called on any thread.
+    void Allocate(GpuMemoryCategory category, size_t size) {
+        bytes[category].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void Free(GpuMemoryCategory category, size_t size) {
+        bytes[category].fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    size_t GetBytes(GpuMemoryCategory category) const {
+        return bytes[category].load(std::memory_order_relaxed);
+    }
+
+    size_t GetTotalBytes() const;
+
+    // Can be called on any thread. 0 means no limit. Applied in the next frame.
+    void SetBudget(size_t bytes) {
+        budget.store(bytes, std::memory_order_relaxed);
+    }
+
+    size_t GetBudget() const {
+        return budget.load(std::memory_order_relaxed);
+    }
+
+    // Can be called on any thread. Sets the budget to the fraction of the current use, or of the
+    // budget if it is smaller.
+    void ShrinkBudget(float fraction);
+
+    size_t GetEvictedCount() const {
+        return evictedCount.load(std::memory_order_relaxed);
+    }
+
+    // Must be called on the GL thread once per frame, before drawing. Evicts resources while over budget.
+    void BeginFrame();
+
+    // Must be called on the GL thread when the resource is drawn.
+    void Touch(GpuResource * resource);
+
+    // Must be called on the GL thread.
+    void Remove(GpuResource * resource);
+
+private:
+    GpuMemory(const GpuMemory& memory);
+    GpuMemory& operator=(const GpuMemory& memory);
+
+    // Resources drawn within this many frames are kept, so that looking around doesn't reload them.
+    static const uint32_t MIN_IDLE_FRAMES = 30;
+
+    std::atomic<size_t> bytes[GPU_MEMORY_CATEGORY_COUNT];
+    std::atomic<size_t> budget;
+    std::atomic<size_t> evictedCount;
+
+    // Owned by the GL thread. The head is the most recently used.
+    uint32_t frame;
+    GpuResource * lruHead;
+    GpuResource * lruTail;
+};
+
+extern GpuMemory gpu_memory;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HandleTable.h"
+
+namespace mgn {
+
+HandleTable native_handles;
+
+HandleTable::HandleTable() :
+        chunkCount(0),
+        freeHead(INVALID_INDEX),
+        count(0) {
+    pthread_mutex_init(&mutex, 0);
+    memset(chunks, 0, sizeof(chunks));
+}
+
+HandleTable::~HandleTable() {
+    const uint32_t n = chunkCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < n; ++i) {
+        delete[] chunks[i];
+    }
+    pthread_mutex_destroy(&mutex);
+}
+
+jlong HandleTable::Add(HybridObject * object) {
+    lock();
+
+    if (freeHead == INVALID_INDEX) {
+        const uint32_t n = chunkCount.load(std::memory_order_relaxed);
+        if (n == MAX_CHUNKS) {
+            unlock();
+            std::string error = "HandleTable::Add() : Too many native objects.";
+            throw error;
+        }
+
+        // Thread the new chunk onto the free list.
+        Entry * chunk = new Entry[CHUNK_SIZE];
+        const uint32_t base = n << CHUNK_SHIFT;
+        for (uint32_t i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i].object.store(nullptr, std::memory_order_relaxed);
+            chunk[i].generation.store(1, std::memory_order_relaxed);
+            chunk[i].nextFree = (i + 1 < CHUNK_SIZE) ? base + i + 1 : INVALID_INDEX;
+        }
+        chunks[n] = chunk;
+
+        // Lock-free lookups see the filled chunk once they see the new count.
+        chunkCount.store(n + 1, std::memory_order_release);
+        freeHead = base;
+    }
+
+    const uint32_t index = freeHead;
+    Entry & entry = chunks[index >> CHUNK_SHIFT][index & CHUNK_MASK];
+    freeHead = entry.nextFree;
+    entry.nextFree = INVALID_INDEX;
+    entry.object.store(object, std::memory_order_release);
+    count++;
+
+    const jlong handle = MakeHandle(index, entry.generation.load(std::memory_order_relaxed));
+    unlock();
+    return handle;
+}
+
+HybridObject * HandleTable::Remove(jlong handle) {
+    lock();
+
+    Entry * entry = Find(handle);
+    if (entry == nullptr) {
+        unlock();
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "HandleTable::Remove() : stale handle %llx", (long long) handle);
+        return nullptr;
+    }
+
+    HybridObject * object = entry->object.load(std::memory_order_relaxed);
+    entry->object.store(nullptr, std::memory_order_release);
+
+    // Generation 0 is never used so that a handle is never 0.
+    uint32_t generation = entry->generation.load(std::memory_order_relaxed) + 1;
+    if (generation == 0) {
+        generation = 1;
+    }
+    entry->generation.store(generation, std::memory_order_release);
+
+    const uint32_t index = static_cast<uint32_t>(handle);
+    entry->nextFree = freeHead;
+    freeHead = index;
+    count--;
+
+    unlock();
+    return object;
+}
+
+bool HandleTable::IsValid(jlong handle) const {
+    return Find(handle) != nullptr;
+}
+
+HandleTable::Entry * HandleTable::Find(jlong handle) const {
+    const uint32_t index = static_cast<uint32_t>(handle);
+    const uint32_t generation = static_cast<uint32_t>(static_cast<uint64_t>(handle) >> 32);
+
+    // Pairs with the release store in Add(), so chunks[] below is filled in.
+    if ((index >> CHUNK_SHIFT) >= chunkCount.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    Entry * entry = &chunks[index >> CHUNK_SHIFT][index & CHUNK_MASK];
+    if (entry->generation.load(std::memory_order_acquire) != generation
+        || entry->object.load(std::memory_order_acquire) == nullptr) {
+        return nullptr;
+    }
+
+    return entry;
+}
+
+void HandleTable::CheckHandle(jlong handle) const {
+    if (Find(handle) == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "HandleTable::Get() : stale handle %llx", (long long) handle);
+        OVR_ASSERT(false);
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Handles passed to Java instead of raw native pointers.
+ ***************************************************************************/
+
+#ifndef HANDLE_TABLE_H_
+#define HANDLE_TABLE_H_
+
+#include <pthread.h>
+#include <atomic>
+
+#include "HybridObject.h"
+
+namespace mgn {
+
+/**
+ * A handle is (generation << 32 | index). The generation of a slot is bumped
+ * when its object is removed, so a stale handle never resolves to the object
+ * which reuses the slot. Entries are stored in chunks which are never moved nor
+ * freed while the table lives, and a chunk is published to lookups only after
+ * it is filled in, so lookups don't need a lock. Add() and Remove() still
+ * serialize on the mutex.
+ */
+class HandleTable {
+public:
+    HandleTable();
+    ~HandleTable();
+
+    jlong Add(HybridObject * object);
+
+    // Returns the object which was registered with the handle.
+    HybridObject * Remove(jlong handle);
+
+    bool IsValid(jlong handle) const;
+
+    HybridObject * Get(jlong handle) const {
+#if defined(OVR_BUILD_DEBUG)
+        CheckHandle(handle);
+#endif
+        const uint32_t index = static_cast<uint32_t>(handle);
+        return chunks[index >> CHUNK_SHIFT][index & CHUNK_MASK].object.load(std::memory_order_acquire);
+    }
+
+    size_t GetCount() const {
+        return count;
+    }
+
+private:
+    HandleTable(const HandleTable& table);
+    HandleTable(HandleTable&& table);
+    HandleTable& operator=(const HandleTable& table);
+    HandleTable& operator=(HandleTable&& table);
+
+    // object and generation are read without the lock. nextFree is only touched under it.
+    struct Entry {
+        std::atomic<HybridObject *> object;
+        std::atomic<uint32_t> generation;
+        uint32_t nextFree;
+    };
+
+    static const uint32_t CHUNK_SHIFT = 10;
+    static const uint32_t CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static const uint32_t CHUNK_MASK = CHUNK_SIZE - 1;
+    static const uint32_t MAX_CHUNKS = 1024;
+    static const uint32_t INVALID_INDEX = 0xffffffff;
+
+    static jlong MakeHandle(uint32_t index, uint32_t generation) {
+        return static_cast<jlong>((static_cast<uint64_t>(generation) << 32) | index);
+    }
+
+    Entry * Find(jlong handle) const;
+    void CheckHandle(jlong handle) const;
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    Entry * chunks[MAX_CHUNKS];          // Fixed size, so it is never reallocated.
+    std::atomic<uint32_t> chunkCount;   // Stored with release after chunks[chunkCount] is set.
+    uint32_t freeHead;
+    size_t count;
+};
+
+extern HandleTable native_handles;
+
+/**
+ * Register a newly created object and return the handle for Java.
+ */
+inline jlong NewHandle(HybridObject * object) {
+    return native_handles.Add(object);
+}
+
+/**
+ * Resolve a handle received from Java.
+ */
+template<typename T>
+inline T * FromHandle(jlong handle) {
+    return static_cast<T*>(native_handles.Get(handle));
+}
+
+}
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MeshBounds.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MESH_BOUNDS_NEON
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define MESH_BOUNDS_SSE
+#endif
+
+namespace mgn {
+
+void ComputeMinMax(const float * positions, size_t positionStride, size_t vertexCount,
+        float mins[3], float maxs[3]) {
+
+    for (int k = 0; k < 3; ++k) {
+        mins[k] = FLT_MAX;
+        maxs[k] = -FLT_MAX;
+    }
+
+    if (vertexCount == 0) {
+        for (int k = 0; k < 3; ++k) {
+            mins[k] = maxs[k] = 0.0f;
+        }
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(MESH_BOUNDS_NEON) || defined(MESH_BOUNDS_SSE)
+    // One 4 lane load per vertex; the 4th lane is ignored. It reads one float
+    // past the position, which is out of the stream only for the last vertex
+    // of a tightly packed xyz stream, so that one is left to the scalar loop.
+    // Two accumulators hide the latency of min and max.
+    const size_t vectorCount = positionStride >= 4 ? vertexCount : vertexCount - 1;
+    float lanes[2][4];
+
+#if defined(MESH_BOUNDS_NEON)
+    float32x4_t min0 = vdupq_n_f32(FLT_MAX), min1 = min0;
+    float32x4_t max0 = vdupq_n_f32(-FLT_MAX), max1 = max0;
+    for (; i + 1 < vectorCount; i += 2) {
+        const float32x4_t a = vld1q_f32(positions + i * positionStride);
+        const float32x4_t b = vld1q_f32(positions + (i + 1) * positionStride);
+        min0 = vminq_f32(min0, a);
+        max0 = vmaxq_f32(max0, a);
+        min1 = vminq_f32(min1, b);
+        max1 = vmaxq_f32(max1, b);
+    }
+    vst1q_f32(lanes[0], vminq_f32(min0, min1));
+    vst1q_f32(lanes[1], vmaxq_f32(max0, max1));
+#else
+    __m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0;
+    __m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0;
+    for (; i + 1 < vectorCount; i += 2) {
+        const __m128 a = _mm_loadu_ps(positions + i * positionStride);
+        const __m128 b = _mm_loadu_ps(positions + (i + 1) * positionStride);
+        min0 = _mm_min_ps(min0, a);
+        max0 = _mm_max_ps(max0, a);
+        min1 = _mm_min_ps(min1, b);
+        max1 = _mm_max_ps(max1, b);
+    }
+    _mm_storeu_ps(lanes[0], _mm_min_ps(min0, min1));
+    _mm_storeu_ps(lanes[1], _mm_max_ps(max0, max1));
+#endif
+
+    for (int k = 0; k < 3; ++k) {
+        mins[k] = lanes[0][k];
+        maxs[k] = lanes[1][k];
+    }
+#endif
+
+    for (; i < vertexCount; ++i) {
+        const float * p = positions + i * positionStride;
+        for (int k = 0; k < 3; ++k) {
+            mins[k] = std::min(mins[k], p[k]);
+            maxs[k] = std::max(maxs[k], p[k]);
+        }
+    }
+}
+
+static inline float Distance2(const float * p, const float c[3]) {
+    const float dx = p[0] - c[0], dy = p[1] - c[1], dz = p[2] - c[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static size_t Farthest(const float * positions, size_t positionStride, size_t vertexCount, const float c[3]) {
+    size_t best = 0;
+    float bestDistance = -1.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float d = Distance2(positions + i * positionStride, c);
+        if (d > bestDistance) {
+            bestDistance = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void ComputeBoundingSphere(const float * positions, size_t positionStride, size_t vertexCount,
+        float center[3], float & radius) {
+
+    if (vertexCount == 0) {
+        center[0] = center[1] = center[2] = radius = 0.0f;
+        return;
+    }
+
+    // Start with the farthest pair found from an arbitrary vertex.
+    const float * a = positions + Farthest(positions, positionStride, vertexCount, positions) * positionStride;
+    const float * b = positions + Farthest(positions, positionStride, vertexCount, a) * positionStride;
+    for (int k = 0; k < 3; ++k) {
+        center[k] = (a[k] + b[k]) * 0.5f;
+    }
+    radius = std::sqrt(Distance2(a, center));
+
+    // Grow the sphere just enough to take in each vertex outside.
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float * p = positions + i * positionStride;
+        const float d2 = Distance2(p, center);
+        if (d2 > radius * radius) {
+            const float d = std::sqrt(d2);
+            const float newRadius = (radius + d) * 0.5f;
+            const float t = (newRadius - radius) / d;
+            for (int k = 0; k < 3; ++k) {
+                center[k] += (p[k] - center[k]) * t;
+            }
+            radius = newRadius;
+        }
+    }
+
+    // Rounding in the updates can leave a vertex just outside.
+    radius *= 1.0f + FLT_EPSILON * 4.0f;
+}
+
+}
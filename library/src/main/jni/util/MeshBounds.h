@@ -0,0 +1,44 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/***************************************************************************
+ * Bounding box and sphere of vertex streams. Shared by the runtime and
+ * tools/meshconv, so this file must not depend on includes.h, OVR or Android
+ * headers.
+ ***************************************************************************/
+
+#ifndef MESH_BOUNDS_H_
+#define MESH_BOUNDS_H_
+
+#include <stddef.h>
+
+namespace mgn {
+
+/**
+ * Min and max of xyz float positions which are positionStride floats apart.
+ * Uses NEON or SSE when available. Both are 0 if vertexCount is 0.
+ */
+void ComputeMinMax(const float * positions, size_t positionStride, size_t vertexCount,
+        float mins[3], float maxs[3]);
+
+/**
+ * Ritter's bounding sphere. Not minimal but within a few percent, and much
+ * tighter than the sphere around the bounding box for long or flat meshes.
+ */
+void ComputeBoundingSphere(const float * positions, size_t positionStride, size_t vertexCount,
+        float center[3], float & radius);
+
+}
+#endif
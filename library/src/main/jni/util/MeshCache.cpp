@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshCache.h"
+#include "Mesh.h"
+
+namespace mgn {
+
+MeshCache mesh_cache;
+
+MeshKey & MeshKey::Add(const void * data, size_t bytes) {
+    const uint8_t * p = static_cast<const uint8_t*>(data);
+
+    // FNV-1a over 8 byte words, with a shift to mix high bits into the low ones. The check hash
+    // is a multiply-rotate round with other constants, so it doesn't collide along with it.
+    // Vertex arrays are hashed on build, so this has to be much cheaper than packing them.
+    for (; bytes >= 8; bytes -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = (hash ^ word) * FNV_PRIME;
+        hash ^= hash >> 32;
+        check += word * CHECK_PRIME2;
+        check = ((check << 31) | (check >> 33)) * CHECK_PRIME1;
+    }
+    for (; bytes > 0; --bytes, ++p) {
+        hash = (hash ^ *p) * FNV_PRIME;
+        const uint64_t mixed = check ^ (*p * CHECK_PRIME1);
+        check = ((mixed << 23) | (mixed >> 41)) * CHECK_PRIME2;
+    }
+    return *this;
+}
+
+std::shared_ptr<MeshGeometry> MeshCache::Find(const MeshKey & key) {
+    lock();
+    std::shared_ptr<MeshGeometry> geometry;
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        geometry = it->second.lock();
+    }
+    unlock();
+    return geometry;
+}
+
+std::shared_ptr<MeshGeometry> MeshCache::Insert(const MeshKey & key, const std::shared_ptr<MeshGeometry> & geometry) {
+    lock();
+    std::weak_ptr<MeshGeometry> & entry = entries[key];
+    std::shared_ptr<MeshGeometry> cached = entry.lock();
+    if (!cached) {
+        entry = geometry;
+        cached = geometry;
+    }
+    if (entries.size() >= pruneSize) {
+        Prune();
+    }
+    unlock();
+    return cached;
+}
+
+size_t MeshCache::GetCount() {
+    lock();
+    size_t count = 0;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (!it->second.expired()) {
+            count++;
+        }
+    }
+    unlock();
+    return count;
+}
+
+void MeshCache::Prune() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.expired()) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Amortized: the next pass runs when the live entries have doubled.
+    pruneSize = entries.size() * 2 > MIN_PRUNE_SIZE ? entries.size() * 2 : MIN_PRUNE_SIZE;
+}
+
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Shares identical mesh geometry between meshes.
+ ***************************************************************************/
+
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include <memory>
+#include <pthread.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace mgn {
+class MeshGeometry;
+
+/**
+ * Identity of geometry: a builder name and its parameters, or the data passed
+ * to build(). Two independent 64 bit hashes are kept, and keys are equal only
+ * if both hashes and the vertex and index counts are equal, so a collision of
+ * one hash doesn't return another mesh.
+ */
+class MeshKey {
+public:
+    explicit MeshKey(const char * builder) :
+            hash(FNV_OFFSET),
+            check(CHECK_SEED),
+            vertexCount(0),
+            indexCount(0) {
+        Add(builder, strlen(builder));
+    }
+
+    MeshKey & Add(const void * data, size_t bytes);
+
+    template<typename T>
+    MeshKey & Add(const T & value) {
+        return Add(&value, sizeof(T));
+    }
+
+    MeshKey & Counts(uint32_t vertices, uint32_t indices) {
+        vertexCount = vertices;
+        indexCount = indices;
+        return *this;
+    }
+
+    bool operator==(const MeshKey & key) const {
+        return hash == key.hash && check == key.check
+               && vertexCount == key.vertexCount && indexCount == key.indexCount;
+    }
+
+    struct Hasher {
+        size_t operator()(const MeshKey & key) const {
+            return static_cast<size_t>(key.hash ^ (key.hash >> 32));
+        }
+    };
+
+private:
+    static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    static const uint64_t FNV_PRIME = 1099511628211ULL;
+    static const uint64_t CHECK_SEED = 0x27d4eb2f165667c5ULL;
+    static const uint64_t CHECK_PRIME1 = 0x9e3779b185ebca87ULL;
+    static const uint64_t CHECK_PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+
+    uint64_t hash;
+    uint64_t check;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
+
+/**
+ * Geometry is kept only while a mesh uses it. The cache holds weak
+ * references, so the GL objects are released through gl_delete when the
+ * last mesh goes, and expired entries are dropped as the cache grows.
+ */
+class MeshCache {
+public:
+    MeshCache() :
+            pruneSize(MIN_PRUNE_SIZE) {
+        pthread_mutex_init(&mutex, 0);
+    }
+
+    ~MeshCache() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // Can be called on any thread. Returns null if nothing alive is cached for the key.
+    std::shared_ptr<MeshGeometry> Find(const MeshKey & key);
+
+    // Can be called on any thread. Keeps the geometry already cached for the key, and returns it.
+    std::shared_ptr<MeshGeometry> Insert(const MeshKey & key, const std::shared_ptr<MeshGeometry> & geometry);
+
+    // Count of cached geometry still in use.
+    size_t GetCount();
+
+private:
+    MeshCache(const MeshCache& cache);
+    MeshCache& operator=(const MeshCache& cache);
+
+    static const size_t MIN_PRUNE_SIZE = 64;
+
+    void Prune();
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    std::unordered_map<MeshKey, std::weak_ptr<MeshGeometry>, MeshKey::Hasher> entries;
+    size_t pruneSize;
+};
+
+extern MeshCache mesh_cache;
+}
+
+#endif
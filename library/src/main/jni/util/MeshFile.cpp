@@ -0,0 +1,133 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+#include "MeshFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mgn {
+
+MeshFile::MeshFile() :
+        data(nullptr),
+        size(0),
+        modifiedTime(0),
+        mapped(nullptr),
+        asset(nullptr) {
+}
+
+MeshFile::~MeshFile() {
+    if (mapped != nullptr) {
+        munmap(mapped, size);
+    }
+    if (asset != nullptr) {
+        AAsset_close(asset);
+    }
+}
+
+std::shared_ptr<MeshFile> MeshFile::Open(const char * path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "MeshFile::Open() : cannot open %s", path);
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(MeshFileHeader)) {
+        close(fd);
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "MeshFile::Open() : %s is too small", path);
+        return nullptr;
+    }
+
+    void * mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "MeshFile::Open() : cannot map %s", path);
+        return nullptr;
+    }
+
+    std::shared_ptr<MeshFile> file(new MeshFile());
+    file->mapped = mapped;
+    file->data = static_cast<const uint8_t*>(mapped);
+    file->size = st.st_size;
+    file->modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return file->Validate(path) ? file : nullptr;
+}
+
+std::shared_ptr<MeshFile> MeshFile::Open(AAssetManager * assets, const char * path) {
+    AAsset * asset = AAssetManager_open(assets, path, AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "MeshFile::Open() : cannot open asset %s", path);
+        return nullptr;
+    }
+
+    std::shared_ptr<MeshFile> file(new MeshFile());
+    file->asset = asset;
+    file->data = static_cast<const uint8_t*>(AAsset_getBuffer(asset));
+    file->size = AAsset_getLength(asset);
+    return file->data != nullptr && file->size >= sizeof(MeshFileHeader) && file->Validate(path) ? file : nullptr;
+}
+
+bool MeshFile::Validate(const char * path) const {
+    const MeshFileHeader & header = GetHeader();
+
+    const char * error = nullptr;
+    if (reinterpret_cast<uintptr_t>(data) % 4 != 0) {
+        error = "not aligned";
+    } else if (header.magic != MESH_FILE_MAGIC) {
+        error = "not a mesh file";
+    } else if (header.version != MESH_FILE_VERSION) {
+        error = "unsupported version";
+    } else if (header.fileSize != size) {
+        error = "truncated";
+    } else if (header.attributeCount > MESH_FILE_MAX_ATTRIBUTES
+            || header.lodCount == 0 || header.lodCount > MESH_FILE_MAX_LODS) {
+        error = "bad counts";
+    }
+
+    for (uint32_t i = 0; error == nullptr && i < header.attributeCount; ++i) {
+        const MeshFileAttribute & attribute = header.attributes[i];
+        const uint32_t componentSize = attribute.type == MESH_FILE_FLOAT ? 4
+                : (attribute.type == MESH_FILE_SHORT || attribute.type == MESH_FILE_UNSIGNED_SHORT) ? 2 : 1;
+        if (attribute.offset + attribute.size * componentSize > header.vertexStride) {
+            error = "attribute out of vertex";
+        }
+    }
+
+    for (uint32_t i = 0; error == nullptr && i < header.lodCount; ++i) {
+        const MeshFileLod & lod = header.lods[i];
+        const uint64_t vertexEnd = lod.vertexOffset + (uint64_t) lod.vertexCount * header.vertexStride;
+        const uint64_t indexEnd = lod.indexOffset + (uint64_t) lod.indexCount * MeshFileIndexSize(lod.indexType);
+        if (lod.vertexOffset % MESH_FILE_ALIGNMENT != 0 || lod.indexOffset % MESH_FILE_ALIGNMENT != 0) {
+            error = "stream not aligned";
+        } else if (vertexEnd > size || indexEnd > size) {
+            error = "stream out of file";
+        } else if (lod.indexType != MESH_FILE_UNSIGNED_SHORT && lod.indexType != MESH_FILE_UNSIGNED_INT) {
+            error = "bad index type";
+        }
+    }
+
+    if (error != nullptr) {
+        __android_log_print(ANDROID_LOG_ERROR, "mgn", "MeshFile::Validate() : %s : %s", path, error);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Memory mapped binary mesh file.
+ ***************************************************************************/
+
+#ifndef MESH_FILE_H_
+#define MESH_FILE_H_
+
+#include "MeshFormat.h"
+
+namespace mgn {
+
+/**
+ * A mesh file mapped from the file system or from an uncompressed asset.
+ * Streams are read directly from the mapping, nothing is parsed or copied.
+ * Store .mgnm assets uncompressed (aaptOptions noCompress 'mgnm'), or
+ * AAsset_getBuffer() has to inflate the whole file.
+ */
+class MeshFile {
+public:
+    // Returns nullptr if the file can't be mapped or is broken.
+    static std::shared_ptr<MeshFile> Open(const char * path);
+    static std::shared_ptr<MeshFile> Open(AAssetManager * assets, const char * path);
+
+    ~MeshFile();
+
+    const MeshFileHeader & GetHeader() const {
+        return *reinterpret_cast<const MeshFileHeader*>(data);
+    }
+
+    const void * GetVertices(uint32_t lod) const {
+        return data + GetHeader().lods[lod].vertexOffset;
+    }
+
+    const void * GetIndices(uint32_t lod) const {
+        return data + GetHeader().lods[lod].indexOffset;
+    }
+
+    const void * GetData() const {
+        return data;
+    }
+
+    size_t GetSize() const {
+        return size;
+    }
+
+    // Nanoseconds since the epoch. 0 for assets.
+    int64_t GetModifiedTime() const {
+        return modifiedTime;
+    }
+
+private:
+    MeshFile();
+    MeshFile(const MeshFile& file);
+    MeshFile& operator=(const MeshFile& file);
+
+    bool Validate(const char * path) const;
+
+    const uint8_t * data;
+    size_t size;
+    int64_t modifiedTime;
+    void * mapped;
+    AAsset * asset;
+};
+
+}
+#endif
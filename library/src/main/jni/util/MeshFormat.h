@@ -0,0 +1,103 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Binary mesh container. Shared by the runtime loader and tools/meshconv,
+ * so this file must not depend on includes.h, OVR or Android headers.
+ ***************************************************************************/
+
+#ifndef MESH_FORMAT_H_
+#define MESH_FORMAT_H_
+
+#include <stdint.h>
+
+namespace mgn {
+
+/**
+ * File layout:
+ *
+ *   MeshFileHeader
+ *   vertex and index streams of each LOD, each aligned to MESH_FILE_ALIGNMENT
+ *
+ * Offsets are from the head of the file. All values are little endian, which
+ * is the byte order of every device we run on, so a mapped file is used as
+ * it is. Streams are in the GL layout described by the attributes and can be
+ * passed to glBufferData directly. LODs may share the vertex stream of LOD 0.
+ *
+ * Version 2 replaced switchDistance of LODs with the simplification error.
+ */
+static const uint32_t MESH_FILE_MAGIC = 0x4d4e474d; // "MGNM"
+static const uint32_t MESH_FILE_VERSION = 2;
+static const uint32_t MESH_FILE_ALIGNMENT = 16;
+static const uint32_t MESH_FILE_MAX_ATTRIBUTES = 8;
+static const uint32_t MESH_FILE_MAX_LODS = 8;
+
+// Same values as GL
+static const uint32_t MESH_FILE_BYTE = 0x1400;
+static const uint32_t MESH_FILE_UNSIGNED_BYTE = 0x1401;
+static const uint32_t MESH_FILE_SHORT = 0x1402;
+static const uint32_t MESH_FILE_UNSIGNED_SHORT = 0x1403;
+static const uint32_t MESH_FILE_UNSIGNED_INT = 0x1405;
+static const uint32_t MESH_FILE_FLOAT = 0x1406;
+
+// Same values as VERTEX_ATTRIBUTE_LOCATION_* in OVR
+static const uint32_t MESH_FILE_POSITION = 0;
+static const uint32_t MESH_FILE_NORMAL = 1;
+static const uint32_t MESH_FILE_COLOR = 4;
+static const uint32_t MESH_FILE_UV0 = 5;
+
+struct MeshFileAttribute {
+    uint8_t location;
+    uint8_t size;
+    uint8_t normalized;
+    uint8_t offset;
+    uint32_t type;
+};
+
+struct MeshFileLod {
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t indexType;     // MESH_FILE_UNSIGNED_SHORT or MESH_FILE_UNSIGNED_INT
+    float    error;         // Simplification error relative to the largest bounding box extent. 0 for LOD 0.
+};
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint32_t lodCount;
+    float    boundsMin[3];
+    float    boundsMax[3];
+    float    sphereCenter[3];
+    float    sphereRadius;
+    MeshFileAttribute attributes[MESH_FILE_MAX_ATTRIBUTES];
+    MeshFileLod lods[MESH_FILE_MAX_LODS];
+};
+
+inline uint32_t MeshFileAlign(uint32_t value) {
+    return (value + MESH_FILE_ALIGNMENT - 1) & ~(MESH_FILE_ALIGNMENT - 1);
+}
+
+inline uint32_t MeshFileIndexSize(uint32_t indexType) {
+    return indexType == MESH_FILE_UNSIGNED_INT ? 4 : 2;
+}
+
+}
+#endif
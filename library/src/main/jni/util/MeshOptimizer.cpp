@@ -0,0 +1,311 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace mgn {
+
+float ComputeAcmr(const uint32_t * indices, size_t indexCount, size_t vertexCount, int cacheSize) {
+    if (indexCount < 3) {
+        return 0.0f;
+    }
+
+    // A vertex is in the cache while it was inserted within the last cacheSize misses.
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        const uint32_t v = indices[i];
+        if (insertedAt[v] == 0 || misses + 1 - insertedAt[v] > (uint32_t) cacheSize) {
+            misses++;
+            insertedAt[v] = misses;
+        }
+    }
+
+    return static_cast<float>(misses) / (indexCount / 3);
+}
+
+// Forsyth's scoring
+static const int   CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static float VertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The last triangle's vertices get a fixed score so that no triangle sharing an edge is preferred unfairly.
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            const float scaler = 1.0f / (CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Vertices with few remaining triangles are finished first.
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void OptimizeVertexCache(uint32_t * indices, size_t indexCount, size_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles adjacent to each vertex, as offsets into one array.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        remaining[indices[i]]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            adjacency[filled[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    // Extra room for the 3 vertices pushed in front before trimming.
+    uint32_t cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    size_t scanCursor = 0;
+    size_t bestTriangle = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            bestTriangle = t;
+        }
+    }
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestScore < 0.0f) {
+            // No candidate around the cache. Take the next triangle not emitted yet.
+            while (emitted[scanCursor]) {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+
+        emitted[bestTriangle] = true;
+        const uint32_t * triangle = &indices[bestTriangle * 3];
+
+        // Move triangle vertices to the front of the cache.
+        uint32_t newCache[CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = triangle[k];
+            output.push_back(v);
+            newCache[newCount++] = v;
+
+            // Remove the triangle from the vertex's adjacency.
+            uint32_t * begin = &adjacency[offsets[v]];
+            uint32_t * end = begin + remaining[v];
+            *std::find(begin, end, (uint32_t) bestTriangle) = *(end - 1);
+            remaining[v]--;
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            const uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Vertices pushed out of the cache lose their cache score.
+        for (int i = CACHE_SIZE; i < newCount; ++i) {
+            cachePosition[newCache[i]] = -1;
+            vertexScore[newCache[i]] = VertexScore(-1, remaining[newCache[i]]);
+        }
+        cacheCount = std::min(newCount, CACHE_SIZE);
+        memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+        for (int i = 0; i < cacheCount; ++i) {
+            cachePosition[cache[i]] = i;
+            vertexScore[cache[i]] = VertexScore(i, remaining[cache[i]]);
+        }
+
+        // Rescore triangles around the cache and pick the best for the next step.
+        bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i) {
+            const uint32_t v = cache[i];
+            for (uint32_t a = 0; a < remaining[v]; ++a) {
+                const uint32_t t = adjacency[offsets[v] + a];
+                const float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void OptimizeOverdraw(uint32_t * indices, size_t indexCount,
+        const float * positions, size_t positionStride, size_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // A cluster starts where all 3 vertices of a triangle miss the cache.
+    std::vector<size_t> clusterStarts;
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int triangleMisses = 0;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = indices[t * 3 + k];
+            if (insertedAt[v] == 0 || misses + 1 - insertedAt[v] > (uint32_t) ACMR_CACHE_SIZE) {
+                misses++;
+                insertedAt[v] = misses;
+                triangleMisses++;
+            }
+        }
+        if (t == 0 || triangleMisses == 3) {
+            clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2) {
+        return;
+    }
+
+    auto position = [positions, positionStride](uint32_t v) {
+        return positions + v * positionStride;
+    };
+
+    // Mesh centroid
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < indexCount; ++i) {
+        const float * p = position(indices[i]);
+        for (int k = 0; k < 3; ++k) {
+            meshCenter[k] += p[k];
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        meshCenter[k] /= indexCount;
+    }
+
+    // Sort key: how far the cluster is from the center along its own average normal.
+    std::vector<std::pair<float, size_t> > keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float center[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            const float * a = position(indices[t * 3]);
+            const float * b = position(indices[t * 3 + 1]);
+            const float * d = position(indices[t * 3 + 2]);
+            const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const float e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            const float n[3] = {
+                    e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0] };
+            const float w = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                center[k] += (a[k] + b[k] + d[k]) / 3.0f * w;
+                normal[k] += n[k];
+            }
+            area += w;
+        }
+
+        float key = 0.0f;
+        if (area > 0.0f) {
+            const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (int k = 0; k < 3; ++k) {
+                key += (center[k] / area - meshCenter[k]) * (length > 0.0f ? normal[k] / length : 0.0f);
+            }
+        }
+        keys[c] = std::make_pair(-key, c);
+    }
+
+    std::stable_sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (size_t i = 0; i < clusterCount; ++i) {
+        const size_t c = keys[i].second;
+        output.insert(output.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+    }
+    memcpy(indices, output.data(), triangleCount * 3 * sizeof(uint32_t));
+}
+
+size_t BuildVertexFetchRemap(const uint32_t * indices, size_t indexCount, size_t vertexCount,
+        std::vector<uint32_t> & remap) {
+    remap.assign(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (remap[indices[i]] == ~0u) {
+            remap[indices[i]] = next++;
+        }
+    }
+    return next;
+}
+
+void RemapIndices(uint32_t * indices, size_t indexCount, const std::vector<uint32_t> & remap) {
+    for (size_t i = 0; i < indexCount; ++i) {
+        indices[i] = remap[indices[i]];
+    }
+}
+
+void RemapVertices(const void * in, void * out, size_t stride, const std::vector<uint32_t> & remap) {
+    const uint8_t * src = static_cast<const uint8_t*>(in);
+    uint8_t * dst = static_cast<uint8_t*>(out);
+    for (size_t v = 0; v < remap.size(); ++v) {
+        if (remap[v] != ~0u) {
+            memcpy(dst + remap[v] * stride, src + v * stride, stride);
+        }
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/***************************************************************************
+ * Triangle and vertex reordering. Shared by the runtime and tools/meshconv,
+ * so this file must not depend on includes.h, OVR or Android headers.
+ ***************************************************************************/
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace mgn {
+
+// Post-transform cache size used for ACMR reports. Close to Adreno and Mali.
+static const int ACMR_CACHE_SIZE = 16;
+
+/**
+ * Average cache miss ratio: transformed vertices per triangle with a FIFO
+ * post-transform cache. 3.0 is the worst, about 0.6 is the best for
+ * regular grids.
+ */
+float ComputeAcmr(const uint32_t * indices, size_t indexCount, size_t vertexCount,
+        int cacheSize = ACMR_CACHE_SIZE);
+
+/**
+ * Reorders triangles for the post-transform vertex cache with Tom Forsyth's
+ * linear-speed algorithm.
+ */
+void OptimizeVertexCache(uint32_t * indices, size_t indexCount, size_t vertexCount);
+
+/**
+ * Splits cache-optimized triangles into clusters where the cache restarts,
+ * and draws clusters facing outwards first so that they occlude the rest.
+ * Clusters are kept intact, so ACMR rises only slightly.
+ */
+void OptimizeOverdraw(uint32_t * indices, size_t indexCount,
+        const float * positions, size_t positionStride, size_t vertexCount);
+
+/**
+ * Builds remap[old] = new so that vertices are stored in the order they are
+ * first referenced. Unreferenced vertices get ~0u. Returns the count of
+ * referenced vertices.
+ */
+size_t BuildVertexFetchRemap(const uint32_t * indices, size_t indexCount, size_t vertexCount,
+        std::vector<uint32_t> & remap);
+
+// Applies remap to indices in place.
+void RemapIndices(uint32_t * indices, size_t indexCount, const std::vector<uint32_t> & remap);
+
+// Copies vertices of stride bytes from in to out in the remapped order.
+void RemapVertices(const void * in, void * out, size_t stride, const std::vector<uint32_t> & remap);
+
+}
+#endif
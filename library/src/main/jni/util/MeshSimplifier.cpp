@@ -0,0 +1,334 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace mgn {
+
+// Planes along borders are weighted heavier than the triangles so that holes don't open.
+static const double BORDER_WEIGHT = 10.0;
+
+namespace {
+
+// Sum of squared distances to planes: x^T A x + 2 b^T x + c, and the sum of plane weights.
+struct Quadric {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double w;
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+
+    bool operator<(const Collapse & other) const {
+        return cost < other.cost;
+    }
+};
+
+}
+
+static void AddPlane(Quadric & q, const double n[3], double d, double weight, bool countWeight) {
+    q.a00 += weight * n[0] * n[0];
+    q.a01 += weight * n[0] * n[1];
+    q.a02 += weight * n[0] * n[2];
+    q.a11 += weight * n[1] * n[1];
+    q.a12 += weight * n[1] * n[2];
+    q.a22 += weight * n[2] * n[2];
+    q.b0 += weight * n[0] * d;
+    q.b1 += weight * n[1] * d;
+    q.b2 += weight * n[2] * d;
+    q.c += weight * d * d;
+    if (countWeight) {
+        q.w += weight;
+    }
+}
+
+static void AddQuadric(Quadric & q, const Quadric & r) {
+    q.a00 += r.a00;
+    q.a01 += r.a01;
+    q.a02 += r.a02;
+    q.a11 += r.a11;
+    q.a12 += r.a12;
+    q.a22 += r.a22;
+    q.b0 += r.b0;
+    q.b1 += r.b1;
+    q.b2 += r.b2;
+    q.c += r.c;
+    q.w += r.w;
+}
+
+// Mean squared distance of p to the planes.
+static double Evaluate(const Quadric & q, const float * p) {
+    const double x = p[0], y = p[1], z = p[2];
+    const double r = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+            + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+            + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z)
+            + q.c;
+    return q.w > 0.0 ? std::max(r, 0.0) / q.w : std::max(r, 0.0);
+}
+
+static void Cross(const float * a, const float * b, const float * c, double n[3]) {
+    const double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+static inline uint64_t EdgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+float SimplifyMesh(const uint32_t * indices, size_t indexCount,
+        const float * positions, size_t positionStride, size_t vertexCount,
+        size_t targetIndexCount, float maxError, std::vector<uint32_t> & out) {
+
+    out.assign(indices, indices + indexCount);
+    if (indexCount < 3 || vertexCount == 0) {
+        return 0.0f;
+    }
+
+    // Work in a unit box so that errors don't depend on the scale of the mesh.
+    float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t i = 0; i < vertexCount; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            mins[k] = std::min(mins[k], positions[i * positionStride + k]);
+            maxs[k] = std::max(maxs[k], positions[i * positionStride + k]);
+        }
+    }
+    const float extent = std::max(maxs[0] - mins[0], std::max(maxs[1] - mins[1], maxs[2] - mins[2]));
+    const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+    std::vector<float> p(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            p[i * 3 + k] = (positions[i * positionStride + k] - mins[k]) * scale;
+        }
+    }
+
+    // Vertices sharing a position are on a seam. Moving them would tear it.
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&p](uint32_t a, uint32_t b) {
+            return std::lexicographical_compare(&p[a * 3], &p[a * 3 + 3], &p[b * 3], &p[b * 3 + 3]);
+        });
+        for (size_t i = 1; i < vertexCount; ++i) {
+            if (std::equal(&p[order[i] * 3], &p[order[i] * 3 + 3], &p[order[i - 1] * 3])) {
+                locked[order[i]] = locked[order[i - 1]] = 1;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    memset(quadrics.data(), 0, sizeof(Quadric) * vertexCount);
+
+    std::vector<uint64_t> directedEdges;
+    directedEdges.reserve(indexCount);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            directedEdges.push_back(EdgeKey(out[i + k], out[i + (k + 1) % 3]));
+        }
+    }
+    std::sort(directedEdges.begin(), directedEdges.end());
+
+    for (size_t i = 0; i < indexCount; i += 3) {
+        const uint32_t v[3] = { out[i], out[i + 1], out[i + 2] };
+        double n[3];
+        Cross(&p[v[0] * 3], &p[v[1] * 3], &p[v[2] * 3], n);
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+
+        const float * p0 = &p[v[0] * 3];
+        const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        const double area = length * 0.5;
+        for (int k = 0; k < 3; ++k) {
+            AddPlane(quadrics[v[k]], n, d, area, true);
+        }
+
+        // An edge without the reverse edge is on a border. Add a plane perpendicular to the triangle.
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = v[k];
+            const uint32_t b = v[(k + 1) % 3];
+            if (std::binary_search(directedEdges.begin(), directedEdges.end(), EdgeKey(b, a))) {
+                continue;
+            }
+            const double e[3] = { p[b * 3] - p[a * 3], p[b * 3 + 1] - p[a * 3 + 1], p[b * 3 + 2] - p[a * 3 + 2] };
+            double m[3] = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0] };
+            const double edgeLength = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+            if (edgeLength == 0.0) {
+                continue;
+            }
+            m[0] /= edgeLength;
+            m[1] /= edgeLength;
+            m[2] /= edgeLength;
+            const double md = -(m[0] * p[a * 3] + m[1] * p[a * 3 + 1] + m[2] * p[a * 3 + 2]);
+            AddPlane(quadrics[a], m, md, BORDER_WEIGHT * edgeLength * edgeLength, false);
+            AddPlane(quadrics[b], m, md, BORDER_WEIGHT * edgeLength * edgeLength, false);
+        }
+    }
+
+    const double maxCost = static_cast<double>(maxError) * maxError;
+    double reached = 0.0;
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint64_t> edges;
+    std::vector<Collapse> collapses;
+
+    // Each pass collapses independent edges in the order of cost.
+    while (out.size() > targetIndexCount) {
+        const size_t triangleCount = out.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (size_t i = 0; i < out.size(); ++i) {
+            adjacencyOffsets[out[i] + 1]++;
+        }
+        for (size_t i = 0; i < vertexCount; ++i) {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+        adjacency.resize(out.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < out.size(); ++i) {
+                adjacency[fill[out[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        edges.clear();
+        for (size_t i = 0; i < out.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t a = out[i + k];
+                const uint32_t b = out[i + (k + 1) % 3];
+                edges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (size_t i = 0; i < edges.size(); ++i) {
+            const uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+            const uint32_t b = static_cast<uint32_t>(edges[i]);
+            Quadric q = quadrics[a];
+            AddQuadric(q, quadrics[b]);
+
+            const double costAB = locked[a] ? DBL_MAX : Evaluate(q, &p[b * 3]);
+            const double costBA = locked[b] ? DBL_MAX : Evaluate(q, &p[a * 3]);
+            if (costAB == DBL_MAX && costBA == DBL_MAX) {
+                continue;
+            }
+
+            Collapse collapse;
+            collapse.from = costAB <= costBA ? a : b;
+            collapse.to = costAB <= costBA ? b : a;
+            collapse.cost = std::min(costAB, costBA);
+            if (collapse.cost <= maxCost) {
+                collapses.push_back(collapse);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        for (size_t i = 0; i < vertexCount; ++i) {
+            remap[i] = static_cast<uint32_t>(i);
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        const size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+        size_t removed = 0;
+        size_t collapsed = 0;
+        for (size_t c = 0; c < collapses.size() && removed < trianglesToRemove; ++c) {
+            const Collapse & collapse = collapses[c];
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Reject the collapse if a remaining triangle around the vertex flips.
+            bool flips = false;
+            size_t shared = 0;
+            for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1] && !flips; ++j) {
+                const uint32_t * t = &out[adjacency[j] * 3];
+                if (t[0] == collapse.to || t[1] == collapse.to || t[2] == collapse.to) {
+                    shared++;
+                    continue;
+                }
+                double before[3], after[3];
+                Cross(&p[t[0] * 3], &p[t[1] * 3], &p[t[2] * 3], before);
+                const float * q[3];
+                for (int k = 0; k < 3; ++k) {
+                    q[k] = &p[(t[k] == collapse.from ? collapse.to : t[k]) * 3];
+                }
+                Cross(q[0], q[1], q[2], after);
+                flips = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0;
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+            // Triangles around the vertex change, so their vertices wait for the next pass.
+            for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; ++j) {
+                const uint32_t * t = &out[adjacency[j] * 3];
+                touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+            }
+
+            reached = std::max(reached, collapse.cost);
+            removed += shared;
+            collapsed++;
+        }
+
+        if (collapsed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < out.size(); i += 3) {
+            const uint32_t a = remap[out[i]];
+            const uint32_t b = remap[out[i + 1]];
+            const uint32_t c = remap[out[i + 2]];
+            if (a != b && b != c && c != a) {
+                out[write++] = a;
+                out[write++] = b;
+                out[write++] = c;
+            }
+        }
+        out.resize(write);
+    }
+
+    return static_cast<float>(std::sqrt(reached));
+}
+
+}
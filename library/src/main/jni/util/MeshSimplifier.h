@@ -0,0 +1,47 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MeshOptimizer.h"
+/***************************************************************************
+ * Mesh simplification for LOD chains. Shared by the runtime and
+ * tools/meshconv, so this file must not depend on includes.h, OVR or
+ * Android headers.
+ ***************************************************************************/
+
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace mgn {
+
+/**
+ * Reduces triangles toward targetIndexCount by edge collapses ordered by
+ * quadric error (Garland and Heckbert). A vertex is only moved onto one of
+ * its neighbours, so the result indexes the same vertex buffer and LODs can
+ * share it. Vertices which share a position with another vertex (UV or
+ * color seams) stay where they are, and borders are kept by extra planes.
+ *
+ * maxError is relative to the size of the mesh, e.g. 0.01 allows 1% of the
+ * largest bounding box extent. Returns the error reached in the same unit.
+ */
+float SimplifyMesh(const uint32_t * indices, size_t indexCount,
+        const float * positions, size_t positionStride, size_t vertexCount,
+        size_t targetIndexCount, float maxError, std::vector<uint32_t> & out);
+
+}
+#endif
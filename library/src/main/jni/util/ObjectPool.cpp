@@ -0,0 +1,185 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ObjectPool.h"
+
+#include <stdlib.h>
+
+namespace mgn {
+
+static ObjectPool * pools[POOL_TYPE_COUNT];
+
+static inline size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+ObjectPool::ObjectPool(PoolType type, size_t objectSize) :
+        type(type),
+        slotSize(AlignUp(std::max(objectSize, sizeof(Slot)), 16)),
+        slotsPerSlab((SLAB_BYTES - SLAB_HEADER_BYTES) / AlignUp(std::max(objectSize, sizeof(Slot)), 16)),
+        partialSlabs(nullptr),
+        spareSlab(nullptr),
+        slabCount(0),
+        liveCount(0) {
+    pthread_mutex_init(&mutex, 0);
+    pools[type] = this;
+}
+
+ObjectPool::~ObjectPool() {
+    // Slabs still holding live objects are left to the process teardown.
+    Trim();
+    pools[type] = nullptr;
+    pthread_mutex_destroy(&mutex);
+}
+
+ObjectPool * ObjectPool::Get(PoolType type) {
+    return type >= 0 && type < POOL_TYPE_COUNT ? pools[type] : nullptr;
+}
+
+void * ObjectPool::Allocate(size_t size) {
+    if (size > slotSize || slotsPerSlab == 0) {
+        return ::operator new(size);
+    }
+
+    lock();
+
+    Slab * slab = partialSlabs;
+    if (slab == nullptr) {
+        if (spareSlab != nullptr) {
+            slab = spareSlab;
+            spareSlab = nullptr;
+        } else {
+            slab = NewSlab();
+            if (slab == nullptr) {
+                unlock();
+                throw std::bad_alloc();
+            }
+        }
+        Link(slab);
+    }
+
+    Slot * slot = slab->freeSlots;
+    slab->freeSlots = slot->next;
+    slab->liveCount++;
+    liveCount++;
+
+    // Full slabs are not searched by later allocations.
+    if (slab->freeSlots == nullptr) {
+        Unlink(slab);
+    }
+
+    unlock();
+    return slot;
+}
+
+void ObjectPool::Free(void * p, size_t size) {
+    if (p == nullptr) {
+        return;
+    }
+
+    if (size > slotSize || slotsPerSlab == 0) {
+        ::operator delete(p);
+        return;
+    }
+
+    lock();
+
+    Slab * slab = reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(SLAB_BYTES - 1));
+    Slot * slot = reinterpret_cast<Slot*>(p);
+
+    const bool wasFull = slab->freeSlots == nullptr;
+    slot->next = slab->freeSlots;
+    slab->freeSlots = slot;
+    slab->liveCount--;
+    liveCount--;
+
+    if (slab->liveCount == 0) {
+        if (!wasFull) {
+            Unlink(slab);
+        }
+        if (spareSlab == nullptr) {
+            spareSlab = slab;
+        } else {
+            ReleaseSlab(slab);
+        }
+    } else if (wasFull) {
+        Link(slab);
+    }
+
+    unlock();
+}
+
+void ObjectPool::Trim() {
+    lock();
+    if (spareSlab != nullptr) {
+        ReleaseSlab(spareSlab);
+        spareSlab = nullptr;
+    }
+    unlock();
+}
+
+ObjectPool::Slab * ObjectPool::NewSlab() {
+    void * memory = nullptr;
+    if (posix_memalign(&memory, SLAB_BYTES, SLAB_BYTES) != 0) {
+        return nullptr;
+    }
+
+    Slab * slab = reinterpret_cast<Slab*>(memory);
+    slab->prev = nullptr;
+    slab->next = nullptr;
+    slab->liveCount = 0;
+    slab->freeSlots = nullptr;
+
+    // Thread the free list so that slots are handed out in address order.
+    char * first = reinterpret_cast<char*>(memory) + SLAB_HEADER_BYTES;
+    for (size_t i = slotsPerSlab; i > 0; --i) {
+        Slot * slot = reinterpret_cast<Slot*>(first + (i - 1) * slotSize);
+        slot->next = slab->freeSlots;
+        slab->freeSlots = slot;
+    }
+
+    slabCount++;
+    return slab;
+}
+
+void ObjectPool::ReleaseSlab(Slab * slab) {
+    free(slab);
+    slabCount--;
+}
+
+void ObjectPool::Link(Slab * slab) {
+    slab->prev = nullptr;
+    slab->next = partialSlabs;
+    if (partialSlabs != nullptr) {
+        partialSlabs->prev = slab;
+    }
+    partialSlabs = slab;
+}
+
+void ObjectPool::Unlink(Slab * slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        partialSlabs = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    }
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
+
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Slab allocator for native objects of one type.
+ ***************************************************************************/
+
+#ifndef OBJECT_POOL_H_
+#define OBJECT_POOL_H_
+
+#include <pthread.h>
+
+namespace mgn {
+
+enum PoolType {
+    POOL_SCENE_OBJECT = 0,
+    POOL_RENDER_DATA,
+    POOL_MESH,
+    POOL_MATERIAL,
+    POOL_TYPE_COUNT
+};
+
+/**
+ * Objects are packed into fixed size slabs. Freed slots are recycled and a slab
+ * goes back to the heap as soon as all of its slots are free, so tearing down a
+ * scene releases whole slabs. Addresses never move while the object is alive.
+ */
+class ObjectPool {
+public:
+    ObjectPool(PoolType type, size_t objectSize);
+    ~ObjectPool();
+
+    void * Allocate(size_t size);
+    void Free(void * p, size_t size);
+
+    // Release the spare empty slab kept to avoid thrashing.
+    void Trim();
+
+    size_t GetLiveCount() const {
+        return liveCount;
+    }
+
+    size_t GetLiveBytes() const {
+        return liveCount * slotSize;
+    }
+
+    size_t GetReservedBytes() const {
+        return slabCount * SLAB_BYTES;
+    }
+
+    size_t GetSlabCount() const {
+        return slabCount;
+    }
+
+    static ObjectPool * Get(PoolType type);
+
+private:
+    ObjectPool(const ObjectPool& pool);
+    ObjectPool(ObjectPool&& pool);
+    ObjectPool& operator=(const ObjectPool& pool);
+    ObjectPool& operator=(ObjectPool&& pool);
+
+    struct Slot {
+        Slot * next;
+    };
+
+    struct Slab {
+        Slab * prev;
+        Slab * next;
+        Slot * freeSlots;
+        size_t liveCount;
+    };
+
+    // Slabs are aligned to their size, so the owning slab of a slot is found by masking.
+    static const size_t SLAB_BYTES = 64 * 1024;
+    static const size_t SLAB_HEADER_BYTES = 64;
+
+    Slab * NewSlab();
+    void ReleaseSlab(Slab * slab);
+    void Link(Slab * slab);
+    void Unlink(Slab * slab);
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    const PoolType type;
+    const size_t slotSize;
+    const size_t slotsPerSlab;
+
+    Slab * partialSlabs; // slabs which have at least one free slot
+    Slab * spareSlab;    // one empty slab kept around
+    size_t slabCount;
+    size_t liveCount;
+};
+
+/**
+ * Give a class pooled operator new/delete. Derived classes that don't fit into
+ * the slot fall back to the global heap.
+ */
+template<typename T, PoolType Type>
+class Pooled {
+public:
+    static void * operator new(size_t size) {
+        return GetPool().Allocate(size);
+    }
+
+    static void operator delete(void * p, size_t size) {
+        GetPool().Free(p, size);
+    }
+
+    static ObjectPool & GetPool() {
+        static ObjectPool pool(Type, sizeof(T));
+        return pool;
+    }
+};
+
+}
+#endif
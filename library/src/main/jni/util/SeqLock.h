@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Lock-free handoff of a small value from one writer thread to readers.
+ ***************************************************************************/
+
+#ifndef SEQ_LOCK_H_
+#define SEQ_LOCK_H_
+
+#include <atomic>
+
+namespace mgn {
+
+/**
+ * Sequence lock. The writer never waits. Readers retry while a write is in
+ * progress, so they never see a torn value. T must be trivially copyable.
+ * Only one thread may write.
+ */
+template<typename T>
+class SeqLock {
+public:
+    SeqLock() : sequence(0), value() {
+    }
+
+    void Write(const T & v) {
+        const uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = v;
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    // Returns false if nothing has been written yet.
+    bool Read(T & out) const {
+        for (;;) {
+            const uint32_t s = sequence.load(std::memory_order_acquire);
+            if (s == 0) {
+                return false;
+            }
+            if (s & 1) {
+                continue;
+            }
+            out = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == s) {
+                return true;
+            }
+        }
+    }
+
+private:
+    SeqLock(const SeqLock& lock);
+    SeqLock& operator=(const SeqLock& lock);
+
+    std::atomic<uint32_t> sequence;
+    T value;
+};
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TransformStore.h"
+
+namespace mgn {
+
+TransformStore transform_store;
+
+TransformStore::TransformStore() :
+        chunkCount(0) {
+    pthread_mutex_init(&mutex, nullptr);
+    for (uint32_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i] = nullptr;
+    }
+}
+
+TransformStore::~TransformStore() {
+    for (uint32_t i = 0; i < chunkCount; ++i) {
+        delete[] chunks[i];
+    }
+    pthread_mutex_destroy(&mutex);
+}
+
+uint32_t TransformStore::Allocate() {
+    lock();
+
+    if (freeSlots.empty()) {
+        if (chunkCount == MAX_CHUNKS) {
+            unlock();
+            std::string error = "TransformStore::Allocate() : too many scene objects.";
+            throw error;
+        }
+
+        chunks[chunkCount] = new TransformSlot[CHUNK_SIZE];
+
+        // Pushed in reverse, so that slots are used from the head of the chunk.
+        for (uint32_t i = CHUNK_SIZE; i > 0; --i) {
+            freeSlots.push_back(chunkCount << CHUNK_SHIFT | (i - 1));
+        }
+        chunkCount++;
+    }
+
+    const uint32_t id = freeSlots.back();
+    freeSlots.pop_back();
+    unlock();
+
+    TransformSlot * slot = Get(id);
+    slot->position = Vector3f();
+    slot->padding = 0.0f;
+    slot->rotation = Quatf();
+    slot->scale = Vector3f(1.0f, 1.0f, 1.0f);
+    slot->dirty = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        slot->reserved[i] = 0.0f;
+    }
+    slot->matrixWorld = Matrix4f::Identity();
+    return id;
+}
+
+void TransformStore::Free(uint32_t id) {
+    lock();
+    freeSlots.push_back(id);
+    unlock();
+}
+
+}
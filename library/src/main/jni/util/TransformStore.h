@@ -0,0 +1,101 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Transforms of scene objects in memory shared with Java.
+ ***************************************************************************/
+
+#ifndef TRANSFORM_STORE_H_
+#define TRANSFORM_STORE_H_
+
+#include <pthread.h>
+#include <vector>
+
+using namespace OVR;
+
+namespace mgn {
+
+/**
+ * Transform of one scene object. Java reads and writes it through a direct
+ * buffer, so the layout is fixed and must match SceneObject.TRANSFORM_* in
+ * Java side. Offsets are in floats.
+ *
+ *   0 position x, y, z     4 rotation x, y, z, w     8 scale x, y, z
+ *  11 dirty                16 world matrix, row major
+ */
+struct TransformSlot {
+    Vector3f position;
+    float    padding;
+    Quatf    rotation;
+    Vector3f scale;
+    float    dirty;      // Set to non-zero by Java after it writes position, rotation or scale.
+    float    reserved[4];
+    Matrix4f matrixWorld;
+};
+
+static_assert(sizeof(TransformSlot) == 128, "TransformSlot layout is shared with Java");
+
+/**
+ * Slots are allocated in chunks which never move nor go back to the heap, so
+ * a Java buffer over a chunk stays valid. A slot id is (chunk << CHUNK_SHIFT | index).
+ */
+class TransformStore {
+public:
+    static const uint32_t CHUNK_SHIFT = 8;
+    static const uint32_t CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static const uint32_t MAX_CHUNKS = 1024;
+
+    TransformStore();
+    ~TransformStore();
+
+    // Can be called on any thread. The slot has the identity transform.
+    uint32_t Allocate();
+    void Free(uint32_t id);
+
+    TransformSlot * Get(uint32_t id) const {
+        return &chunks[id >> CHUNK_SHIFT][id & (CHUNK_SIZE - 1)];
+    }
+
+    // nullptr if the chunk is not allocated yet.
+    TransformSlot * GetChunk(uint32_t chunk) const {
+        return chunk < chunkCount ? chunks[chunk] : nullptr;
+    }
+
+private:
+    TransformStore(const TransformStore& store);
+    TransformStore(TransformStore&& store);
+    TransformStore& operator=(const TransformStore& store);
+    TransformStore& operator=(TransformStore&& store);
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    TransformSlot * chunks[MAX_CHUNKS];
+    uint32_t chunkCount;
+    std::vector<uint32_t> freeSlots;
+};
+
+extern TransformStore transform_store;
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Worker.h"
+
+#include <sys/prctl.h>
+
+namespace mgn {
+
+Worker worker("mgn-worker");
+
+static JavaVM * javaVM = nullptr;
+
+Worker::Worker(const char * name) :
+        name(name),
+        started(false),
+        stopping(false) {
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&cond, 0);
+}
+
+Worker::~Worker() {
+    lock();
+    stopping = true;
+    pthread_cond_signal(&cond);
+    const bool join = started;
+    unlock();
+
+    if (join) {
+        pthread_join(thread, nullptr);
+    }
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+void Worker::SetJavaVM(JavaVM * vm) {
+    javaVM = vm;
+}
+
+void Worker::Post(const Job & job) {
+    lock();
+    if (!started) {
+        if (pthread_create(&thread, nullptr, ThreadMain, this) != 0) {
+            unlock();
+            std::string error = "Worker::Post() : cannot start thread.";
+            throw error;
+        }
+        started = true;
+    }
+    jobs.push_back(job);
+    pthread_cond_signal(&cond);
+    unlock();
+}
+
+size_t Worker::GetPendingCount() {
+    lock();
+    const size_t count = jobs.size();
+    unlock();
+    return count;
+}
+
+void * Worker::ThreadMain(void * arg) {
+    Worker * self = static_cast<Worker*>(arg);
+    prctl(PR_SET_NAME, (unsigned long) self->name, 0, 0, 0);
+
+    JNIEnv * env = nullptr;
+    if (javaVM != nullptr) {
+        javaVM->AttachCurrentThread(&env, nullptr);
+    }
+
+    self->Run();
+
+    if (env != nullptr) {
+        javaVM->DetachCurrentThread();
+    }
+    return nullptr;
+}
+
+void Worker::Run() {
+    for (;;) {
+        lock();
+        while (jobs.empty() && !stopping) {
+            pthread_cond_wait(&cond, &mutex);
+        }
+        if (stopping) {
+            unlock();
+            return;
+        }
+        Job job;
+        job.swap(jobs.front());
+        jobs.pop_front();
+        unlock();
+
+        try {
+            job();
+        } catch (std::string error) {
+            __android_log_print(ANDROID_LOG_ERROR, "mgn", "Error detected in Worker::Run; error : %s", error.c_str());
+        }
+    }
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "includes.h"
+
+/***************************************************************************
+ * Background thread for CPU heavy jobs.
+ ***************************************************************************/
+
+#ifndef WORKER_H_
+#define WORKER_H_
+
+#include <deque>
+#include <functional>
+#include <pthread.h>
+
+namespace mgn {
+
+/**
+ * Runs jobs one by one on its own thread. The thread is started on the first
+ * Post() and attached to the JavaVM if one is given, so that jobs can
+ * release JNI references.
+ */
+class Worker {
+public:
+    typedef std::function<void()> Job;
+
+    explicit Worker(const char * name);
+    ~Worker();
+
+    void Post(const Job & job);
+
+    size_t GetPendingCount();
+
+    // Needed to attach the thread. Set when the activity is created.
+    static void SetJavaVM(JavaVM * vm);
+
+private:
+    Worker(const Worker& worker);
+    Worker& operator=(const Worker& worker);
+
+    static void * ThreadMain(void * arg);
+    void Run();
+
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    const char * name;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool started;
+    bool stopping;
+    std::deque<Job> jobs;
+};
+
+extern Worker worker;
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Mesh data in memory, before it is written as a mesh file.
+ ***************************************************************************/
+
+#ifndef MESH_DATA_H_
+#define MESH_DATA_H_
+
+#include <stdint.h>
+#include <vector>
+
+namespace mgn {
+
+struct MeshData {
+    std::vector<float>    positions; // x, y, z
+    std::vector<float>    uvs;       // u, v. Empty if the mesh has no UVs.
+    std::vector<uint8_t>  colors;    // r, g, b, a. Empty if the mesh has no colors.
+    std::vector<uint32_t> indices;   // 3 per triangle
+
+    size_t GetVertexCount() const {
+        return positions.size() / 3;
+    }
+};
+
+}
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshWriter.h"
+#include "MeshBounds.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace mgn {
+
+static inline uint16_t ToUnorm16(float value) {
+    return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+MeshWriter::MeshWriter() :
+        quantize(false) {
+    memset(&header, 0, sizeof(header));
+}
+
+void MeshWriter::AddLod(const MeshData & mesh, float error) {
+    if (lods.empty()) {
+        SetupHeader(mesh);
+    }
+    Lod lod = { &mesh, &mesh.indices, lods.empty() ? 0.0f : error };
+    lods.push_back(lod);
+}
+
+void MeshWriter::AddLodIndices(const std::vector<uint32_t> & indices, float error) {
+    Lod lod = { nullptr, &indices, error };
+    lods.push_back(lod);
+}
+
+void MeshWriter::SetupHeader(const MeshData & mesh) {
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+
+    bool uvInUnitRange = true;
+    for (size_t i = 0; i < mesh.uvs.size() && uvInUnitRange; ++i) {
+        uvInUnitRange = mesh.uvs[i] >= 0.0f && mesh.uvs[i] <= 1.0f;
+    }
+
+    // Position must be the first attribute. The loader finds quantized positions there.
+    uint32_t offset = 0;
+    MeshFileAttribute & position = header.attributes[header.attributeCount++];
+    position.location = MESH_FILE_POSITION;
+    position.size = 3;
+    position.type = quantize ? MESH_FILE_UNSIGNED_SHORT : MESH_FILE_FLOAT;
+    position.normalized = quantize ? 1 : 0;
+    position.offset = offset;
+    offset += quantize ? 8 : 12;
+
+    if (!mesh.uvs.empty()) {
+        const bool quantizeUvs = quantize && uvInUnitRange;
+        MeshFileAttribute & uv = header.attributes[header.attributeCount++];
+        uv.location = MESH_FILE_UV0;
+        uv.size = 2;
+        uv.type = quantizeUvs ? MESH_FILE_UNSIGNED_SHORT : MESH_FILE_FLOAT;
+        uv.normalized = quantizeUvs ? 1 : 0;
+        uv.offset = offset;
+        offset += quantizeUvs ? 4 : 8;
+    }
+
+    if (!mesh.colors.empty()) {
+        MeshFileAttribute & color = header.attributes[header.attributeCount++];
+        color.location = MESH_FILE_COLOR;
+        color.size = 4;
+        color.type = MESH_FILE_UNSIGNED_BYTE;
+        color.normalized = 1;
+        color.offset = offset;
+        offset += 4;
+    }
+
+    header.vertexStride = offset;
+
+    const float * positions = mesh.positions.empty() ? nullptr : &mesh.positions[0];
+    const size_t vertexCount = mesh.positions.size() / 3;
+    ComputeMinMax(positions, 3, vertexCount, header.boundsMin, header.boundsMax);
+    ComputeBoundingSphere(positions, 3, vertexCount, header.sphereCenter, header.sphereRadius);
+}
+
+void MeshWriter::AppendVertices(const MeshData & mesh, std::vector<uint8_t> & out) const {
+    const size_t count = mesh.GetVertexCount();
+    const size_t base = out.size();
+    out.resize(base + count * header.vertexStride);
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t * vertex = &out[base + i * header.vertexStride];
+        for (uint32_t a = 0; a < header.attributeCount; ++a) {
+            const MeshFileAttribute & attribute = header.attributes[a];
+            switch (attribute.location) {
+            case MESH_FILE_POSITION:
+                if (attribute.type == MESH_FILE_UNSIGNED_SHORT) {
+                    uint16_t q[4] = { 0, 0, 0, 0 };
+                    for (int k = 0; k < 3; ++k) {
+                        const float extent = header.boundsMax[k] - header.boundsMin[k];
+                        q[k] = extent > 0.0f ? ToUnorm16((mesh.positions[i * 3 + k] - header.boundsMin[k]) / extent) : 0;
+                    }
+                    memcpy(vertex + attribute.offset, q, 8);
+                } else {
+                    memcpy(vertex + attribute.offset, &mesh.positions[i * 3], 12);
+                }
+                break;
+            case MESH_FILE_UV0:
+                if (attribute.type == MESH_FILE_UNSIGNED_SHORT) {
+                    const uint16_t q[2] = { ToUnorm16(mesh.uvs[i * 2]), ToUnorm16(mesh.uvs[i * 2 + 1]) };
+                    memcpy(vertex + attribute.offset, q, 4);
+                } else {
+                    memcpy(vertex + attribute.offset, &mesh.uvs[i * 2], 8);
+                }
+                break;
+            case MESH_FILE_COLOR:
+                memcpy(vertex + attribute.offset, &mesh.colors[i * 4], 4);
+                break;
+            }
+        }
+    }
+}
+
+size_t MeshWriter::GetFileSize() const {
+    size_t size = MeshFileAlign(sizeof(MeshFileHeader));
+    for (size_t i = 0; i < lods.size(); ++i) {
+        const MeshData & mesh = lods[i].mesh != nullptr ? *lods[i].mesh : *lods[0].mesh;
+        const uint32_t indexType = mesh.GetVertexCount() > 0xffff ? MESH_FILE_UNSIGNED_INT : MESH_FILE_UNSIGNED_SHORT;
+        if (lods[i].mesh != nullptr) {
+            size += MeshFileAlign(mesh.GetVertexCount() * header.vertexStride);
+        }
+        size += MeshFileAlign(lods[i].indices->size() * MeshFileIndexSize(indexType));
+    }
+    return size;
+}
+
+bool MeshWriter::Write(const char * path, std::string & error) const {
+    if (lods.empty() || lods.size() > MESH_FILE_MAX_LODS || lods[0].mesh == nullptr) {
+        error = "1 to 8 LODs are required";
+        return false;
+    }
+
+    MeshFileHeader out = header;
+    out.lodCount = lods.size();
+
+    std::vector<uint8_t> body(MeshFileAlign(sizeof(MeshFileHeader)));
+
+    for (size_t i = 0; i < lods.size(); ++i) {
+        const bool sharesVertices = lods[i].mesh == nullptr;
+        const MeshData & mesh = sharesVertices ? *lods[0].mesh : *lods[i].mesh;
+        const std::vector<uint32_t> & indices = *lods[i].indices;
+        if (mesh.uvs.empty() != (lods[0].mesh->uvs.empty()) || mesh.colors.empty() != (lods[0].mesh->colors.empty())) {
+            error = "LODs have different attributes";
+            return false;
+        }
+
+        MeshFileLod & lod = out.lods[i];
+        lod.vertexCount = mesh.GetVertexCount();
+        lod.indexCount = indices.size();
+        lod.indexType = lod.vertexCount > 0xffff ? MESH_FILE_UNSIGNED_INT : MESH_FILE_UNSIGNED_SHORT;
+        lod.error = lods[i].error;
+
+        if (sharesVertices) {
+            lod.vertexOffset = out.lods[0].vertexOffset;
+        } else {
+            lod.vertexOffset = body.size();
+            AppendVertices(mesh, body);
+            body.resize(MeshFileAlign(body.size()));
+        }
+
+        lod.indexOffset = body.size();
+        if (lod.indexType == MESH_FILE_UNSIGNED_INT) {
+            body.resize(body.size() + lod.indexCount * 4);
+            memcpy(&body[lod.indexOffset], indices.data(), lod.indexCount * 4);
+        } else {
+            body.resize(body.size() + lod.indexCount * 2);
+            for (uint32_t k = 0; k < lod.indexCount; ++k) {
+                const uint16_t index = indices[k];
+                memcpy(&body[lod.indexOffset + k * 2], &index, 2);
+            }
+        }
+        body.resize(MeshFileAlign(body.size()));
+    }
+
+    out.fileSize = body.size();
+    memcpy(&body[0], &out, sizeof(out));
+
+    FILE * fp = fopen(path, "wb");
+    if (fp == nullptr) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+    const bool ok = fwrite(body.data(), 1, body.size(), fp) == body.size();
+    fclose(fp);
+    if (!ok) {
+        error = std::string("cannot write ") + path;
+    }
+    return ok;
+}
+
+}
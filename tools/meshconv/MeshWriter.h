@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Writes mesh files in the format defined by MeshFormat.h.
+ ***************************************************************************/
+
+#ifndef MESH_WRITER_H_
+#define MESH_WRITER_H_
+
+#include <string>
+
+#include "MeshData.h"
+#include "MeshFormat.h"
+
+namespace mgn {
+
+class MeshWriter {
+public:
+    MeshWriter();
+
+    /**
+     * Store positions as unorm16 in the bounding box and UVs as unorm16 if
+     * they are in [0, 1]. Must be called before AddLod().
+     */
+    void SetQuantize(bool quantize) {
+        this->quantize = quantize;
+    }
+
+    // LOD 0 decides the vertex layout and the bounds. Later LODs must have the same attributes.
+    void AddLod(const MeshData & mesh, float error);
+
+    // Adds a LOD which indexes the vertices of LOD 0. They are written only once.
+    void AddLodIndices(const std::vector<uint32_t> & indices, float error);
+
+    // Returns false with error message if the file cannot be written.
+    bool Write(const char * path, std::string & error) const;
+
+    size_t GetFileSize() const;
+
+private:
+    void SetupHeader(const MeshData & mesh);
+    void AppendVertices(const MeshData & mesh, std::vector<uint8_t> & out) const;
+
+    struct Lod {
+        const MeshData * mesh;              // nullptr if the LOD uses vertices of LOD 0
+        const std::vector<uint32_t> * indices;
+        float error;
+    };
+
+    bool quantize;
+    MeshFileHeader header;
+    std::vector<Lod> lods;
+};
+
+}
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2016 eje inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***************************************************************************
+ * Converts OBJ, glTF and other formats supported by assimp to mesh files.
+ ***************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <assimp/cimport.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshWriter.h"
+
+using namespace mgn;
+
+static void PrintUsage() {
+    fprintf(stderr,
+            "Usage: meshconv [options] input output.mgnm\n"
+            "  --colors    keep vertex colors (not used by the default shader)\n"
+            "  --lods N    add up to N - 1 simplified LODs, each with half the triangles\n"
+            "  --no-uvs    drop texture coordinates\n"
+            "  --overdraw  draw triangles facing outwards first\n"
+            "  --quantize  store positions and UVs as 16 bit integers\n");
+}
+
+// Copies per vertex elements of size components in the remapped order.
+template<typename T>
+static void RemapStream(std::vector<T> & stream, size_t components, const std::vector<uint32_t> & remap, size_t used) {
+    if (stream.empty()) {
+        return;
+    }
+    std::vector<T> out(used * components);
+    RemapVertices(stream.data(), out.data(), sizeof(T) * components, remap);
+    stream.swap(out);
+}
+
+// Reorders triangles for the vertex cache and vertices in fetch order. Unused vertices are dropped.
+static void Optimize(MeshData & mesh, bool overdraw) {
+    const size_t vertexCount = mesh.GetVertexCount();
+    uint32_t * indices = mesh.indices.data();
+    const size_t indexCount = mesh.indices.size();
+
+    const float before = ComputeAcmr(indices, indexCount, vertexCount);
+    OptimizeVertexCache(indices, indexCount, vertexCount);
+    if (overdraw) {
+        OptimizeOverdraw(indices, indexCount, mesh.positions.data(), 3, vertexCount);
+    }
+    const float after = ComputeAcmr(indices, indexCount, vertexCount);
+
+    std::vector<uint32_t> remap;
+    const size_t used = BuildVertexFetchRemap(indices, indexCount, vertexCount, remap);
+    RemapIndices(indices, indexCount, remap);
+    RemapStream(mesh.positions, 3, remap, used);
+    RemapStream(mesh.uvs, 2, remap, used);
+    RemapStream(mesh.colors, 4, remap, used);
+
+    printf("ACMR %.3f -> %.3f (cache size %d)\n", before, after, ACMR_CACHE_SIZE);
+}
+
+// Simplification stops at this error relative to the mesh size, or below this many triangles.
+static const float MAX_LOD_ERROR = 0.05f;
+static const size_t MIN_LOD_TRIANGLES = 64;
+
+// Builds LODs which index the vertices of the mesh. Errors add up since each LOD starts from the previous one.
+static void GenerateLods(const MeshData & mesh, int lodCount,
+        std::vector<std::vector<uint32_t> > & lods, std::vector<float> & errors) {
+    const std::vector<uint32_t> * previous = &mesh.indices;
+    float error = 0.0f;
+    lods.reserve(lodCount);
+
+    for (int level = 1; level < lodCount; ++level) {
+        const size_t target = previous->size() / 6 * 3;
+        if (target < MIN_LOD_TRIANGLES * 3) {
+            break;
+        }
+
+        std::vector<uint32_t> simplified;
+        error += SimplifyMesh(previous->data(), previous->size(), mesh.positions.data(), 3, mesh.GetVertexCount(),
+                target, MAX_LOD_ERROR, simplified);
+        if (simplified.empty() || simplified.size() > previous->size() * 3 / 4) {
+            break;
+        }
+        OptimizeVertexCache(simplified.data(), simplified.size(), mesh.GetVertexCount());
+
+        printf("LOD %d: %zu triangles, error %.4f\n", level, simplified.size() / 3, error);
+        lods.push_back(std::vector<uint32_t>());
+        lods.back().swap(simplified);
+        errors.push_back(error);
+        previous = &lods.back();
+    }
+}
+
+// Merges all triangles of the scene into one mesh. Node transforms are already applied.
+static bool Convert(const aiScene * scene, bool keepColors, bool keepUvs, MeshData & out) {
+    bool hasUvs = keepUvs;
+    bool hasColors = keepColors;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m) {
+        const aiMesh * mesh = scene->mMeshes[m];
+        if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE) {
+            continue;
+        }
+        hasUvs = hasUvs && mesh->HasTextureCoords(0);
+        hasColors = hasColors && mesh->HasVertexColors(0);
+    }
+
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m) {
+        const aiMesh * mesh = scene->mMeshes[m];
+        if (mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE) {
+            continue;
+        }
+
+        const uint32_t base = out.GetVertexCount();
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+            out.positions.push_back(mesh->mVertices[i].x);
+            out.positions.push_back(mesh->mVertices[i].y);
+            out.positions.push_back(mesh->mVertices[i].z);
+            if (hasUvs) {
+                out.uvs.push_back(mesh->mTextureCoords[0][i].x);
+                out.uvs.push_back(mesh->mTextureCoords[0][i].y);
+            }
+            if (hasColors) {
+                const aiColor4D & c = mesh->mColors[0][i];
+                out.colors.push_back(static_cast<uint8_t>(c.r * 255.0f + 0.5f));
+                out.colors.push_back(static_cast<uint8_t>(c.g * 255.0f + 0.5f));
+                out.colors.push_back(static_cast<uint8_t>(c.b * 255.0f + 0.5f));
+                out.colors.push_back(static_cast<uint8_t>(c.a * 255.0f + 0.5f));
+            }
+        }
+
+        for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
+            const aiFace & face = mesh->mFaces[f];
+            for (unsigned int k = 0; k < 3; ++k) {
+                out.indices.push_back(base + face.mIndices[k]);
+            }
+        }
+    }
+
+    return !out.indices.empty();
+}
+
+int main(int argc, char * argv[]) {
+    bool keepColors = false;
+    bool keepUvs = true;
+    bool quantize = false;
+    bool overdraw = false;
+    int lodCount = 1;
+    const char * input = nullptr;
+    const char * output = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--colors") == 0) {
+            keepColors = true;
+        } else if (strcmp(argv[i], "--no-uvs") == 0) {
+            keepUvs = false;
+        } else if (strcmp(argv[i], "--lods") == 0 && i + 1 < argc) {
+            lodCount = atoi(argv[++i]);
+            if (lodCount < 1 || lodCount > (int) MESH_FILE_MAX_LODS) {
+                fprintf(stderr, "meshconv: --lods must be 1 to %u\n", MESH_FILE_MAX_LODS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--overdraw") == 0) {
+            overdraw = true;
+        } else if (strcmp(argv[i], "--quantize") == 0) {
+            quantize = true;
+        } else if (input == nullptr) {
+            input = argv[i];
+        } else if (output == nullptr) {
+            output = argv[i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (input == nullptr || output == nullptr) {
+        PrintUsage();
+        return 1;
+    }
+
+    // UVs are flipped so that v = 0 is the top of the texture, same as Mesh.buildQuad().
+    const aiScene * scene = aiImportFile(input,
+            aiProcess_Triangulate
+            | aiProcess_JoinIdenticalVertices
+            | aiProcess_PreTransformVertices
+            | aiProcess_SortByPType
+            | aiProcess_FlipUVs);
+    if (scene == nullptr) {
+        fprintf(stderr, "meshconv: %s\n", aiGetErrorString());
+        return 1;
+    }
+
+    MeshData mesh;
+    const bool converted = Convert(scene, keepColors, keepUvs, mesh);
+    aiReleaseImport(scene);
+
+    if (!converted) {
+        fprintf(stderr, "meshconv: %s has no triangles\n", input);
+        return 1;
+    }
+
+    Optimize(mesh, overdraw);
+
+    std::vector<std::vector<uint32_t> > lods;
+    std::vector<float> errors;
+    GenerateLods(mesh, lodCount, lods, errors);
+
+    MeshWriter writer;
+    writer.SetQuantize(quantize);
+    writer.AddLod(mesh, 0.0f);
+    for (size_t i = 0; i < lods.size(); ++i) {
+        writer.AddLodIndices(lods[i], errors[i]);
+    }
+
+    std::string error;
+    if (!writer.Write(output, error)) {
+        fprintf(stderr, "meshconv: %s\n", error.c_str());
+        return 1;
+    }
+
+    printf("%s: %zu vertices, %zu triangles, %zu bytes\n", output,
+            mesh.GetVertexCount(), mesh.indices.size() / 3, writer.GetFileSize());
+    return 0;
+}